@@ -38,6 +38,70 @@ public:
     std::string getSTMFilePath() const { return getMemoryDir() + "/stm.bin"; }
     std::string getLTMFilePath() const { return getMemoryDir() + "/ltm.bin"; }
     
+    // Топология нейронного поля (число групп × нейронов в группе)
+    void setFieldTopology(int num_groups, int group_size) {
+        num_groups_ = num_groups;
+        group_size_ = group_size;
+    }
+    int getNumGroups() const { return num_groups_; }
+    int getGroupSize() const { return group_size_; }
+    
+    // Потоки для пофазной обработки групп (0 — по числу ядер)
+    void setWorkerThreads(int threads) { worker_threads_ = threads; }
+    int getWorkerThreads() const { return worker_threads_; }
+    
+    // Формат межгрупповых весов: "auto" / "sparse" / "dense"
+    void setInterWeightStorage(const std::string& storage) { inter_weight_storage_ = storage; }
+    const std::string& getInterWeightStorage() const { return inter_weight_storage_; }
+    
+    // Активностный STDP: "off" / "low_activity" (IDLE и SLEEP) / "always"
+    void setStdpGating(const std::string& gating) { stdp_gating_ = gating; }
+    const std::string& getStdpGating() const { return stdp_gating_; }
+    
+    // Очередь команд потока поля: ёмкость и с какого числа шагов в пакете их сливать
+    void setSimulationQueue(int capacity, int coalesce_threshold) {
+        sim_queue_capacity_ = capacity;
+        sim_coalesce_threshold_ = coalesce_threshold;
+    }
+    int getSimulationQueueCapacity() const { return sim_queue_capacity_; }
+    int getSimulationCoalesceThreshold() const { return sim_coalesce_threshold_; }
+    
+    // HTTP-сервер: обработчики, лимит соединений, таймаут простоя keep-alive
+    void setHttpServer(int workers, int max_connections, int idle_timeout_ms) {
+        http_workers_ = workers;
+        http_max_connections_ = max_connections;
+        http_idle_timeout_ms_ = idle_timeout_ms;
+    }
+    int getHttpWorkers() const { return http_workers_; }
+    int getHttpMaxConnections() const { return http_max_connections_; }
+    int getHttpIdleTimeoutMs() const { return http_idle_timeout_ms_; }
+    
+    // Наибольшее тело запроса (после снятия chunked); больше — 413
+    void setHttpMaxBodyBytes(size_t bytes) { http_max_body_bytes_ = bytes; }
+    size_t getHttpMaxBodyBytes() const { return http_max_body_bytes_; }
+    
+    // Реестр агентов: отложенная запись agents.json раз в interval_ms или по числу изменений
+    void setRegistryFlush(bool write_behind, int interval_ms, int threshold) {
+        registry_write_behind_ = write_behind;
+        registry_flush_interval_ms_ = interval_ms;
+        registry_flush_threshold_ = threshold;
+    }
+    bool getRegistryWriteBehind() const { return registry_write_behind_; }
+    int getRegistryFlushIntervalMs() const { return registry_flush_interval_ms_; }
+    int getRegistryFlushThreshold() const { return registry_flush_threshold_; }
+    
+    // Журнал сырых действий: групповая запись раз в commit_interval_ms, fsync "none"/"commit"/"interval"
+    void setRawLog(const std::string& fsync, int fsync_interval_ms, int commit_interval_ms, int segment_mb) {
+        raw_log_fsync_ = fsync;
+        raw_log_fsync_interval_ms_ = fsync_interval_ms;
+        raw_log_commit_interval_ms_ = commit_interval_ms;
+        raw_log_segment_mb_ = segment_mb;
+    }
+    const std::string& getRawLogFsync() const { return raw_log_fsync_; }
+    int getRawLogFsyncIntervalMs() const { return raw_log_fsync_interval_ms_; }
+    int getRawLogCommitIntervalMs() const { return raw_log_commit_interval_ms_; }
+    int getRawLogSegmentMb() const { return raw_log_segment_mb_; }
+    
     // Получить список активных ограничений из конфига
     std::vector<std::string> getConstraints() const {
         std::vector<std::string> active;
@@ -59,6 +123,34 @@ public:
             
             if (j.contains("working_directory")) working_dir_ = j["working_directory"];
             if (j.contains("model_path")) model_path_ = j["model_path"];
+            if (j.contains("topology")) {
+                num_groups_ = j["topology"].value("num_groups", num_groups_);
+                group_size_ = j["topology"].value("group_size", group_size_);
+            }
+            if (j.contains("worker_threads")) worker_threads_ = j["worker_threads"];
+            if (j.contains("inter_weight_storage")) inter_weight_storage_ = j["inter_weight_storage"];
+            if (j.contains("stdp_gating")) stdp_gating_ = j["stdp_gating"];
+            if (j.contains("simulation")) {
+                sim_queue_capacity_ = j["simulation"].value("queue_capacity", sim_queue_capacity_);
+                sim_coalesce_threshold_ = j["simulation"].value("coalesce_threshold", sim_coalesce_threshold_);
+            }
+            if (j.contains("http")) {
+                http_workers_ = j["http"].value("workers", http_workers_);
+                http_max_connections_ = j["http"].value("max_connections", http_max_connections_);
+                http_idle_timeout_ms_ = j["http"].value("idle_timeout_ms", http_idle_timeout_ms_);
+                http_max_body_bytes_ = j["http"].value("max_body_bytes", http_max_body_bytes_);
+            }
+            if (j.contains("registry")) {
+                registry_write_behind_ = j["registry"].value("write_behind", registry_write_behind_);
+                registry_flush_interval_ms_ = j["registry"].value("flush_interval_ms", registry_flush_interval_ms_);
+                registry_flush_threshold_ = j["registry"].value("flush_threshold", registry_flush_threshold_);
+            }
+            if (j.contains("raw_log")) {
+                raw_log_fsync_ = j["raw_log"].value("fsync", raw_log_fsync_);
+                raw_log_fsync_interval_ms_ = j["raw_log"].value("fsync_interval_ms", raw_log_fsync_interval_ms_);
+                raw_log_commit_interval_ms_ = j["raw_log"].value("commit_interval_ms", raw_log_commit_interval_ms_);
+                raw_log_segment_mb_ = j["raw_log"].value("segment_mb", raw_log_segment_mb_);
+            }
             if (j.contains("constraints")) {
                 for (auto& [key, value] : j["constraints"].items()) {
                     constraints_[key] = value.get<bool>();
@@ -81,6 +173,23 @@ public:
         nlohmann::json j;
         j["working_directory"] = working_dir_;
         j["model_path"] = model_path_;
+        j["topology"] = {{"num_groups", num_groups_}, {"group_size", group_size_}};
+        j["worker_threads"] = worker_threads_;
+        j["inter_weight_storage"] = inter_weight_storage_;
+        j["stdp_gating"] = stdp_gating_;
+        j["simulation"] = {{"queue_capacity", sim_queue_capacity_},
+                           {"coalesce_threshold", sim_coalesce_threshold_}};
+        j["http"] = {{"workers", http_workers_},
+                     {"max_connections", http_max_connections_},
+                     {"idle_timeout_ms", http_idle_timeout_ms_},
+                     {"max_body_bytes", http_max_body_bytes_}};
+        j["registry"] = {{"write_behind", registry_write_behind_},
+                         {"flush_interval_ms", registry_flush_interval_ms_},
+                         {"flush_threshold", registry_flush_threshold_}};
+        j["raw_log"] = {{"fsync", raw_log_fsync_},
+                        {"fsync_interval_ms", raw_log_fsync_interval_ms_},
+                        {"commit_interval_ms", raw_log_commit_interval_ms_},
+                        {"segment_mb", raw_log_segment_mb_}};
         j["constraints"] = constraints_;
         
         file << j.dump(4);
@@ -101,6 +210,24 @@ public:
     void resetToDefault() {
         working_dir_ = "agent_workspace";
         model_path_ = "models/Phi-3-mini-4k-instruct-q4.gguf";
+        num_groups_ = 32;
+        group_size_ = 32;
+        worker_threads_ = 0;
+        inter_weight_storage_ = "auto";
+        stdp_gating_ = "off";
+        sim_queue_capacity_ = 256;
+        sim_coalesce_threshold_ = 4;
+        http_workers_ = 4;
+        http_max_connections_ = 1024;
+        http_idle_timeout_ms_ = 30000;
+        http_max_body_bytes_ = 1 << 20;
+        registry_write_behind_ = true;
+        registry_flush_interval_ms_ = 1000;
+        registry_flush_threshold_ = 256;
+        raw_log_fsync_ = "interval";
+        raw_log_fsync_interval_ms_ = 1000;
+        raw_log_commit_interval_ms_ = 10;
+        raw_log_segment_mb_ = 64;
         constraints_.clear();
         constraints_["confidence_50"] = true;
         constraints_["max_steps_per_second"] = false;
@@ -121,5 +248,23 @@ private:
     
     std::string working_dir_;
     std::string model_path_;
+    int num_groups_ = 32;
+    int group_size_ = 32;
+    int worker_threads_ = 0;
+    std::string inter_weight_storage_ = "auto";
+    std::string stdp_gating_ = "off";
+    int sim_queue_capacity_ = 256;
+    int sim_coalesce_threshold_ = 4;
+    int http_workers_ = 4;
+    int http_max_connections_ = 1024;
+    int http_idle_timeout_ms_ = 30000;
+    size_t http_max_body_bytes_ = 1 << 20;
+    bool registry_write_behind_ = true;
+    int registry_flush_interval_ms_ = 1000;
+    int registry_flush_threshold_ = 256;
+    std::string raw_log_fsync_ = "interval";
+    int raw_log_fsync_interval_ms_ = 1000;
+    int raw_log_commit_interval_ms_ = 10;
+    int raw_log_segment_mb_ = 64;
     std::unordered_map<std::string, bool> constraints_;
 };
\ No newline at end of file
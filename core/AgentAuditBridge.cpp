@@ -1,5 +1,8 @@
 #include "AgentAuditBridge.hpp"
 #include "NeuralFieldSystem.hpp"
+#include "SimulationLoop.hpp"
+#include "MemorySnapshot.hpp"
+#include "AtomicFile.hpp"
 #include <cmath>
 #include <algorithm>
 #include <numeric>
@@ -13,7 +16,12 @@
 #include <atomic>
 #include <filesystem>
 #include <ctime> 
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 
 std::atomic<int> AgentAuditBridge::action_id_counter_{0};
 
@@ -21,20 +29,89 @@ std::atomic<int> AgentAuditBridge::action_id_counter_{0};
 // КОНСТРУКТОР LOGGER
 // ============================================================================
 
-AggregatedLogger::AggregatedLogger(const std::string& raw_logs_dir, const std::string& aggregated_dir)
-    : raw_logs_dir_(raw_logs_dir), aggregated_dir_(aggregated_dir) {
+namespace {
+    // Обрезает сегмент по последний '\n': недописанная при сбое строка иначе
+    // склеилась бы с первой записью нового запуска. Возвращает новый размер.
+    off_t truncateTornTail(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd < 0) return -1;
+        
+        struct stat st {};
+        off_t end = (::fstat(fd, &st) == 0) ? st.st_size : -1;
+        char buf[4096];
+        off_t keep = 0;
+        for (off_t pos = end; pos > 0 && keep == 0;) {
+            const off_t chunk = std::min<off_t>(pos, sizeof(buf));
+            pos -= chunk;
+            if (::pread(fd, buf, static_cast<size_t>(chunk), pos) != chunk) {
+                keep = end;     // не прочитали — файл не трогаем
+                break;
+            }
+            for (off_t i = chunk; i > 0; --i) {
+                if (buf[i - 1] == '\n') {
+                    keep = pos + i;
+                    break;
+                }
+            }
+        }
+        if (end > keep) {
+            std::cerr << "[AggregatedLogger] Dropping " << (end - keep) << " bytes of torn tail in " << path << std::endl;
+            if (::ftruncate(fd, keep) != 0) keep = end;
+        }
+        ::close(fd);
+        return keep;
+    }
+}
+
+AggregatedLogger::AggregatedLogger(const std::string& raw_logs_dir, const std::string& aggregated_dir,
+                                   const std::string& history_dir)
+    : raw_logs_dir_(raw_logs_dir), aggregated_dir_(aggregated_dir), history_(history_dir) {
     std::filesystem::create_directories(raw_logs_dir_);
     std::filesystem::create_directories(aggregated_dir_);
     
-    // Загружаем существующие агрегаты
-    for (const auto& period : {"5h", "12h", "24h", "week", "month", "year"}) {
-        current_aggregates_[period] = loadAggregate(period);
+    // Загружаем сохранённые свёртки
+    loadRollups();
+    
+    // Продолжаем последний сегмент прошлого запуска: имена сортируются по дате и номеру
+    std::string last_segment;
+    for (const auto& entry : std::filesystem::directory_iterator(raw_logs_dir_)) {
+        const std::string name = entry.path().filename().string();
+        if (entry.is_regular_file() && name.rfind("raw_", 0) == 0 &&
+            entry.path().extension() == ".log" && name > last_segment) {
+            last_segment = name;
+        }
+    }
+    if (!last_segment.empty()) {
+        const std::string stem = std::filesystem::path(last_segment).stem().string();
+        try {
+            segment_seq_ = std::stoull(stem.substr(stem.rfind('_') + 1));
+        } catch (...) {}
+        const std::string path = raw_logs_dir_ + "/" + last_segment;
+        const off_t size = truncateTornTail(path);
+        if (size >= 0 && static_cast<size_t>(size) < config_.segment_bytes) {
+            segment_path_ = path;
+        }
     }
+    
+    last_fsync_ = last_aggregate_save_ = std::chrono::steady_clock::now();
+    writer_ = std::thread([this]() { writerLoop(); });
 }
 
 AggregatedLogger::~AggregatedLogger() {
-    flushBuffer();
-    aggregate();
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        writer_stop_ = true;
+    }
+    writer_cv_.notify_one();
+    writer_.join();
+    
+    // Остаток очереди пишем здесь: производителей к этому моменту уже нет
+    commitPending(true);
+    {
+        std::lock_guard<std::mutex> lock(commit_mutex_);
+        closeSegment(false);
+    }
+    saveRollups();
 }
 
 // ============================================================================
@@ -45,144 +122,437 @@ AgentAuditBridge::AgentAuditBridge(NeuralFieldSystem& neural_system)
     : neural_system_(neural_system)
 {
     // Инициализация конфигурации по умолчанию
-    config_.blocked_actions = {
+    auto config = std::make_shared<Config>();
+    config->blocked_actions = {
         "delete_file", "rm", "drop_database", "shutdown", "reboot",
         "format", "chmod_777", "sudo", "eval", "exec"
     };
+    config_ = std::move(config);
+    constraints_ = std::make_shared<const AuditConstraintsConfig>();
+    
+    // Сессия по умолчанию — для действий без agent_id
+    auto state = states_.acquire("");
+    std::lock_guard<std::mutex> lock(state->mutex);
+    publishStatus("", *state, beginPass());
 }
 
 // ============================================================================
-// ЛОГИРОВАНИЕ
+// СОСТОЯНИЯ АГЕНТОВ
 // ============================================================================
 
-void AggregatedLogger::logRaw(const AgentAction& action, const AuditVerdict& verdict, float entropy, const std::string& response) {
-    std::lock_guard<std::mutex> lock(mutex_);
+namespace {
+    int64_t steadyMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+std::shared_ptr<AgentAuditState> AgentStateMap::acquire(const std::string& agent_id) {
+    Shard& shard = shardFor(agent_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
     
-    RawLogEntry entry;
-    entry.timestamp = std::chrono::system_clock::now();
-    entry.action = action;
-    entry.verdict = verdict;
-    entry.entropy = entropy;
-    entry.response = response;
+    auto it = shard.states.find(agent_id);
+    if (it != shard.states.end()) {
+        it->second->last_used_ms.store(steadyMs(), std::memory_order_relaxed);
+        return it->second;
+    }
     
-    raw_buffer_.push_back(entry);
+    if (shard.states.size() >= MAX_STATES_PER_SHARD) {
+        // Вытесняем дольше всех не использованное состояние
+        auto victim = shard.states.end();
+        int64_t oldest = 0;
+        for (auto s = shard.states.begin(); s != shard.states.end(); ++s) {
+            if (s->first.empty()) continue;
+            const int64_t used = s->second->last_used_ms.load(std::memory_order_relaxed);
+            if (victim == shard.states.end() || used < oldest) {
+                victim = s;
+                oldest = used;
+            }
+        }
+        if (victim != shard.states.end()) shard.states.erase(victim);
+    }
     
-    if (raw_buffer_.size() >= MAX_BUFFER_SIZE) {
-        flushBuffer();
+    auto state = std::make_shared<AgentAuditState>();
+    state->session.session_id = agent_id;
+    state->session.agent_name = agent_id;
+    state->session.start_time = std::chrono::system_clock::now();
+    state->last_used_ms.store(steadyMs(), std::memory_order_relaxed);
+    shard.states.emplace(agent_id, state);
+    return state;
+}
+
+std::shared_ptr<AgentAuditState> AgentStateMap::find(const std::string& agent_id) const {
+    Shard& shard = shardFor(agent_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.states.find(agent_id);
+    return it != shard.states.end() ? it->second : nullptr;
+}
+
+bool AgentStateMap::erase(const std::string& agent_id) {
+    Shard& shard = shardFor(agent_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.states.erase(agent_id) > 0;
+}
+
+size_t AgentStateMap::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.states.size();
     }
+    return total;
 }
 
-void AggregatedLogger::flushBuffer() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    // Сохраняем сырые логи в файл по дате
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    std::tm* tm = std::localtime(&time_t);
-    
-    std::ostringstream filename;
-    filename << raw_logs_dir_ << "/raw_" 
-             << std::put_time(tm, "%Y%m%d_%H%M%S") << ".json";
-    
-    nlohmann::json j;
-    for (const auto& entry : raw_buffer_) {
-        nlohmann::json entry_json;
-        entry_json["timestamp"] = std::chrono::system_clock::to_time_t(entry.timestamp);
-        entry_json["action_id"] = entry.action.action_id;
-        entry_json["action_type"] = entry.action.action;
-        entry_json["tool_name"] = entry.action.tool_name;
-        entry_json["hallucination_risk"] = entry.verdict.hallucination_risk;
-        entry_json["allowed"] = entry.verdict.allowed;
-        entry_json["entropy"] = entry.entropy;
-        entry_json["response"] = entry.response;
-        j.push_back(entry_json);
-    }
-    
-    std::ofstream file(filename.str());
-    if (file.is_open()) {
-        file << j.dump(4);
-    }
-    
-    // Обновляем агрегаты
-    for (auto& [period, stats] : current_aggregates_) {
-        for (const auto& entry : raw_buffer_) {
-            if (entry.timestamp >= stats.start_time && entry.timestamp <= stats.end_time) {
-                updateAggregate(stats, entry);
+std::vector<std::pair<std::string, std::shared_ptr<AgentAuditState>>> AgentStateMap::all() const {
+    std::vector<std::pair<std::string, std::shared_ptr<AgentAuditState>>> result;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        result.insert(result.end(), shard.states.begin(), shard.states.end());
+    }
+    return result;
+}
+
+// ============================================================================
+// ЛОГИРОВАНИЕ
+// ============================================================================
+
+void AggregatedLogger::logRaw(const AgentAction& action, const AuditVerdict& verdict, float entropy, const std::string& response) {
+    if (!reserveQueue(1)) return;
+    
+    QueueNode* node = new QueueNode;
+    node->entry.timestamp = std::chrono::system_clock::now();
+    node->entry.action = action;
+    node->entry.verdict = verdict;
+    node->entry.entropy = entropy;
+    node->entry.response = response;
+    pushChain(node, node);
+}
+
+void AggregatedLogger::logRawBatch(const std::vector<AgentAction>& actions, const std::vector<AuditVerdict>& verdicts, float entropy) {
+    const size_t n = std::min(actions.size(), verdicts.size());
+    if (n == 0 || !reserveQueue(n)) return;
+    
+    // Цепочка связывается от новых к старым, как её и оставил бы поэлементный push
+    const auto now = std::chrono::system_clock::now();
+    QueueNode* newest = nullptr;
+    QueueNode* oldest = nullptr;
+    for (size_t i = 0; i < n; ++i) {
+        QueueNode* node = new QueueNode;
+        node->entry.timestamp = now;
+        node->entry.action = actions[i];
+        node->entry.verdict = verdicts[i];
+        node->entry.entropy = entropy;
+        node->next = newest;
+        newest = node;
+        if (!oldest) oldest = node;
+    }
+    pushChain(newest, oldest);
+}
+
+bool AggregatedLogger::reserveQueue(size_t count) {
+    const size_t limit = max_queue_.load(std::memory_order_relaxed);
+    if (queued_.fetch_add(count, std::memory_order_relaxed) + count > limit) {
+        queued_.fetch_sub(count, std::memory_order_relaxed);
+        dropped_.fetch_add(count, std::memory_order_relaxed);
+        return false;
+    }
+    enqueued_.fetch_add(count, std::memory_order_relaxed);
+    return true;
+}
+
+void AggregatedLogger::pushChain(QueueNode* first, QueueNode* last) {
+    last->next = queue_head_.load(std::memory_order_relaxed);
+    while (!queue_head_.compare_exchange_weak(last->next, first,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+    }
+}
+
+void AggregatedLogger::flush() {
+    commitPending(true);
+}
+
+void AggregatedLogger::writerLoop() {
+    std::unique_lock<std::mutex> lock(writer_mutex_);
+    while (!writer_stop_) {
+        writer_cv_.wait_for(lock, std::chrono::milliseconds(config_.commit_interval_ms), [this]() {
+            return writer_stop_;
+        });
+        if (writer_stop_) break;
+        lock.unlock();
+        commitPending(false);
+        lock.lock();
+    }
+}
+
+void AggregatedLogger::commitPending(bool force_sync) {
+    const Config config = getConfig();
+    std::unique_lock<std::mutex> lock(commit_mutex_);
+    bool save_rollups = false;
+    
+    // Забираем очередь целиком; стек отдаёт записи от новых к старым
+    std::vector<QueueNode*> batch;
+    for (QueueNode* node = queue_head_.exchange(nullptr, std::memory_order_acquire); node; node = node->next) {
+        batch.push_back(node);
+    }
+    std::reverse(batch.begin(), batch.end());
+    queued_.fetch_sub(batch.size(), std::memory_order_relaxed);
+    
+    if (!batch.empty()) {
+        std::vector<std::string> lines;
+        lines.reserve(batch.size());
+        for (const QueueNode* node : batch) {
+            lines.push_back(formatEntry(node->entry));
+        }
+        
+        size_t begin = 0;
+        while (begin < lines.size()) {
+            if (segment_fd_ < 0 && !openSegment()) break;
+            
+            // Сколько строк влезает в сегмент; в пустой — хотя бы одна, даже длиннее лимита
+            size_t end = begin;
+            size_t size = segment_size_;
+            while (end < lines.size() && size + lines[end].size() <= config.segment_bytes) {
+                size += lines[end++].size();
             }
+            if (end == begin && segment_size_ == 0) ++end;
+            
+            if (end > begin) {
+                if (!writeLines(lines, begin, end)) {
+                    stats_.write_errors++;
+                    std::cerr << "[AggregatedLogger] Failed to write " << segment_path_ << ": " << std::strerror(errno) << std::endl;
+                    closeSegment(false);
+                    segment_path_.clear();
+                    break;
+                }
+                stats_.written += end - begin;
+                segment_dirty_ = true;
+                begin = end;
+            }
+            
+            // Ротация: следующий openSegment начнёт новый файл
+            if (begin < lines.size()) {
+                closeSegment(config.fsync != Config::NONE);
+                segment_path_.clear();
+            }
+        }
+        stats_.commits++;
+        
+        // Свёртки и история — только то, что попало в журнал; остаток пачки потерян
+        stats_.dropped += lines.size() - begin;
+        updateRollups(batch, begin);
+        appendHistory(batch, begin);
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_aggregate_save_ >= AGGREGATE_SAVE_INTERVAL) {
+            save_rollups = true;
+            last_aggregate_save_ = now;
+        }
+        // Без fsync число строк истории публикуется сразу (защита только от падения процесса)
+        if (config.fsync == Config::NONE) history_.sync(false);
+        for (QueueNode* node : batch) {
+            delete node;
         }
-        saveAggregate(period, stats);
     }
     
-    raw_buffer_.clear();
+    if (segment_fd_ >= 0 && segment_dirty_ && config.fsync != Config::NONE) {
+        const auto now = std::chrono::steady_clock::now();
+        if (force_sync || config.fsync == Config::COMMIT ||
+            now - last_fsync_ >= std::chrono::milliseconds(config.fsync_interval_ms)) {
+            ::fdatasync(segment_fd_);
+            history_.sync(true);
+            stats_.fsyncs++;
+            segment_dirty_ = false;
+            last_fsync_ = now;
+        }
+    }
+    
+    // rollups.json пишется после commit_mutex_: запись с fsync не держит статистику журнала
+    lock.unlock();
+    if (save_rollups) saveRollups();
 }
 
-void AggregatedLogger::updateAggregate(AggregatedStats& stats, const RawLogEntry& entry) {
-    stats.total_actions++;
-    if (entry.verdict.allowed) {
-        stats.successful_actions++;
-    } else {
-        stats.blocked_actions++;
+bool AggregatedLogger::openSegment() {
+    if (segment_path_.empty()) {
+        auto time_t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::tm* tm = std::localtime(&time_t);
+        
+        std::ostringstream filename;
+        filename << raw_logs_dir_ << "/raw_" << std::put_time(tm, "%Y%m%d_%H%M%S")
+                 << "_" << std::setw(6) << std::setfill('0') << ++segment_seq_ << ".log";
+        segment_path_ = filename.str();
+        stats_.segments++;
     }
     
-    stats.avg_hallucination_risk = (stats.avg_hallucination_risk * (stats.total_actions - 1) + entry.verdict.hallucination_risk) / stats.total_actions;
-    stats.max_hallucination_risk = std::max(stats.max_hallucination_risk, entry.verdict.hallucination_risk);
+    segment_fd_ = ::open(segment_path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (segment_fd_ < 0) {
+        stats_.write_errors++;
+        std::cerr << "[AggregatedLogger] Failed to open " << segment_path_ << ": " << std::strerror(errno) << std::endl;
+        segment_path_.clear();
+        return false;
+    }
     
-    stats.avg_entropy = (stats.avg_entropy * (stats.total_actions - 1) + entry.entropy) / stats.total_actions;
-    stats.min_entropy = std::min(stats.min_entropy, entry.entropy);
-    stats.max_entropy = std::max(stats.max_entropy, entry.entropy);
+    struct stat st {};
+    segment_size_ = (::fstat(segment_fd_, &st) == 0) ? static_cast<size_t>(st.st_size) : 0;
+    segment_dirty_ = false;
+    stats_.segment = segment_path_;
+    return true;
+}
+
+void AggregatedLogger::closeSegment(bool sync) {
+    if (segment_fd_ < 0) return;
+    if (sync && segment_dirty_) {
+        ::fdatasync(segment_fd_);
+        stats_.fsyncs++;
+    }
+    ::close(segment_fd_);
+    segment_fd_ = -1;
+    segment_size_ = 0;
+    segment_dirty_ = false;
+}
+
+bool AggregatedLogger::writeLines(const std::vector<std::string>& lines, size_t begin, size_t end) {
+    std::vector<iovec> iov;
+    iov.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+        iov.push_back({const_cast<char*>(lines[i].data()), lines[i].size()});
+    }
     
-    stats.actions_by_type[entry.action.action]++;
-    if (!entry.action.tool_name.empty()) {
-        stats.tool_usage[entry.action.tool_name]++;
+    size_t pos = 0;
+    while (pos < iov.size()) {
+        const int count = static_cast<int>(std::min<size_t>(iov.size() - pos, IOV_MAX));
+        ssize_t n = ::writev(segment_fd_, &iov[pos], count);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        
+        segment_size_ += static_cast<size_t>(n);
+        stats_.bytes += static_cast<uint64_t>(n);
+        
+        // Частичная запись: пропускаем записанные буферы, остаток дописываем следующим вызовом
+        size_t left = static_cast<size_t>(n);
+        while (pos < iov.size() && left >= iov[pos].iov_len) {
+            left -= iov[pos].iov_len;
+            ++pos;
+        }
+        if (left > 0) {
+            iov[pos].iov_base = static_cast<char*>(iov[pos].iov_base) + left;
+            iov[pos].iov_len -= left;
+        }
     }
+    return true;
+}
+
+std::string AggregatedLogger::formatEntry(const RawLogEntry& entry) {
+    nlohmann::json entry_json;
+    entry_json["timestamp"] = std::chrono::system_clock::to_time_t(entry.timestamp);
+    entry_json["agent_id"] = entry.action.agent_id;
+    entry_json["action_id"] = entry.action.action_id;
+    entry_json["action_type"] = entry.action.action;
+    entry_json["tool_name"] = entry.action.tool_name;
+    entry_json["hallucination_risk"] = entry.verdict.hallucination_risk;
+    entry_json["allowed"] = entry.verdict.allowed;
+    entry_json["reason"] = entry.verdict.reason;
+    entry_json["entropy"] = entry.entropy;
+    entry_json["response"] = entry.response;
+    std::string line = entry_json.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    line += '\n';
+    return line;
+}
+
+void AggregatedLogger::updateRollups(const std::vector<QueueNode*>& batch, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
     
-    if (!entry.verdict.reason.empty() && !entry.verdict.allowed) {
-        stats.constraint_violations[entry.verdict.reason]++;
+    RollupSample sample;
+    for (size_t i = 0; i < count; ++i) {
+        const RawLogEntry& entry = batch[i]->entry;
+        sample.timestamp = entry.timestamp;
+        sample.action_type = entry.action.action;
+        sample.tool_name = entry.action.tool_name;
+        sample.reason = entry.verdict.reason;
+        sample.allowed = entry.verdict.allowed;
+        sample.hallucination_risk = entry.verdict.hallucination_risk;
+        sample.entropy = entry.entropy;
+        rollups_.add(sample);
+    }
+}
+
+void AggregatedLogger::appendHistory(const std::vector<QueueNode*>& batch, size_t count) {
+    if (count == 0) return;
+    std::vector<AuditHistory::Record> records(count);
+    for (size_t i = 0; i < count; ++i) {
+        const RawLogEntry& entry = batch[i]->entry;
+        AuditHistory::Record& record = records[i];
+        record.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            entry.timestamp.time_since_epoch()).count();
+        record.agent_id = entry.action.agent_id;
+        record.action = entry.action.action;
+        record.tool = entry.action.tool_name;
+        record.risk = entry.verdict.hallucination_risk;
+        record.entropy = entry.entropy;
+        record.allowed = entry.verdict.allowed;
+    }
+    history_.append(records);
+}
+
+void AggregatedLogger::setConfig(const Config& config) {
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        config_ = config;
+        config_.commit_interval_ms = std::max(1, config.commit_interval_ms);
+        config_.fsync_interval_ms = std::max(1, config.fsync_interval_ms);
+        config_.segment_bytes = std::max<size_t>(4096, config.segment_bytes);
+        config_.max_queue = std::max<size_t>(1, config.max_queue);
     }
+    max_queue_.store(std::max<size_t>(1, config.max_queue));
+    writer_cv_.notify_one();
+}
+
+AggregatedLogger::Config AggregatedLogger::getConfig() const {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    return config_;
+}
+
+RawLogStats AggregatedLogger::getRawLogStats() const {
+    RawLogStats stats;
+    {
+        std::lock_guard<std::mutex> lock(commit_mutex_);
+        stats = stats_;
+    }
+    stats.enqueued = enqueued_.load();
+    // stats_.dropped — потери при ошибке записи, dropped_ — переполненная очередь
+    stats.dropped += dropped_.load();
+    stats.pending = queued_.load();
+    return stats;
 }
 
 void AggregatedLogger::aggregate() {
-    flushBuffer();
-    
-    // Обновляем все периоды
-    auto now = std::chrono::system_clock::now();
-    
-    // 5 часов
-    current_aggregates_["5h"].start_time = now - std::chrono::hours(5);
-    current_aggregates_["5h"].end_time = now;
-    current_aggregates_["5h"].period = "5h";
-    
-    // 12 часов
-    current_aggregates_["12h"].start_time = now - std::chrono::hours(12);
-    current_aggregates_["12h"].end_time = now;
-    current_aggregates_["12h"].period = "12h";
-    
-    // 24 часа
-    current_aggregates_["24h"].start_time = now - std::chrono::hours(24);
-    current_aggregates_["24h"].end_time = now;
-    current_aggregates_["24h"].period = "24h";
-    
-    // Неделя
-    current_aggregates_["week"].start_time = now - std::chrono::hours(168);
-    current_aggregates_["week"].end_time = now;
-    current_aggregates_["week"].period = "week";
-    
-    // Месяц
-    current_aggregates_["month"].start_time = now - std::chrono::hours(720);
-    current_aggregates_["month"].end_time = now;
-    current_aggregates_["month"].period = "month";
+    flush();
+    saveRollups();
+}
+
+void AggregatedLogger::saveRollups() {
+    // Под mutex_ только копия свёрток: JSON и запись на диск не блокируют запросы статистики
+    std::lock_guard<std::mutex> save_lock(save_mutex_);
+    AuditRollups rollups;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rollups = rollups_;
+    }
     
-    // Год
-    current_aggregates_["year"].start_time = now - std::chrono::hours(8760);
-    current_aggregates_["year"].end_time = now;
-    current_aggregates_["year"].period = "year";
+    const std::string path = aggregated_dir_ + "/rollups.json";
+    if (!AtomicFile::write(path, rollups.toJson().dump())) {
+        std::cerr << "[AggregatedLogger] Failed to write " << path << ": " << std::strerror(errno) << std::endl;
+    }
 }
 
-void AggregatedLogger::saveAggregate(const std::string& period, const AggregatedStats& stats) {
-    std::string filename = aggregated_dir_ + "/" + period + ".json";
-    std::ofstream file(filename);
-    if (file.is_open()) {
-        file << stats.toJson().dump(4);
+void AggregatedLogger::loadRollups() {
+    std::ifstream file(aggregated_dir_ + "/rollups.json");
+    if (!file.is_open()) return;
+    try {
+        nlohmann::json j;
+        file >> j;
+        rollups_.fromJson(j);
+    } catch (const std::exception& e) {
+        std::cerr << "[AggregatedLogger] Unreadable rollups: " << e.what() << std::endl;
     }
 }
 
@@ -190,8 +560,9 @@ void AggregatedLogger::saveAggregate(const std::string& period, const Aggregated
 // ПРОВЕРКА ОГРАНИЧЕНИЙ
 // ============================================================================
 
-bool AgentAuditBridge::checkConstraints(const AgentAction& action, const std::string& response, AuditVerdict& verdict) {
-    auto active = constraints_.getActiveConstraints();
+bool AgentAuditBridge::checkConstraints(AgentAuditState& state, const AuditPass& pass, const AgentAction& action,
+                                        const std::string& response, AuditVerdict& verdict) {
+    auto active = pass.constraints->getActiveConstraints();
     
     for (const auto& constraint : active) {
         // Проверка ограничений на длину ответа
@@ -209,7 +580,7 @@ bool AgentAuditBridge::checkConstraints(const AgentAction& action, const std::st
         // Проверка ограничений на уверенность
         if (constraint.name.find("confidence") != std::string::npos) {
             if (constraint.action_type.empty() || constraint.action_type == action.action) {
-                float confidence = getConfidenceFromResponse(response);
+                float confidence = getConfidenceFromResponse(response, pass.field.entropy);
                 if (confidence < constraint.threshold) {
                     // Не блокируем, только логируем
                     verdict.reason = "Low confidence (" + std::to_string(confidence) + 
@@ -223,8 +594,8 @@ bool AgentAuditBridge::checkConstraints(const AgentAction& action, const std::st
         // Проверка ограничений на шаги в секунду
         if (constraint.name == "max_steps_per_second") {
             auto now = std::chrono::steady_clock::now();
-            if (step_counter_ > 0) {
-                auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - last_step_time_).count();
+            if (state.step_counter > 0) {
+                auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - state.last_step_time).count();
                 if (elapsed < 1) {
                     float steps_per_sec = 1.0f / (elapsed + 0.001f);
                     if (steps_per_sec > constraint.limit) {
@@ -235,18 +606,17 @@ bool AgentAuditBridge::checkConstraints(const AgentAction& action, const std::st
                     }
                 }
             }
-            last_step_time_ = now;
+            state.last_step_time = now;
         }
         
         // Проверка ограничений на вызовы инструментов
         if (constraint.name == "max_tool_calls_per_cycle") {
             if (action.action == "call_tool") {
-                static std::unordered_map<std::string, int> tool_calls_in_cycle;
-                tool_calls_in_cycle[action.tool_name]++;
-                if (tool_calls_in_cycle[action.tool_name] > constraint.limit) {
+                state.tool_calls_in_cycle[action.tool_name]++;
+                if (state.tool_calls_in_cycle[action.tool_name] > constraint.limit) {
                     verdict.allowed = false;
                     verdict.reason = "Too many calls to " + action.tool_name + 
-                                    " (" + std::to_string(tool_calls_in_cycle[action.tool_name]) + 
+                                    " (" + std::to_string(state.tool_calls_in_cycle[action.tool_name]) + 
                                     " > " + std::to_string(constraint.limit) + ")";
                     return false;
                 }
@@ -257,7 +627,7 @@ bool AgentAuditBridge::checkConstraints(const AgentAction& action, const std::st
     return true;
 }
 
-float AgentAuditBridge::getConfidenceFromResponse(const std::string& response) {
+float AgentAuditBridge::getConfidenceFromResponse(const std::string& response, float entropy) {
     // Извлечение процента уверенности из ответа
     // Ищем паттерны типа "уверенность: 85%" или "confidence: 0.85"
     std::regex confidence_pattern(R"((?:уверенность|confidence)[:\s]*(\d+(?:\.\d+)?)%?)", std::regex::icase);
@@ -269,7 +639,7 @@ float AgentAuditBridge::getConfidenceFromResponse(const std::string& response) {
     }
     
     // Если не нашли, используем энтропию как прокси уверенности
-    return 1.0f - cached_entropy_;
+    return 1.0f - entropy;
 }
 
 std::string AgentAuditBridge::generateActionId() {
@@ -283,17 +653,55 @@ std::string AgentAuditBridge::generateActionId() {
 // ============================================================================
 
 AuditVerdict AgentAuditBridge::auditAction(const AgentAction& action) {
+    // Снимок поля и настроек на время проверки
+    const AuditPass pass = beginPass();
+    
+    auto state = states_.acquire(action.agent_id);
+    std::lock_guard<std::mutex> lock(state->mutex);
+    AuditVerdict verdict = evaluateAction(*state, pass, action);
+    logger_.logRaw(action, verdict, pass.field.entropy);
+    publishStatus(action.agent_id, *state, pass);
+    return verdict;
+}
+
+std::vector<AuditVerdict> AgentAuditBridge::auditActions(const std::vector<AgentAction>& actions) {
+    std::vector<AuditVerdict> verdicts;
+    if (actions.empty()) return verdicts;
+    verdicts.reserve(actions.size());
+    
+    // Один снимок поля и настроек на весь пакет
+    const AuditPass pass = beginPass();
+    
+    // Подряд идущие действия одного агента проверяются под одной блокировкой
+    std::shared_ptr<AgentAuditState> state;
+    std::unique_lock<std::mutex> lock;
+    const std::string* agent_id = nullptr;
+    for (const auto& action : actions) {
+        if (!agent_id || action.agent_id != *agent_id) {
+            if (lock.owns_lock()) lock.unlock();
+            state = states_.acquire(action.agent_id);
+            lock = std::unique_lock<std::mutex>(state->mutex);
+            agent_id = &action.agent_id;
+        }
+        verdicts.push_back(evaluateAction(*state, pass, action));
+    }
+    logger_.logRawBatch(actions, verdicts, pass.field.entropy);
+    publishStatus(*agent_id, *state, pass);
+    return verdicts;
+}
+
+// Вызывается под state.mutex; поле и настройки — из pass
+AuditVerdict AgentAuditBridge::evaluateAction(AgentAuditState& state, const AuditPass& pass, const AgentAction& action) {
+    const Config& config = *pass.config;
+    AgentSession& session = state.session;
     AuditVerdict verdict;
     verdict.allowed = true;
     verdict.hallucination_risk = 0.0f;
     verdict.entropy_contribution = 0.0f;
     verdict.reason = "";
     
-    // Обновляем энтропию из нейросети
-    updateEntropyFromNeuralSystem();
-    
     // 1. Проверка на опасные действия
-    if (isBlockedAction(action.action) || isBlockedAction(action.tool_name)) {
+    if (isBlockedAction(config, action.action) || isBlockedAction(config, action.tool_name)) {
         verdict.allowed = false;
         verdict.hallucination_risk = 0.95f;
         verdict.reason = "Action blocked by security policy: " + 
@@ -305,7 +713,7 @@ AuditVerdict AgentAuditBridge::auditAction(const AgentAction& action) {
     }
     
     // 2. Проверка на бесконечный цикл
-    if (isInfiniteLoop(action)) {
+    if (isInfiniteLoop(state, pass, action)) {
         verdict.allowed = false;
         verdict.hallucination_risk = 0.85f;
         verdict.reason = "Detected potential infinite loop: repeating same action pattern";
@@ -316,9 +724,9 @@ AuditVerdict AgentAuditBridge::auditAction(const AgentAction& action) {
     }
     
     // 3. Проверка на превышение лимитов
-    if (exceedsLimits(action)) {
+    if (exceedsLimits(state, pass)) {
         verdict.allowed = false;
-        verdict.hallucination_risk = cached_surprise_;
+        verdict.hallucination_risk = pass.field.surprise;
         verdict.reason = "Session limits exceeded: max steps or accumulated risk";
         verdict.suggested_action = "Start new session or reset context";
         
@@ -327,34 +735,33 @@ AuditVerdict AgentAuditBridge::auditAction(const AgentAction& action) {
     }
     
     // 4. Вычисление риска галлюцинации
-    verdict.hallucination_risk = computeHallucinationRisk(action, cached_surprise_);
+    const float computed_risk = computeHallucinationRisk(action, state, pass);
+    verdict.hallucination_risk = computed_risk;
 
     // 4.5 Проверка ограничений (нужно передать response, пока пустую)
     std::string empty_response;
-    if (!checkConstraints(action, empty_response, verdict)) {
+    if (!checkConstraints(state, pass, action, empty_response, verdict)) {
         // Если ограничение заблокировало действие
         if (audit_callback_) audit_callback_(action, verdict);
         return verdict;
     }
 
-    // 4.6 НОВОЕ: Получить риск из Lagrangian аудитора
-    float energy_risk = neural_system_.getEnergyBasedHallucinationRisk();
+    // 4.6 НОВОЕ: Получить риск из Lagrangian аудитора (снимок поля)
+    float energy_risk = pass.field.energy_error;
     
     // 4.7 Вычисление риска галлюцинации (объединяем с существующим)
-    float computed_risk = computeHallucinationRisk(action, cached_surprise_);
     verdict.hallucination_risk = std::max(computed_risk, energy_risk);
     
     // 5. Оценка вклада в энтропию
-    auto embedding = actionToEmbedding(action);
-    verdict.entropy_contribution = std::abs(cached_entropy_ - 0.5f) * 2.0f;
+    verdict.entropy_contribution = std::abs(pass.field.entropy - 0.5f) * 2.0f;
     
     // 6. Применяем настройки
-    if (verdict.hallucination_risk > config_.risk_block_threshold) {
+    if (verdict.hallucination_risk > config.risk_block_threshold) {
         verdict.allowed = false;
         verdict.reason = "Hallucination risk too high (" + 
                          std::to_string(verdict.hallucination_risk) + " > " +
-                         std::to_string(config_.risk_block_threshold) + ")";
-    } else if (verdict.hallucination_risk > config_.risk_warning_threshold) {
+                         std::to_string(config.risk_block_threshold) + ")";
+    } else if (verdict.hallucination_risk > config.risk_warning_threshold) {
         // Предупреждение, но разрешаем
         verdict.reason = "Warning: high hallucination risk (" + 
                          std::to_string(verdict.hallucination_risk) + ")";
@@ -362,25 +769,25 @@ AuditVerdict AgentAuditBridge::auditAction(const AgentAction& action) {
     
     // 7. Обновляем счётчики
     if (verdict.allowed) {
-        current_session_.total_steps++;
-        current_session_.accumulated_risk += verdict.hallucination_risk;
+        session.total_steps++;
+        session.accumulated_risk += verdict.hallucination_risk;
         
         // Обновляем скользящее среднее энтропии
-        current_session_.recent_surprise.push_back(cached_surprise_);
-        if (current_session_.recent_surprise.size() > 20) {
-            current_session_.recent_surprise.pop_front();
+        session.recent_surprise.push_back(pass.field.surprise);
+        if (session.recent_surprise.size() > 20) {
+            session.recent_surprise.pop_front();
         }
         float sum = 0.0f;
-        for (float s : current_session_.recent_surprise) sum += s;
-        current_session_.average_entropy = sum / current_session_.recent_surprise.size();
+        for (float s : session.recent_surprise) sum += s;
+        session.average_entropy = sum / session.recent_surprise.size();
         
         // Проверка на опасный режим
-        current_session_.is_dangerous_mode = (cached_entropy_ > config_.entropy_danger_threshold);
+        session.is_dangerous_mode = (pass.field.entropy > config.entropy_danger_threshold);
     }
     
     // Сохраняем в историю
-    history_.push_back({action, verdict});
-    if (history_.size() > MAX_HISTORY) history_.pop_front();
+    state.history.push_back({action, verdict});
+    if (state.history.size() > MAX_HISTORY) state.history.pop_front();
     
     // Вызываем callback
     if (audit_callback_) audit_callback_(action, verdict);
@@ -397,31 +804,115 @@ std::string AgentAuditBridge::getWorkingDirectory() const {
     return AgentConfig::getInstance().getWorkingDirectory();
 }
 
+bool AgentAuditBridge::runOnField(std::function<void(NeuralFieldSystem&)> fn) {
+    if (simulation_ && simulation_->isRunning()) {
+        // Пулы памяти принадлежат потоку поля: работаем его же командой и ждём её
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        auto task = [fn = std::move(fn), done](NeuralFieldSystem& field) {
+            fn(field);
+            done->store(true);
+        };
+        if (simulation_->submit(FieldCommand::run(task), std::chrono::milliseconds(1000)) != SimulationLoop::ACCEPTED) {
+            return false;
+        }
+        simulation_->flush();
+        return done->load();
+    }
+
+    std::lock_guard<std::mutex> field_lock(field_mutex_);
+    fn(neural_system_);
+    return true;
+}
+
 bool AgentAuditBridge::loadMemoryState() {
     auto& cfg = AgentConfig::getInstance();
-    std::cout << "[AgentAudit] Loading memory from: " << cfg.getMemoryDir() << std::endl;
-    // TODO: Реализовать загрузку
-    return true;
+    const auto started = std::chrono::steady_clock::now();
+
+    // Отсутствующий файл — пустой пул; нечитаемый откладывается в .corrupt
+    auto loadPool = [](const std::string& path, std::deque<NeuroMemoryRecord>& pool) {
+        if (!std::filesystem::exists(path)) return true;
+        std::string error;
+        if (MemorySnapshot::load(path, pool, &error)) return true;
+        const std::string corrupt_path = path + ".corrupt";
+        std::rename(path.c_str(), corrupt_path.c_str());
+        std::cerr << "[AgentAudit] Unreadable " << path << " (" << error << ") moved to "
+                  << corrupt_path << std::endl;
+        return false;
+    };
+
+    std::deque<NeuroMemoryRecord> stm;
+    std::deque<NeuroMemoryRecord> ltm;
+    const bool stm_ok = loadPool(cfg.getSTMFilePath(), stm);
+    const bool ltm_ok = loadPool(cfg.getLTMFilePath(), ltm);
+    if (stm.empty() && ltm.empty()) {
+        std::cout << "[AgentAudit] No memory state in " << cfg.getMemoryDir() << std::endl;
+        return stm_ok && ltm_ok;
+    }
+
+    const size_t stm_count = stm.size();
+    const size_t ltm_count = ltm.size();
+    auto pools = std::make_shared<std::pair<std::deque<NeuroMemoryRecord>, std::deque<NeuroMemoryRecord>>>(
+        std::move(stm), std::move(ltm));
+    const bool applied = runOnField([pools](NeuralFieldSystem& field) {
+        field.emergentMutable().memory.restore(std::move(pools->first), std::move(pools->second));
+    });
+    if (!applied) {
+        std::cerr << "[AgentAudit] Memory state loaded but not applied: field queue unavailable" << std::endl;
+        return false;
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    std::cout << "[AgentAudit] Memory restored from " << cfg.getMemoryDir() << ": STM " << stm_count
+              << ", LTM " << ltm_count << " records (" << std::fixed << std::setprecision(1) << ms
+              << " ms)" << std::defaultfloat << std::endl;
+    return stm_ok && ltm_ok;
 }
 
 bool AgentAuditBridge::saveMemoryState() {
     auto& cfg = AgentConfig::getInstance();
-    std::cout << "[AgentAudit] Saving memory to: " << cfg.getMemoryDir() << std::endl;
-    // TODO: Реализовать сохранение
+    const auto started = std::chrono::steady_clock::now();
+
+    // Копия пулов снимается на потоке поля, запись на диск — уже без него
+    auto pools = std::make_shared<std::pair<std::deque<NeuroMemoryRecord>, std::deque<NeuroMemoryRecord>>>();
+    const bool copied = runOnField([pools](NeuralFieldSystem& field) {
+        const auto& memory = field.emergent().memory;
+        pools->first = memory.getSTM();
+        pools->second = memory.getLTM();
+    });
+    if (!copied) {
+        std::cerr << "[AgentAudit] Memory state not saved: field queue unavailable" << std::endl;
+        return false;
+    }
+
+    std::string error;
+    if (!MemorySnapshot::save(cfg.getSTMFilePath(), pools->first, &error) ||
+        !MemorySnapshot::save(cfg.getLTMFilePath(), pools->second, &error)) {
+        std::cerr << "[AgentAudit] Failed to save memory state: " << error << std::endl;
+        return false;
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    std::cout << "[AgentAudit] Memory saved to " << cfg.getMemoryDir() << ": STM " << pools->first.size()
+              << ", LTM " << pools->second.size() << " records (" << std::fixed << std::setprecision(1) << ms
+              << " ms)" << std::defaultfloat << std::endl;
     return true;
 }
 
 void AgentAuditBridge::reportActionResult(const AgentAction& action, bool success, const std::string& observation) {
+    const AuditPass pass = beginPass();
+    auto state = states_.acquire(action.agent_id);
+    std::lock_guard<std::mutex> lock(state->mutex);
+    
     // Отправляем результат в нейросеть как награду
     float reward = success ? 0.8f : 0.2f;
     
     // Корректируем награду на основе энтропии
-    if (cached_entropy_ > config_.entropy_warning_threshold) {
+    if (pass.field.entropy > pass.config->entropy_warning_threshold) {
         reward *= 0.5f;  // Высокая энтропия = штраф
     }
     
     // Создаём эмбеддинг для обратной связи
-    auto embedding = actionToEmbedding(action);
+    auto embedding = actionToEmbedding(action, *state, pass);
     
     // Добавляем наблюдение в эмбеддинг (упрощённо — хеш наблюдения)
     std::hash<std::string> hasher;
@@ -430,86 +921,206 @@ void AgentAuditBridge::reportActionResult(const AgentAction& action, bool succes
         embedding[i] = (embedding[i] + (obs_hash >> (i * 8)) % 100 / 100.0f) * 0.5f;
     }
     
-    // Отправляем в INPUT_GROUP
-    neural_system_.setInputText(embedding);
-    
-    // Делаем шаг нейросети с полученной наградой
-    neural_system_.step(reward, neural_system_.getCurrentStep() + 1);
+    if (simulation_) {
+        // Вход и шаг — одной командой потоку поля; при полной очереди шаг теряется
+        auto result = simulation_->submit(FieldCommand::step(reward, std::move(embedding)));
+        if (result != SimulationLoop::ACCEPTED) {
+            const uint64_t dropped = ++dropped_feedback_;
+            if (dropped % 100 == 1) {
+                std::cout << "[AgentAudit] Field queue full, feedback dropped (total "
+                          << dropped << ")" << std::endl;
+            }
+        }
+    } else {
+        std::lock_guard<std::mutex> field_lock(field_mutex_);
+        // Отправляем в INPUT_GROUP
+        neural_system_.setInputText(embedding);
+        
+        // Делаем шаг нейросети с полученной наградой
+        neural_system_.step(reward, neural_system_.getCurrentStep() + 1);
+    }
     
-    // Обновляем кэш
-    updateEntropyFromNeuralSystem();
+    // Показания после шага (без потока поля — уже новые)
+    const AuditPass after = beginPass();
     
-    if (current_session_.total_steps % 100 == 0) {
-        std::cout << "[AgentAudit] Step " << current_session_.total_steps 
+    if (state->session.total_steps % 100 == 0) {
+        std::cout << "[AgentAudit] Step " << state->session.total_steps 
                   << " | Success=" << success
-                  << " | Risk=" << getCurrentHallucinationRisk()
-                  << " | Entropy=" << cached_entropy_
+                  << " | Risk=" << hallucinationRisk(after.field)
+                  << " | Entropy=" << after.field.entropy
                   << std::endl;
     }
+    
+    publishStatus(action.agent_id, *state, after);
 }
 
-void AgentAuditBridge::startSession(const std::string& session_id, const std::string& agent_name) {
-    current_session_.session_id = session_id;
-    current_session_.agent_name = agent_name;
-    current_session_.total_steps = 0;
-    current_session_.accumulated_risk = 0.0f;
-    current_session_.average_entropy = 0.5f;
-    current_session_.recent_surprise.clear();
-    current_session_.is_dangerous_mode = false;
-    
-    consecutive_similar_actions_ = 0;
-    recent_embeddings_.clear();
+void AgentAuditBridge::startSession(const std::string& session_id, const std::string& agent_name,
+                                    const std::string& agent_id) {
+    auto state = states_.acquire(agent_id);
+    std::lock_guard<std::mutex> lock(state->mutex);
+    
+    AgentSession& session = state->session;
+    session.session_id = session_id;
+    session.agent_name = agent_name;
+    session.total_steps = 0;
+    session.accumulated_risk = 0.0f;
+    session.average_entropy = 0.5f;
+    session.recent_surprise.clear();
+    session.is_dangerous_mode = false;
+    
+    state->resetLoopDetection();
     
     std::cout << "[AgentAudit] Session started: " << session_id 
               << " for agent: " << agent_name << std::endl;
+    publishStatus(agent_id, *state, beginPass());
 }
 
-void AgentAuditBridge::endSession() {
-    std::cout << "[AgentAudit] Session ended: " << current_session_.session_id
-              << " | Total steps: " << current_session_.total_steps
-              << " | Avg risk: " << (current_session_.accumulated_risk / std::max(1, current_session_.total_steps))
-              << " | Avg entropy: " << current_session_.average_entropy
-              << std::endl;
+void AgentAuditBridge::endSession(const std::string& agent_id) {
+    auto state = states_.find(agent_id);
+    if (!state) return;
+    
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        const AgentSession& session = state->session;
+        std::cout << "[AgentAudit] Session ended: " << session.session_id
+                  << " | Total steps: " << session.total_steps
+                  << " | Avg risk: " << (session.accumulated_risk / std::max(1, session.total_steps))
+                  << " | Avg entropy: " << session.average_entropy
+                  << std::endl;
+        
+        state->session = AgentSession();
+        state->resetLoopDetection();
+        publishStatus(agent_id, *state, beginPass());
+    }
     
-    current_session_ = AgentSession();
-    consecutive_similar_actions_ = 0;
-    recent_embeddings_.clear();
+    // Сессия по умолчанию остаётся, сессии агентов — нет
+    if (!agent_id.empty()) states_.erase(agent_id);
+}
+
+AgentSession AgentAuditBridge::getCurrentSession(const std::string& agent_id) const {
+    auto state = states_.find(agent_id);
+    if (!state) return AgentSession();
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->session;
+}
+
+std::vector<AgentSession> AgentAuditBridge::getSessions() const {
+    std::vector<AgentSession> sessions;
+    for (const auto& [agent_id, state] : states_.all()) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        sessions.push_back(state->session);
+    }
+    return sessions;
+}
+
+std::deque<std::pair<AgentAction, AuditVerdict>> AgentAuditBridge::getHistory(const std::string& agent_id) const {
+    auto state = states_.find(agent_id);
+    if (!state) return {};
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->history;
 }
 
 float AgentAuditBridge::getCurrentHallucinationRisk() const {
+    return hallucinationRisk(readField());
+}
+
+float AgentAuditBridge::hallucinationRisk(const FieldReading& field) {
     // Риск = surprise * (1 - quality) * entropy_factor
-    float surprise = cached_surprise_;
-    float quality = neural_system_.lastSignal().quality;
-    float entropy_factor = std::min(1.0f, cached_entropy_ * 1.5f);
+    float entropy_factor = std::min(1.0f, field.entropy * 1.5f);
     
-    float risk = surprise * (1.0f - quality) * entropy_factor;
+    float risk = field.surprise * (1.0f - field.quality) * entropy_factor;
     return std::clamp(risk, 0.0f, 1.0f);
 }
 
 float AgentAuditBridge::getCurrentEntropy() const {
-    return cached_entropy_;
+    return readField().entropy;
 }
 
-void AgentAuditBridge::resetRiskAccumulator() {
-    current_session_.accumulated_risk = 0.0f;
-    consecutive_similar_actions_ = 0;
-    recent_embeddings_.clear();
+void AgentAuditBridge::resetRiskAccumulator(const std::string& agent_id) {
+    auto state = states_.find(agent_id);
+    if (!state) return;
+    
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->session.accumulated_risk = 0.0f;
+    state->resetLoopDetection();
     
     std::cout << "[AgentAudit] Risk accumulator reset" << std::endl;
+    publishStatus(agent_id, *state, beginPass());
+}
+
+void AgentAuditBridge::publishStatus(const std::string& agent_id, const AgentAuditState& state, const AuditPass& pass) {
+    auto snap = std::make_shared<StatusSnapshot>();
+    snap->agent_id = agent_id;
+    snap->session_id = state.session.session_id;
+    snap->total_steps = state.session.total_steps;
+    snap->successful_actions = state.session.successful_actions;
+    snap->blocked_actions = state.session.blocked_actions;
+    snap->accumulated_risk = state.session.accumulated_risk;
+    snap->average_entropy = state.session.average_entropy;
+    snap->risk = hallucinationRisk(pass.field);
+    snap->entropy = pass.field.entropy;
+    snap->agents = states_.size();
+    snap->last_action = lastActionOf(state);
+    
+    // Ограничения читаются под тем же мьютексом, что и в publishConstraints():
+    // последний опубликованный снимок всегда видит последние ограничения
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    snap->constraints = constraintsStatus(*std::atomic_load(&constraints_));
+    std::atomic_store(&status_snapshot_, std::shared_ptr<const StatusSnapshot>(std::move(snap)));
+}
+
+void AgentAuditBridge::publishConstraints() {
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    auto snap = std::make_shared<StatusSnapshot>(*std::atomic_load(&status_snapshot_));
+    snap->constraints = constraintsStatus(*std::atomic_load(&constraints_));
+    std::atomic_store(&status_snapshot_, std::shared_ptr<const StatusSnapshot>(std::move(snap)));
+}
+
+AgentAuditBridge::LastActionInfo AgentAuditBridge::lastActionOf(const AgentAuditState& state) {
+    LastActionInfo info;
+    if (!state.history.empty()) {
+        info.action = state.history.back().first.action;
+        info.risk = state.history.back().second.hallucination_risk;
+        info.allowed = state.history.back().second.allowed;
+        info.reason = state.history.back().second.reason;
+    }
+    return info;
+}
+
+std::map<std::string, bool> AgentAuditBridge::constraintsStatus(const AuditConstraintsConfig& constraints) {
+    std::map<std::string, bool> status;
+    auto active = constraints.getActiveConstraints();
+    for (const auto& c : active) {
+        status[c.name] = true;
+    }
+    // Добавляем выключенные
+    status["response_length_300"] = constraints.response_length_limit_300.enabled;
+    status["response_length_600"] = constraints.response_length_limit_600.enabled;
+    status["response_length_1000"] = constraints.response_length_limit_1000.enabled;
+    status["confidence_30"] = constraints.confidence_threshold_30.enabled;
+    status["confidence_50"] = constraints.confidence_threshold_50.enabled;
+    status["confidence_70"] = constraints.confidence_threshold_70.enabled;
+    status["confidence_90"] = constraints.confidence_threshold_90.enabled;
+    status["max_steps_per_second"] = constraints.max_steps_per_second.enabled;
+    status["max_tokens_per_response"] = constraints.max_tokens_per_response.enabled;
+    status["max_tool_calls_per_cycle"] = constraints.max_tool_calls_per_cycle.enabled;
+    return status;
 }
 
 // ============================================================================
 // ПРИВАТНЫЕ МЕТОДЫ
 // ============================================================================
 
-std::vector<float> AgentAuditBridge::actionToEmbedding(const AgentAction& action) {
-    std::vector<float> embedding(NeuralFieldSystem::GROUP_SIZE, 0.0f);
+std::vector<float> AgentAuditBridge::actionToEmbedding(const AgentAction& action, const AgentAuditState& state, const AuditPass& pass) {
+    const int GS = neural_system_.groupSize();
+    const int B = GS / 4;  // размер блока (8 при группе из 32 нейронов)
+    std::vector<float> embedding(GS, 0.0f);
     
-    // Кодируем действие (32-мерный эмбеддинг)
-    // [0-7]: тип действия
-    // [8-15]: инструмент (хеш)
-    // [16-23]: энтропия контекста
-    // [24-31]: риск предыдущих шагов
+    // Кодируем действие (эмбеддинг размером с группу, 4 блока по B)
+    // [0, B):    тип действия
+    // [B, 2B):   инструмент (хеш)
+    // [2B, 3B):  энтропия контекста
+    // [3B, 4B):  риск предыдущих шагов
     
     // Тип действия (one-hot)
     int action_type = 0;
@@ -518,34 +1129,37 @@ std::vector<float> AgentAuditBridge::actionToEmbedding(const AgentAction& action
     else if (action.action == "respond") action_type = 2;
     else action_type = 3;
     
-    for (int i = 0; i < 8; ++i) {
+    for (int i = 0; i < B; ++i) {
         embedding[i] = (i == action_type) ? 1.0f : 0.0f;
     }
     
     // Инструмент (хеш в 0-1)
     std::hash<std::string> hasher;
     size_t tool_hash = hasher(action.tool_name);
-    for (int i = 0; i < 8; ++i) {
-        embedding[8 + i] = ((tool_hash >> i) & 1) ? 0.8f : 0.2f;
+    for (int i = 0; i < B; ++i) {
+        embedding[B + i] = ((tool_hash >> (i % 64)) & 1) ? 0.8f : 0.2f;
     }
     
     // Энтропия контекста
-    for (int i = 0; i < 8; ++i) {
-        embedding[16 + i] = cached_entropy_;
+    for (int i = 0; i < B; ++i) {
+        embedding[2 * B + i] = pass.field.entropy;
     }
     
     // Накопленный риск
-    float normalized_risk = std::min(1.0f, current_session_.accumulated_risk / config_.max_accumulated_risk);
-    for (int i = 0; i < 8; ++i) {
-        embedding[24 + i] = normalized_risk;
+    float normalized_risk = std::min(1.0f, state.session.accumulated_risk / pass.config->max_accumulated_risk);
+    for (int i = 0; i < B; ++i) {
+        embedding[3 * B + i] = normalized_risk;
     }
     
     return embedding;
 }
 
-float AgentAuditBridge::computeHallucinationRisk(const AgentAction& action, float surprise) {
+float AgentAuditBridge::computeHallucinationRisk(const AgentAction& action, const AgentAuditState& state, const AuditPass& pass) {
+    const Config& config = *pass.config;
+    const float entropy = pass.field.entropy;
+    
     // Базовый риск = текущая неожиданность
-    float risk = surprise;
+    float risk = pass.field.surprise;
     
     // Корректировка по типу действия
     if (action.action == "call_tool") {
@@ -555,83 +1169,86 @@ float AgentAuditBridge::computeHallucinationRisk(const AgentAction& action, floa
     }
     
     // Корректировка по накопленному риску
-    float risk_factor = std::min(1.0f, current_session_.accumulated_risk / config_.max_accumulated_risk);
+    float risk_factor = std::min(1.0f, state.session.accumulated_risk / config.max_accumulated_risk);
     risk += risk_factor * 0.2f;
     
     // Корректировка по энтропии
-    if (cached_entropy_ > config_.entropy_warning_threshold) {
-        risk += (cached_entropy_ - config_.entropy_warning_threshold) * 1.5f;
+    if (entropy > config.entropy_warning_threshold) {
+        risk += (entropy - config.entropy_warning_threshold) * 1.5f;
     }
     
     return std::clamp(risk, 0.0f, 1.0f);
 }
 
-bool AgentAuditBridge::isInfiniteLoop(const AgentAction& action) {
-    auto embedding = actionToEmbedding(action);
+bool AgentAuditBridge::isInfiniteLoop(AgentAuditState& state, const AuditPass& pass, const AgentAction& action) {
+    auto embedding = actionToEmbedding(action, state, pass);
     
     // Проверяем на повторение того же действия
-    if (action.action == last_action_name_) {
-        float sim = cosineSimilarity(embedding, last_action_embedding_);
+    if (action.action == state.last_action_name) {
+        float sim = cosineSimilarity(embedding, state.last_action_embedding);
         if (sim > 0.95f) {
-            consecutive_similar_actions_++;
-            if (consecutive_similar_actions_ >= config_.max_consecutive_similar_actions) {
+            state.consecutive_similar_actions++;
+            if (state.consecutive_similar_actions >= pass.config->max_consecutive_similar_actions) {
                 return true;
             }
         } else {
-            consecutive_similar_actions_ = 0;
+            state.consecutive_similar_actions = 0;
         }
     } else {
-        consecutive_similar_actions_ = 0;
+        state.consecutive_similar_actions = 0;
     }
     
     // Проверяем на цикл в истории
-    recent_embeddings_.push_back(embedding);
-    if (recent_embeddings_.size() > CYCLE_DETECTION_WINDOW) {
-        recent_embeddings_.pop_front();
+    state.recent_embeddings.push_back(embedding);
+    if (state.recent_embeddings.size() > CYCLE_DETECTION_WINDOW) {
+        state.recent_embeddings.pop_front();
     }
     
     // Ищем повторяющийся паттерн (период 2-4)
-    if (recent_embeddings_.size() >= 6) {
+    if (state.recent_embeddings.size() >= 6) {
         for (int period = 2; period <= 4; ++period) {
             bool is_cycle = true;
-            for (size_t i = 0; i < recent_embeddings_.size() - period; ++i) {
-                float sim = cosineSimilarity(recent_embeddings_[i], recent_embeddings_[i + period]);
+            for (size_t i = 0; i < state.recent_embeddings.size() - period; ++i) {
+                float sim = cosineSimilarity(state.recent_embeddings[i], state.recent_embeddings[i + period]);
                 if (sim < 0.9f) {
                     is_cycle = false;
                     break;
                 }
             }
-            if (is_cycle && recent_embeddings_.size() >= period * 2) {
+            if (is_cycle && state.recent_embeddings.size() >= period * 2) {
                 return true;
             }
         }
     }
     
-    last_action_name_ = action.action;
-    last_action_embedding_ = embedding;
+    state.last_action_name = action.action;
+    state.last_action_embedding = embedding;
     
     return false;
 }
 
-bool AgentAuditBridge::exceedsLimits(const AgentAction& action) {
+bool AgentAuditBridge::exceedsLimits(const AgentAuditState& state, const AuditPass& pass) {
+    const AgentSession& session = state.session;
+    const Config& config = *pass.config;
+    
     // Лимит шагов
-    if (current_session_.total_steps >= config_.max_steps_per_session) {
+    if (session.total_steps >= config.max_steps_per_session) {
         return true;
     }
     
     // Лимит накопленного риска
-    if (current_session_.accumulated_risk >= config_.max_accumulated_risk) {
+    if (session.accumulated_risk >= config.max_accumulated_risk) {
         return true;
     }
     
     // Проверка на минимальное изменение энтропии (защита от застывания)
-    if (current_session_.recent_surprise.size() >= 10) {
+    if (session.recent_surprise.size() >= 10) {
         float sum = 0.0f;
-        for (float s : current_session_.recent_surprise) sum += s;
-        float avg = sum / current_session_.recent_surprise.size();
+        for (float s : session.recent_surprise) sum += s;
+        float avg = sum / session.recent_surprise.size();
         
-        if (std::abs(avg - cached_surprise_) < config_.min_entropy_change_to_continue &&
-            current_session_.total_steps > 20) {
+        if (std::abs(avg - pass.field.surprise) < config.min_entropy_change_to_continue &&
+            session.total_steps > 20) {
             return true;  // Энтропия не меняется — агент застрял
         }
     }
@@ -639,17 +1256,27 @@ bool AgentAuditBridge::exceedsLimits(const AgentAction& action) {
     return false;
 }
 
-void AgentAuditBridge::updateEntropyFromNeuralSystem() {
-    int current_step = neural_system_.getCurrentStep();
-    if (current_step != last_entropy_update_step_) {
-        cached_entropy_ = static_cast<float>(neural_system_.getUnifiedEntropy());
-        cached_surprise_ = neural_system_.lastSignal().surprise;
-        last_entropy_update_step_ = current_step;
-    }
+AgentAuditBridge::FieldReading AgentAuditBridge::readField() const {
+    // Только опубликованный снимок: поле может шагать в своём потоке
+    auto snap = neural_system_.getPublishedSnapshot();
+    FieldReading field;
+    field.entropy = static_cast<float>(snap->entropy);
+    field.surprise = static_cast<float>(snap->surprise);
+    field.energy_error = static_cast<float>(snap->energy_error);
+    field.quality = static_cast<float>(snap->quality);
+    return field;
 }
 
-bool AgentAuditBridge::isBlockedAction(const std::string& action) {
-    for (const auto& blocked : config_.blocked_actions) {
+AgentAuditBridge::AuditPass AgentAuditBridge::beginPass() const {
+    AuditPass pass;
+    pass.field = readField();
+    pass.config = std::atomic_load(&config_);
+    pass.constraints = std::atomic_load(&constraints_);
+    return pass;
+}
+
+bool AgentAuditBridge::isBlockedAction(const Config& config, const std::string& action) {
+    for (const auto& blocked : config.blocked_actions) {
         if (action.find(blocked) != std::string::npos) {
             return true;
         }
@@ -673,63 +1300,26 @@ float AgentAuditBridge::cosineSimilarity(const std::vector<float>& a, const std:
     return (denom < 1e-6f) ? 0.0f : std::clamp(dot / denom, 0.0f, 1.0f);
 }
 
-AggregatedStats AggregatedLogger::loadAggregate(const std::string& period) {
-    AggregatedStats stats;
-    stats.period = period;
-    
-    std::string filename = aggregated_dir_ + "/" + period + ".json";
-    std::ifstream file(filename);
-    if (file.is_open()) {
-        nlohmann::json j;
-        file >> j;
-        
-        stats.total_actions = j.value("total_actions", 0);
-        stats.successful_actions = j.value("successful_actions", 0);
-        stats.blocked_actions = j.value("blocked_actions", 0);
-        stats.warnings = j.value("warnings", 0);
-        stats.avg_hallucination_risk = j.value("avg_hallucination_risk", 0.0f);
-        stats.max_hallucination_risk = j.value("max_hallucination_risk", 0.0f);
-        stats.avg_entropy = j.value("avg_entropy", 0.0f);
-        stats.min_entropy = j.value("min_entropy", 0.0f);
-        stats.max_entropy = j.value("max_entropy", 0.0f);
-        
-        if (j.contains("actions_by_type")) {
-            stats.actions_by_type = j["actions_by_type"].get<std::unordered_map<std::string, int>>();
-        }
-        if (j.contains("tool_usage")) {
-            stats.tool_usage = j["tool_usage"].get<std::unordered_map<std::string, int>>();
-        }
-        if (j.contains("constraint_violations")) {
-            stats.constraint_violations = j["constraint_violations"].get<std::unordered_map<std::string, int>>();
-        }
-    }
-    
-    return stats;
-}
-
 std::vector<std::string> AggregatedLogger::getAvailablePeriods() const {
-    std::vector<std::string> periods;
-    for (const auto& [period, _] : current_aggregates_) {
-        periods.push_back(period);
-    }
-    return periods;
+    return AuditRollups::namedPeriods();
 }
 
 void AggregatedLogger::cleanupOldLogs(int max_days) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    // Под commit_mutex_: текущий сегмент не удаляем, даже если он старый
+    std::lock_guard<std::mutex> lock(commit_mutex_);
     
     auto now = std::chrono::system_clock::now();
     auto cutoff = now - std::chrono::hours(24 * max_days);
     
     for (const auto& entry : std::filesystem::directory_iterator(raw_logs_dir_)) {
-        if (entry.is_regular_file()) {
+        if (entry.is_regular_file() && entry.path().string() != segment_path_) {
             try {
                 // Получаем время модификации
                 auto ftime = std::filesystem::last_write_time(entry.path());
                 
                 // Конвертируем в time_t через системное время
                 // Используем более простой подход: проверяем по имени файла
-                // Имя файла содержит дату в формате raw_YYYYMMDD_HHMMSS.json
+                // Имя файла содержит дату: raw_YYYYMMDD_HHMMSS.json или сегмент raw_YYYYMMDD_HHMMSS_NNNNNN.log
                 std::string filename = entry.path().stem().string();
                 
                 // Извлекаем дату из имени файла
@@ -762,38 +1352,52 @@ void AggregatedLogger::cleanupOldLogs(int max_days) {
 }
 
 void AgentAuditBridge::enableConstraint(const std::string& name, bool enabled) {
-    constraints_.setEnabled(name, enabled);
+    {
+        std::lock_guard<std::mutex> lock(settings_mutex_);
+        auto updated = std::make_shared<AuditConstraintsConfig>(*std::atomic_load(&constraints_));
+        updated->setEnabled(name, enabled);
+        std::atomic_store(&constraints_, std::shared_ptr<const AuditConstraintsConfig>(std::move(updated)));
+    }
+    publishConstraints();
+}
+
+void AgentAuditBridge::setConstraints(const AuditConstraintsConfig& cfg) {
+    {
+        std::lock_guard<std::mutex> lock(settings_mutex_);
+        std::atomic_store(&constraints_, std::shared_ptr<const AuditConstraintsConfig>(
+            std::make_shared<AuditConstraintsConfig>(cfg)));
+    }
+    publishConstraints();
+}
+
+void AgentAuditBridge::setConfig(const Config& cfg) {
+    std::lock_guard<std::mutex> lock(settings_mutex_);
+    std::atomic_store(&config_, std::shared_ptr<const Config>(std::make_shared<Config>(cfg)));
 }
 
 bool AgentAuditBridge::isConstraintEnabled(const std::string& name) const {
-    auto active = constraints_.getActiveConstraints();
+    auto active = std::atomic_load(&constraints_)->getActiveConstraints();
     for (const auto& c : active) {
         if (c.name == name) return true;
     }
     return false;
 }
 
-std::string AggregatedLogger::getPeriodKey(const std::chrono::system_clock::time_point& time, const std::string& period) {
-    auto time_t = std::chrono::system_clock::to_time_t(time);
-    std::tm* tm = std::localtime(&time_t);
-    
-    std::ostringstream oss;
-    if (period == "5h" || period == "12h" || period == "24h") {
-        oss << std::put_time(tm, "%Y%m%d");
-    } else if (period == "week") {
-        oss << std::put_time(tm, "%Y%W");
-    } else if (period == "month") {
-        oss << std::put_time(tm, "%Y%m");
-    } else {
-        oss << std::put_time(tm, "%Y");
+AggregatedStats AggregatedLogger::getStatsForPeriod(const std::string& period) const {
+    std::chrono::seconds window;
+    if (!AuditRollups::parsePeriod(period, window)) {
+        AggregatedStats stats;
+        stats.period = period;
+        return stats;
     }
-    return oss.str();
+    const auto now = std::chrono::system_clock::now();
+    AggregatedStats stats = getStats(now - window, now);
+    stats.period = period;
+    return stats;
 }
 
-AggregatedStats AggregatedLogger::getStatsForPeriod(const std::string& period) const {
-    auto it = current_aggregates_.find(period);
-    if (it != current_aggregates_.end()) {
-        return it->second;
-    }
-    return AggregatedStats();
+AggregatedStats AggregatedLogger::getStats(std::chrono::system_clock::time_point start,
+                                           std::chrono::system_clock::time_point end) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rollups_.query(start, end);
 }
\ No newline at end of file
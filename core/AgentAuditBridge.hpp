@@ -19,13 +19,20 @@
 #include <optional>
 #include <fstream>
 #include <filesystem>
+#include <mutex>
+#include <memory>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 #include <nlohmann/json.hpp>
 #include "application/AgentConfig.hpp"
-
-static constexpr int GROUP_SIZE = 32;
+#include "AuditRollups.hpp"
+#include "AuditHistory.hpp"
 
 // Forward declarations
 class NeuralFieldSystem;
+class SimulationLoop;
 
 // ============================================================================
 // СТРУКТУРЫ ДАННЫХ ДЛЯ АУДИТА
@@ -45,6 +52,8 @@ struct AgentAction {
 
     // Уникальный ID для трекинга
     std::string action_id;
+    // Чьё состояние аудита (сессия, детектор циклов); "" — сессия по умолчанию
+    std::string agent_id;
 };
 
 /**
@@ -79,6 +88,73 @@ struct AgentSession {
     std::chrono::system_clock::time_point start_time;
 };
 
+/**
+ * @struct AgentAuditState
+ * @brief Состояние аудита одного агента: сессия, детектор циклов, история
+ *
+ * Все поля, кроме last_used_ms, — под mutex; аудиты разных агентов его не делят.
+ */
+struct AgentAuditState {
+    std::mutex mutex;
+    AgentSession session;
+    
+    // Детектор циклов
+    std::deque<std::vector<float>> recent_embeddings;
+    int consecutive_similar_actions = 0;
+    std::string last_action_name;
+    std::vector<float> last_action_embedding;
+    
+    // Ограничения темпа и вызовов инструментов
+    int step_counter = 0;
+    std::chrono::steady_clock::time_point last_step_time;
+    std::unordered_map<std::string, int> tool_calls_in_cycle;
+    
+    std::deque<std::pair<AgentAction, AuditVerdict>> history;
+    
+    // Последнее обращение (мс steady_clock), для вытеснения
+    std::atomic<int64_t> last_used_ms{0};
+    
+    void resetLoopDetection() {
+        consecutive_similar_actions = 0;
+        recent_embeddings.clear();
+    }
+};
+
+/**
+ * @class AgentStateMap
+ * @brief Состояния аудита по agent_id, разбитые на шарды
+ *
+ * Логика:
+ * - мьютекс шарда держится только на поиск/вставку; проверка действия идёт
+ *   под мьютексом состояния агента, поэтому разные агенты не ждут друг друга
+ * - состояние создаётся при первом действии агента
+ * - в переполненном шарде вытесняется дольше всех не использованное состояние
+ *   (сессия по умолчанию "" не вытесняется)
+ */
+class AgentStateMap {
+public:
+    static constexpr size_t SHARDS = 16;
+    static constexpr size_t MAX_STATES_PER_SHARD = 256;
+    
+    std::shared_ptr<AgentAuditState> acquire(const std::string& agent_id);
+    std::shared_ptr<AgentAuditState> find(const std::string& agent_id) const;
+    bool erase(const std::string& agent_id);
+    size_t size() const;
+    std::vector<std::pair<std::string, std::shared_ptr<AgentAuditState>>> all() const;
+    
+private:
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<AgentAuditState>> states;
+    };
+    
+    Shard& shardFor(const std::string& agent_id) const {
+        return shards_[std::hash<std::string>{}(agent_id) % SHARDS];
+    }
+    
+    mutable std::array<Shard, SHARDS> shards_;
+};
+
 // ============================================================================
 // СИСТЕМА ОГРАНИЧЕНИЙ (с возможностью включения/выключения)
 // ============================================================================
@@ -171,80 +247,105 @@ struct AuditConstraintsConfig {
 };
 
 
-// ============================================================================
-// СИСТЕМА АГРЕГИРОВАННОГО ЛОГИРОВАНИЯ
-// ============================================================================
-
 /**
- * @struct AggregatedStats
- * @brief Агрегированная статистика за период
+ * @struct RawLogStats
+ * @brief Счётчики журнала сырых действий
  */
-struct AggregatedStats {
-    std::string period;  // "5h", "12h", "24h", "week", "month", "year"
-    std::chrono::system_clock::time_point start_time;
-    std::chrono::system_clock::time_point end_time;
-    
-    // Счётчики
-    int total_actions = 0;
-    int successful_actions = 0;
-    int blocked_actions = 0;
-    int warnings = 0;
-    
-    // Риски и энтропия
-    float avg_hallucination_risk = 0.0f;
-    float max_hallucination_risk = 0.0f;
-    float avg_entropy = 0.0f;
-    float min_entropy = 1.0f;
-    float max_entropy = 0.0f;
-    
-    // По типам действий
-    std::unordered_map<std::string, int> actions_by_type;
-    
-    // По инструментам
-    std::unordered_map<std::string, int> tool_usage;
+struct RawLogStats {
+    uint64_t enqueued = 0;          // принято logRaw/logRawBatch
+    uint64_t written = 0;           // записано в сегменты
+    uint64_t pending = 0;           // в очереди, ещё не забрано писателем
+    uint64_t dropped = 0;           // отброшено: переполненная очередь или ошибка записи
+    uint64_t commits = 0;           // групповых записей (writev-пачек)
+    uint64_t fsyncs = 0;
+    uint64_t bytes = 0;
+    uint64_t write_errors = 0;
+    uint64_t segments = 0;          // ротаций с запуска
+    std::string segment;            // текущий файл сегмента
     
-    // Ограничения
-    std::unordered_map<std::string, int> constraint_violations;
-    
-    // Конвертация в JSON
     nlohmann::json toJson() const {
         nlohmann::json j;
-        j["period"] = period;
-        j["total_actions"] = total_actions;
-        j["successful_actions"] = successful_actions;
-        j["blocked_actions"] = blocked_actions;
-        j["warnings"] = warnings;
-        j["avg_hallucination_risk"] = avg_hallucination_risk;
-        j["max_hallucination_risk"] = max_hallucination_risk;
-        j["avg_entropy"] = avg_entropy;
-        j["min_entropy"] = min_entropy;
-        j["max_entropy"] = max_entropy;
-        j["actions_by_type"] = actions_by_type;
-        j["tool_usage"] = tool_usage;
-        j["constraint_violations"] = constraint_violations;
+        j["enqueued"] = enqueued;
+        j["written"] = written;
+        j["pending"] = pending;
+        j["dropped"] = dropped;
+        j["commits"] = commits;
+        j["avg_commit_size"] = commits > 0 ? static_cast<double>(written) / commits : 0.0;
+        j["fsyncs"] = fsyncs;
+        j["bytes"] = bytes;
+        j["write_errors"] = write_errors;
+        j["segments"] = segments;
+        j["segment"] = segment;
         return j;
     }
 };
 
-
 /**
  * @class AggregatedLogger
  * @brief Система агрегированного логирования с разными интервалами
+ * 
+ * Логика:
+ * - logRaw/logRawBatch только кладут запись в lock-free очередь (стек Трайбера, один CAS)
+ * - Поток-писатель раз в commit_interval_ms забирает всю очередь целиком и пишет её
+ *   одним writev (групповой коммит) в конец текущего сегмента: одна строка JSON на запись
+ * - Сегменты raw_YYYYMMDD_HHMMSS_NNNNNN.log только дописываются; при превышении
+ *   segment_bytes открывается следующий
+ * - fsync по политике: NONE — никогда, COMMIT — после каждой пачки, INTERVAL — не чаще fsync_interval_ms
+ * - Статистика за периоды — свёртки AuditRollups, обновляются той же пачкой;
+ *   сохраняются в aggregated_dir/rollups.json раз в AGGREGATE_SAVE_INTERVAL и при остановке
+ * - Та же пачка дописывается в колоночную историю AuditHistory (history_dir) для /api/analytics
  */
 class AggregatedLogger {
 public:
+    struct Config {
+        enum FsyncPolicy {
+            NONE,           // только page cache; быстрее всего, теряется при сбое ОС
+            COMMIT,         // fdatasync после каждой групповой записи
+            INTERVAL        // fdatasync не чаще fsync_interval_ms
+        };
+        
+        FsyncPolicy fsync = INTERVAL;
+        int fsync_interval_ms = 1000;
+        int commit_interval_ms = 10;
+        size_t segment_bytes = 64u << 20;
+        size_t max_queue = 1u << 20;    // сверх этого logRaw отбрасывает записи
+        
+        static const char* toString(FsyncPolicy policy) {
+            switch (policy) {
+                case NONE: return "none";
+                case COMMIT: return "commit";
+                default: return "interval";
+            }
+        }
+        
+        static FsyncPolicy fromString(const std::string& name) {
+            if (name == "none") return NONE;
+            if (name == "commit") return COMMIT;
+            return INTERVAL;
+        }
+    };
+    
     AggregatedLogger(const std::string& raw_logs_dir = "logs/raw",
-                     const std::string& aggregated_dir = "logs/aggregated");
+                     const std::string& aggregated_dir = "logs/aggregated",
+                     const std::string& history_dir = "logs/history");
     ~AggregatedLogger();
     
     // Логирование сырого действия
     void logRaw(const AgentAction& action, const AuditVerdict& verdict, float entropy, const std::string& response = "");
+    // Пакет действий одной вставкой в очередь (один CAS, одна отметка времени)
+    void logRawBatch(const std::vector<AgentAction>& actions, const std::vector<AuditVerdict>& verdicts, float entropy);
     
-    // Агрегация по интервалам
+    // Записать всё, что поставлено в очередь до вызова
+    void flush();
+    
+    // Записать очередь и сохранить свёртки
     void aggregate();
     
-    // Получить статистику за период
+    // Получить статистику за период ("24h", "week", "90m" — см. AuditRollups::parsePeriod)
     AggregatedStats getStatsForPeriod(const std::string& period) const;
+    // Статистика за произвольное окно
+    AggregatedStats getStats(std::chrono::system_clock::time_point start,
+                             std::chrono::system_clock::time_point end) const;
     
     // Получить все доступные периоды
     std::vector<std::string> getAvailablePeriods() const;
@@ -252,14 +353,22 @@ public:
     // Очистка старых логов (старше N дней)
     void cleanupOldLogs(int max_days = 30);
     
+    void setConfig(const Config& config);
+    Config getConfig() const;
+    RawLogStats getRawLogStats() const;
+    
+    const AuditHistory& getHistory() const { return history_; }
+    
 private:
     std::string raw_logs_dir_;
     std::string aggregated_dir_;
     
-    // Текущие агрегаты
-    std::unordered_map<std::string, AggregatedStats> current_aggregates_;
+    // Свёртки минута/час/сутки; под mutex_
+    AuditRollups rollups_;
+    
+    // Колоночная история; пишется под commit_mutex_, читается под своей блокировкой
+    AuditHistory history_;
     
-    // Временные буферы для сырых логов
     struct RawLogEntry {
         std::chrono::system_clock::time_point timestamp;
         AgentAction action;
@@ -267,18 +376,56 @@ private:
         float entropy;
         std::string response;
     };
-    std::deque<RawLogEntry> raw_buffer_;
-    static constexpr int MAX_BUFFER_SIZE = 10000;
     
-    // Вспомогательные методы
-    std::string getPeriodKey(const std::chrono::system_clock::time_point& time, const std::string& period);
-    void flushBuffer();
-    void updateAggregate(AggregatedStats& stats, const RawLogEntry& entry);
-    void saveAggregate(const std::string& period, const AggregatedStats& stats);
-    AggregatedStats loadAggregate(const std::string& period);
+    // Узел очереди: производители связывают их сами, писатель забирает список целиком
+    struct QueueNode {
+        RawLogEntry entry;
+        QueueNode* next = nullptr;
+    };
+    std::atomic<QueueNode*> queue_head_{nullptr};
+    std::atomic<size_t> queued_{0};
+    std::atomic<uint64_t> enqueued_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<size_t> max_queue_{1u << 20};
+    
+    // Поток-писатель
+    Config config_;                         // под writer_mutex_
+    std::thread writer_;
+    bool writer_stop_ = false;
+    mutable std::mutex writer_mutex_;
+    std::condition_variable writer_cv_;
+    
+    // Текущий сегмент и счётчики; всё под commit_mutex_ (захватывается раньше mutex_)
+    int segment_fd_ = -1;
+    uint64_t segment_seq_ = 0;
+    size_t segment_size_ = 0;
+    bool segment_dirty_ = false;            // есть записи после последнего fsync
+    std::string segment_path_;
+    std::chrono::steady_clock::time_point last_fsync_;
+    std::chrono::steady_clock::time_point last_aggregate_save_;
+    RawLogStats stats_;
+    mutable std::mutex commit_mutex_;
     
-    // Потокобезопасность
+    // Вспомогательные методы
+    bool reserveQueue(size_t count);
+    void pushChain(QueueNode* first, QueueNode* last);
+    void writerLoop();
+    void commitPending(bool force_sync);    // commit_mutex_ захватывается внутри
+    bool openSegment();                     // segment_path_ пуст — начинает новый сегмент
+    void closeSegment(bool sync);
+    static std::string formatEntry(const RawLogEntry& entry);
+    bool writeLines(const std::vector<std::string>& lines, size_t begin, size_t end);
+    // Первые count узлов пачки — записанные в сегмент
+    void updateRollups(const std::vector<QueueNode*>& batch, size_t count);
+    void appendHistory(const std::vector<QueueNode*>& batch, size_t count);
+    void saveRollups();                     // mutex_ захватывается внутри
+    void loadRollups();
+    
+    static constexpr std::chrono::seconds AGGREGATE_SAVE_INTERVAL{30};
+    
+    // Потокобезопасность свёрток
     mutable std::mutex mutex_;
+    std::mutex save_mutex_;                 // одна запись rollups.json за раз; захватывается раньше mutex_
 };
 // ============================================================================
 // ОСНОВНОЙ КЛАСС — АУДИТОР АГЕНТОВ
@@ -290,22 +437,33 @@ public:
     ~AgentAuditBridge() = default;
 
     // ===== ОСНОВНЫЕ МЕТОДЫ =====
+    // Потокобезопасны: состояние своё у каждого agent_id (AgentStateMap),
+    // поле читается только из опубликованного снимка, настройки — копии при записи
     AuditVerdict auditAction(const AgentAction& action);
+    // Пакет за один проход: энтропия из снимка поля читается один раз, действия
+    // проверяются по порядку (вердикты те же, что у auditAction подряд),
+    // одна запись в лог и одна публикация статуса
+    std::vector<AuditVerdict> auditActions(const std::vector<AgentAction>& actions);
     void reportActionResult(const AgentAction& action, bool success, const std::string& observation);
-    void startSession(const std::string& session_id, const std::string& agent_name);
-    void endSession();
+    void startSession(const std::string& session_id, const std::string& agent_name,
+                      const std::string& agent_id = "");
+    // Сессия агента удаляется целиком, сессия по умолчанию обнуляется
+    void endSession(const std::string& agent_id = "");
 
     // ===== УПРАВЛЕНИЕ ОГРАНИЧЕНИЯМИ =====
     void enableConstraint(const std::string& name, bool enabled);
     bool isConstraintEnabled(const std::string& name) const;
-    const AuditConstraintsConfig& getConstraints() const { return constraints_; }
-    void setConstraints(const AuditConstraintsConfig& cfg) { constraints_ = cfg; }
+    AuditConstraintsConfig getConstraints() const { return *std::atomic_load(&constraints_); }
+    void setConstraints(const AuditConstraintsConfig& cfg);
     
     // ===== ПОЛУЧЕНИЕ ДАННЫХ =====
-    const AgentSession& getCurrentSession() const { return current_session_; }
+    // Копия сессии агента ("" — по умолчанию); пустая, если агента нет
+    AgentSession getCurrentSession(const std::string& agent_id = "") const;
+    std::vector<AgentSession> getSessions() const;
+    size_t getSessionCount() const { return states_.size(); }
     float getCurrentHallucinationRisk() const;
     float getCurrentEntropy() const;
-    void resetRiskAccumulator();
+    void resetRiskAccumulator(const std::string& agent_id = "");
 
     // ===== ДОСТУП К ЛОГГЕРУ =====
     AggregatedLogger& getLogger() { return logger_; }
@@ -327,19 +485,30 @@ public:
         };
     };
     
-    void setConfig(const Config& cfg) { config_ = cfg; }
-    const Config& getConfig() const { return config_; }
+    void setConfig(const Config& cfg);
+    Config getConfig() const { return *std::atomic_load(&config_); }
     
     // ===== ЛОГИРОВАНИЕ =====
+    // Колбэк задаётся до начала аудита; вызывается из потоков обработчиков
     using AuditCallback = std::function<void(const AgentAction&, const AuditVerdict&)>;
     void setAuditCallback(AuditCallback callback) { audit_callback_ = callback; }
-    const std::deque<std::pair<AgentAction, AuditVerdict>>& getHistory() const { return history_; }
+    std::deque<std::pair<AgentAction, AuditVerdict>> getHistory(const std::string& agent_id = "") const;
 
+    // ===== ПОТОК ПОЛЯ =====
+    // Если задан, обратная связь уходит командой в очередь потока-владельца поля,
+    // а состояние поля читается только из опубликованного снимка
+    void setSimulationLoop(SimulationLoop* loop) { simulation_ = loop; }
+    uint64_t getDroppedFeedback() const { return dropped_feedback_.load(); }
+    // Выполняет fn над полем: командой потока поля, если он запущен, иначе под field_mutex_.
+    // Все прямые изменения поля без потока (в том числе из API) идут через этот замок
+    bool runOnField(std::function<void(NeuralFieldSystem&)> fn);
+    
     // ===== РАБОЧАЯ ПАПКА =====
     void setWorkingDirectory(const std::string& path);
     std::string getWorkingDirectory() const;
     
     // ===== СОХРАНЕНИЕ/ЗАГРУЗКА =====
+    // Пулы STM/LTM эмерджентной памяти в бинарных снимках (см. MemorySnapshot)
     bool loadMemoryState();
     bool saveMemoryState();
 
@@ -360,76 +529,99 @@ public:
         }
     };
     
+    // Последнее действие последнего активного агента
     LastActionInfo getLastActionInfo() const {
-        LastActionInfo info;
-        if (!history_.empty()) {
-            info.action = history_.back().first.action;
-            info.risk = history_.back().second.hallucination_risk;
-            info.allowed = history_.back().second.allowed;
-            info.reason = history_.back().second.reason;
-        }
-        return info;
+        return getStatusSnapshot()->last_action;
     }
     
     std::map<std::string, bool> getConstraintsStatus() const {
-        std::map<std::string, bool> status;
-        auto active = constraints_.getActiveConstraints();
-        for (const auto& c : active) {
-            status[c.name] = true;
-        }
-        // Добавляем выключенные
-        status["response_length_300"] = constraints_.response_length_limit_300.enabled;
-        status["response_length_600"] = constraints_.response_length_limit_600.enabled;
-        status["response_length_1000"] = constraints_.response_length_limit_1000.enabled;
-        status["confidence_30"] = constraints_.confidence_threshold_30.enabled;
-        status["confidence_50"] = constraints_.confidence_threshold_50.enabled;
-        status["confidence_70"] = constraints_.confidence_threshold_70.enabled;
-        status["confidence_90"] = constraints_.confidence_threshold_90.enabled;
-        status["max_steps_per_second"] = constraints_.max_steps_per_second.enabled;
-        status["max_tokens_per_response"] = constraints_.max_tokens_per_response.enabled;
-        status["max_tool_calls_per_cycle"] = constraints_.max_tool_calls_per_cycle.enabled;
-        return status;
+        return constraintsStatus(*std::atomic_load(&constraints_));
+    }
+    
+    // ===== Снимок для читателей API (SSE, /api/metrics) =====
+    // Публикуется после каждого изменения сессии/ограничений и описывает
+    // последнего активного агента; чтение — атомарная загрузка указателя,
+    // без блокировок моста и поля
+    struct StatusSnapshot {
+        std::string agent_id;
+        std::string session_id;
+        int total_steps = 0;
+        int successful_actions = 0;
+        int blocked_actions = 0;
+        float accumulated_risk = 0.0f;
+        float average_entropy = 0.5f;
+        float risk = 0.0f;
+        float entropy = 0.5f;
+        size_t agents = 0;              // состояний агентов в памяти
+        LastActionInfo last_action;
+        std::map<std::string, bool> constraints;
+    };
+    
+    std::shared_ptr<const StatusSnapshot> getStatusSnapshot() const {
+        return std::atomic_load(&status_snapshot_);
     }
     
 private:
+    // Показания поля из опубликованного снимка
+    struct FieldReading {
+        float entropy = 0.5f;
+        float surprise = 0.5f;
+        float energy_error = 0.0f;
+        float quality = 0.5f;
+    };
+    
+    // Всё общее, что нужно одной проверке (или пакету): поле и настройки
+    // читаются один раз и дальше не меняются
+    struct AuditPass {
+        FieldReading field;
+        std::shared_ptr<const Config> config;
+        std::shared_ptr<const AuditConstraintsConfig> constraints;
+    };
+    
     std::string generateActionId();
+    FieldReading readField() const;
+    AuditPass beginPass() const;
+    // Вызываются под state.mutex
+    AuditVerdict evaluateAction(AgentAuditState& state, const AuditPass& pass, const AgentAction& action);
+    void publishStatus(const std::string& agent_id, const AgentAuditState& state, const AuditPass& pass);
+    // Обновить ограничения в уже опубликованном снимке
+    void publishConstraints();
     
     // ===== ПРИВАТНЫЕ МЕТОДЫ =====
-    std::vector<float> actionToEmbedding(const AgentAction& action);
-    float computeHallucinationRisk(const AgentAction& action, float surprise);
-    bool isInfiniteLoop(const AgentAction& action);
-    bool exceedsLimits(const AgentAction& action);
-    void updateEntropyFromNeuralSystem();
-    bool isBlockedAction(const std::string& action);
-    bool checkConstraints(const AgentAction& action, const std::string& response, AuditVerdict& verdict);
-    float getConfidenceFromResponse(const std::string& response);
+    std::vector<float> actionToEmbedding(const AgentAction& action, const AgentAuditState& state, const AuditPass& pass);
+    float computeHallucinationRisk(const AgentAction& action, const AgentAuditState& state, const AuditPass& pass);
+    bool isInfiniteLoop(AgentAuditState& state, const AuditPass& pass, const AgentAction& action);
+    bool exceedsLimits(const AgentAuditState& state, const AuditPass& pass);
+    bool isBlockedAction(const Config& config, const std::string& action);
+    bool checkConstraints(AgentAuditState& state, const AuditPass& pass, const AgentAction& action,
+                          const std::string& response, AuditVerdict& verdict);
+    float getConfidenceFromResponse(const std::string& response, float entropy);
     float normalizeValue(float value, float min, float max);
     float cosineSimilarity(const std::vector<float>& a, const std::vector<float>& b);
+    static float hallucinationRisk(const FieldReading& field);
+    static LastActionInfo lastActionOf(const AgentAuditState& state);
+    static std::map<std::string, bool> constraintsStatus(const AuditConstraintsConfig& constraints);
     
     // ===== ПОЛЯ =====
     NeuralFieldSystem& neural_system_;
-    AgentSession current_session_;
-    Config config_;
-    AuditConstraintsConfig constraints_;
     AuditCallback audit_callback_;
     AggregatedLogger logger_;
     
-    std::deque<std::pair<AgentAction, AuditVerdict>> history_;
-    static constexpr int MAX_HISTORY = 1000;
+    // Настройки: читатели берут указатель атомарно, запись — копией под settings_mutex_
+    std::shared_ptr<const Config> config_;
+    std::shared_ptr<const AuditConstraintsConfig> constraints_;
+    std::mutex settings_mutex_;
     
-    std::deque<std::vector<float>> recent_embeddings_;
+    AgentStateMap states_;
+    static constexpr int MAX_HISTORY = 1000;          // на агента
     static constexpr int CYCLE_DETECTION_WINDOW = 10;
     
-    float cached_entropy_ = 0.5f;
-    float cached_surprise_ = 0.5f;
-    int last_entropy_update_step_ = -1;
+    static std::atomic<int> action_id_counter_;
     
-    int consecutive_similar_actions_ = 0;
-    std::string last_action_name_;
-    std::vector<float> last_action_embedding_;
-
-    int step_counter_ = 0;
-    std::chrono::steady_clock::time_point last_step_time_;
+    std::shared_ptr<const StatusSnapshot> status_snapshot_;
+    std::mutex publish_mutex_;          // порядок публикаций статуса и ограничений
     
-    static std::atomic<int> action_id_counter_;
+    SimulationLoop* simulation_ = nullptr;
+    std::mutex field_mutex_;            // прямые вызовы поля, когда потока поля нет
+    std::atomic<uint64_t> dropped_feedback_{0};   // шагов, не принятых из-за полной очереди
 };
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// --------------------
+// Выровненный аллокатор (для SIMD и строк кэша)
+// --------------------
+template <typename T, std::size_t Align = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = AlignedAllocator<U, Align>; };
+
+    AlignedAllocator() noexcept = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Align>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        // aligned_alloc требует размер, кратный выравниванию
+        std::size_t bytes = ((n * sizeof(T) + Align - 1) / Align) * Align;
+        void* p = std::aligned_alloc(Align, bytes);
+        if (!p) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, std::size_t) noexcept { std::free(p); }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Align>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Align>&) const noexcept { return false; }
+};
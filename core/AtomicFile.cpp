@@ -0,0 +1,39 @@
+#include "AtomicFile.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+    bool writeAll(int fd, const char* data, size_t bytes) {
+        size_t written = 0;
+        while (written < bytes) {
+            ssize_t n = ::write(fd, data + written, bytes - written);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            written += static_cast<size_t>(n);
+        }
+        return true;
+    }
+}
+
+bool AtomicFile::write(const std::string& path, const void* data, size_t bytes) {
+    const std::string tmp_path = path + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    bool ok = writeAll(fd, static_cast<const char*>(data), bytes) && ::fsync(fd) == 0;
+    int saved_errno = errno;
+    if (::close(fd) != 0 && ok) {
+        ok = false;
+        saved_errno = errno;
+    }
+    if (ok && std::rename(tmp_path.c_str(), path.c_str()) == 0) return true;
+
+    if (ok) saved_errno = errno;
+    std::remove(tmp_path.c_str());
+    errno = saved_errno;
+    return false;
+}
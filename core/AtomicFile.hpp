@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// --------------------
+// Атомарная замена файла (agents.json, снимки памяти, rollups.json)
+// --------------------
+
+/**
+ * @struct AtomicFile
+ * @brief Запись файла целиком через временный файл рядом с ним
+ *
+ * Логика:
+ * - данные пишутся в path + ".tmp" (O_TRUNC, запись до конца с повтором на EINTR)
+ * - fsync и close проверяются до rename: данные на диске раньше, чем новое имя
+ * - после сбоя на месте path старый или новый файл, но целый
+ * - при ошибке tmp удаляется, errno — от упавшего вызова
+ */
+struct AtomicFile {
+    static bool write(const std::string& path, const void* data, size_t bytes);
+
+    static bool write(const std::string& path, const std::string& data) {
+        return write(path, data.data(), data.size());
+    }
+};
@@ -0,0 +1,338 @@
+#include "AuditHistory.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ============================================================================
+// ОТОБРАЖЁННЫЙ СТОЛБЕЦ
+// ============================================================================
+
+bool MappedColumn::open(const std::string& path, size_t row_width, size_t min_rows) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    width = row_width;
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) return false;
+    return reserve(std::max(static_cast<size_t>(st.st_size) / width, min_rows));
+}
+
+bool MappedColumn::reserve(size_t rows) {
+    if (rows <= capacity) return true;
+
+    const size_t bytes = rows * width;
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) return false;
+    if (static_cast<size_t>(st.st_size) < bytes && ::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        return false;
+    }
+
+    void* mapped = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) return false;
+    if (data) ::munmap(data, capacity * width);
+    data = static_cast<char*>(mapped);
+    capacity = rows;
+    return true;
+}
+
+void MappedColumn::sync(bool wait) {
+    if (data) ::msync(data, capacity * width, wait ? MS_SYNC : MS_ASYNC);
+}
+
+void MappedColumn::close() {
+    if (data) ::munmap(data, capacity * width);
+    if (fd >= 0) ::close(fd);
+    data = nullptr;
+    fd = -1;
+    capacity = 0;
+}
+
+// ============================================================================
+// ОТКРЫТИЕ
+// ============================================================================
+
+AuditHistory::AuditHistory(const std::string& dir) : dir_(dir) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+
+    const std::string base = dir_ + "/";
+    meta_fd_ = ::open((base + "history.meta").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    open_ = meta_fd_ >= 0 &&
+            timestamps_.open(base + "timestamp.col", sizeof(int64_t), INITIAL_ROWS) &&
+            agents_.open(base + "agent.col", sizeof(uint32_t), INITIAL_ROWS) &&
+            actions_.open(base + "action.col", sizeof(uint32_t), INITIAL_ROWS) &&
+            tools_.open(base + "tool.col", sizeof(uint32_t), INITIAL_ROWS) &&
+            risks_.open(base + "risk.col", sizeof(float), INITIAL_ROWS) &&
+            entropies_.open(base + "entropy.col", sizeof(float), INITIAL_ROWS) &&
+            allowed_.open(base + "allowed.col", sizeof(uint8_t), INITIAL_ROWS) &&
+            openDictionary(dicts_[AGENT], base + "agent.dict") &&
+            openDictionary(dicts_[ACTION], base + "action.dict") &&
+            openDictionary(dicts_[TOOL], base + "tool.dict");
+    if (!open_) {
+        std::cerr << "[AuditHistory] Failed to open " << dir_ << ", history disabled" << std::endl;
+        return;
+    }
+
+    Meta meta{};
+    if (::pread(meta_fd_, &meta, sizeof(meta), 0) != static_cast<ssize_t>(sizeof(meta)) || meta.magic != MAGIC) {
+        meta.rows = 0;
+    }
+
+    // Столбец мог остаться короче meta (ручное вмешательство) — верим самому короткому
+    size_t rows = static_cast<size_t>(meta.rows);
+    for (const MappedColumn* column : {&timestamps_, &agents_, &actions_, &tools_, &risks_, &entropies_, &allowed_}) {
+        rows = std::min(rows, column->capacity);
+    }
+    rows_ = rows;
+    publishRows();
+
+    const int64_t* ts = timestamps_.as<int64_t>();
+    zones_.resize((rows_ + ZONE_ROWS - 1) / ZONE_ROWS);
+    for (size_t row = 0; row < rows_; ++row) {
+        Zone& zone = zones_[row / ZONE_ROWS];
+        zone.min_ms = std::min(zone.min_ms, ts[row]);
+        zone.max_ms = std::max(zone.max_ms, ts[row]);
+    }
+}
+
+AuditHistory::~AuditHistory() {
+    // Штатное закрытие: страницы столбцов уже в кэше ядра, число строк можно публиковать
+    if (open_) publishRows();
+    if (meta_fd_ >= 0) ::close(meta_fd_);
+    for (MappedColumn* column : {&timestamps_, &agents_, &actions_, &tools_, &risks_, &entropies_, &allowed_}) {
+        column->close();
+    }
+    for (auto& dict : dicts_) {
+        if (dict.fd >= 0) ::close(dict.fd);
+    }
+}
+
+bool AuditHistory::openDictionary(Dictionary& dict, const std::string& path) {
+    // Строка JSON на запись; недописанный хвост после сбоя отрезаем
+    size_t valid_bytes = 0;
+    {
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (file.eof()) break;      // без '\n' — запись не завершена
+            try {
+                std::string name = nlohmann::json::parse(line).get<std::string>();
+                dict.ids.emplace(name, static_cast<uint32_t>(dict.names.size()));
+                dict.names.push_back(std::move(name));
+            } catch (...) {
+                break;
+            }
+            valid_bytes += line.size() + 1;
+        }
+    }
+
+    dict.fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (dict.fd < 0) return false;
+    return ::ftruncate(dict.fd, static_cast<off_t>(valid_bytes)) == 0;
+}
+
+// ============================================================================
+// ЗАПИСЬ
+// ============================================================================
+
+uint32_t AuditHistory::intern(Column column, const std::string& name) {
+    Dictionary& dict = dicts_[column];
+    auto it = dict.ids.find(name);
+    if (it != dict.ids.end()) return it->second;
+
+    const uint32_t id = static_cast<uint32_t>(dict.names.size());
+    dict.ids.emplace(name, id);
+    dict.names.push_back(name);
+
+    const std::string line = nlohmann::json(name).dump(-1, ' ', false, nlohmann::json::error_handler_t::replace) + "\n";
+    if (::write(dict.fd, line.data(), line.size()) != static_cast<ssize_t>(line.size())) {
+        std::cerr << "[AuditHistory] Failed to append dictionary entry" << std::endl;
+    }
+    return id;
+}
+
+bool AuditHistory::reserve(size_t rows) {
+    if (rows <= timestamps_.capacity) return true;
+    const size_t capacity = std::max(rows, timestamps_.capacity * 2);
+    for (MappedColumn* column : {&timestamps_, &agents_, &actions_, &tools_, &risks_, &entropies_, &allowed_}) {
+        if (!column->reserve(capacity)) return false;
+    }
+    return true;
+}
+
+void AuditHistory::append(const std::vector<Record>& records) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (!open_ || records.empty()) return;
+    if (!reserve(rows_ + records.size())) {
+        std::cerr << "[AuditHistory] Failed to grow columns, " << records.size() << " rows dropped" << std::endl;
+        return;
+    }
+
+    int64_t* ts = timestamps_.as<int64_t>();
+    uint32_t* agents = agents_.as<uint32_t>();
+    uint32_t* actions = actions_.as<uint32_t>();
+    uint32_t* tools = tools_.as<uint32_t>();
+    float* risks = risks_.as<float>();
+    float* entropies = entropies_.as<float>();
+    uint8_t* allowed = allowed_.as<uint8_t>();
+
+    for (const Record& record : records) {
+        const size_t row = rows_++;
+        ts[row] = record.timestamp_ms;
+        agents[row] = intern(AGENT, record.agent_id);
+        actions[row] = intern(ACTION, record.action);
+        tools[row] = intern(TOOL, record.tool);
+        risks[row] = record.risk;
+        entropies[row] = record.entropy;
+        allowed[row] = record.allowed ? 1 : 0;
+
+        if (row / ZONE_ROWS >= zones_.size()) zones_.emplace_back();
+        Zone& zone = zones_[row / ZONE_ROWS];
+        zone.min_ms = std::min(zone.min_ms, record.timestamp_ms);
+        zone.max_ms = std::max(zone.max_ms, record.timestamp_ms);
+    }
+
+    // history.meta здесь не трогаем: число строк публикует sync()
+}
+
+void AuditHistory::sync(bool wait) {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (!open_) return;
+    for (MappedColumn* column : {&timestamps_, &agents_, &actions_, &tools_, &risks_, &entropies_, &allowed_}) {
+        column->sync(wait);
+    }
+    if (!wait) {
+        publishRows();
+        return;
+    }
+    // Сначала столбцы и словари на диске, затем число строк: meta не может
+    // опередить данные и после сбоя питания
+    for (auto& dict : dicts_) ::fdatasync(dict.fd);
+    publishRows();
+    ::fdatasync(meta_fd_);
+}
+
+void AuditHistory::publishRows() {
+    const Meta meta{MAGIC, static_cast<uint64_t>(rows_)};
+    if (::pwrite(meta_fd_, &meta, sizeof(meta), 0) != static_cast<ssize_t>(sizeof(meta))) {
+        std::cerr << "[AuditHistory] Failed to write " << dir_ << "/history.meta" << std::endl;
+    }
+}
+
+uint64_t AuditHistory::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return rows_;
+}
+
+// ============================================================================
+// СЛОВАРИ
+// ============================================================================
+
+int64_t AuditHistory::lookup(Column column, const std::string& name) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const auto& ids = dicts_[column].ids;
+    auto it = ids.find(name);
+    return it == ids.end() ? -1 : static_cast<int64_t>(it->second);
+}
+
+std::string AuditHistory::name(Column column, uint32_t id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const auto& names = dicts_[column].names;
+    return id < names.size() ? names[id] : std::string();
+}
+
+// ============================================================================
+// ПРИМИТИВЫ
+// ============================================================================
+
+template<typename Visit>
+uint64_t AuditHistory::scan(const Filter& filter, Visit&& visit) const {
+    if (!open_) return 0;
+    const int64_t* ts = timestamps_.as<int64_t>();
+    const uint32_t* agents = agents_.as<uint32_t>();
+    const uint32_t* actions = actions_.as<uint32_t>();
+    const uint32_t* tools = tools_.as<uint32_t>();
+    const float* risks = risks_.as<float>();
+    const uint8_t* allowed = allowed_.as<uint8_t>();
+
+    uint64_t scanned = 0;
+    for (size_t z = 0; z < zones_.size(); ++z) {
+        if (zones_[z].max_ms < filter.from_ms || zones_[z].min_ms > filter.to_ms) continue;
+        const size_t begin = z * ZONE_ROWS;
+        const size_t end = std::min<size_t>(rows_, begin + ZONE_ROWS);
+        scanned += end - begin;
+        for (size_t row = begin; row < end; ++row) {
+            if (ts[row] < filter.from_ms || ts[row] > filter.to_ms) continue;
+            if (filter.agent >= 0 && agents[row] != filter.agent) continue;
+            if (filter.action >= 0 && actions[row] != filter.action) continue;
+            if (filter.tool >= 0 && tools[row] != filter.tool) continue;
+            if (filter.allowed >= 0 && allowed[row] != filter.allowed) continue;
+            if (risks[row] < filter.min_risk || risks[row] > filter.max_risk) continue;
+            visit(row);
+        }
+    }
+    return scanned;
+}
+
+AuditHistory::Summary AuditHistory::summarize(const Filter& filter) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const float* risks = risks_.as<float>();
+    const float* entropies = entropies_.as<float>();
+    const uint8_t* allowed = allowed_.as<uint8_t>();
+
+    Summary summary;
+    summary.scanned = scan(filter, [&](size_t row) {
+        summary.rows++;
+        summary.allowed += allowed[row];
+        summary.risk_sum += risks[row];
+        summary.entropy_sum += entropies[row];
+        summary.max_risk = std::max(summary.max_risk, risks[row]);
+    });
+    return summary;
+}
+
+std::vector<uint64_t> AuditHistory::countBy(Column column, const Filter& filter) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const MappedColumn& source = column == AGENT ? agents_ : (column == ACTION ? actions_ : tools_);
+    const uint32_t* ids = source.as<uint32_t>();
+
+    std::vector<uint64_t> counts(dicts_[column].names.size(), 0);
+    scan(filter, [&](size_t row) {
+        if (ids[row] < counts.size()) counts[ids[row]]++;
+    });
+    return counts;
+}
+
+std::vector<uint64_t> AuditHistory::timeline(const Filter& filter, int64_t start_ms, int64_t bucket_ms, size_t buckets) const {
+    std::vector<uint64_t> counts(buckets, 0);
+    if (bucket_ms <= 0 || buckets == 0) return counts;
+
+    Filter window = filter;
+    window.from_ms = std::max(filter.from_ms, start_ms);
+    window.to_ms = std::min(filter.to_ms, start_ms + bucket_ms * static_cast<int64_t>(buckets) - 1);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const int64_t* ts = timestamps_.as<int64_t>();
+    scan(window, [&](size_t row) {
+        counts[static_cast<size_t>((ts[row] - start_ms) / bucket_ms)]++;
+    });
+    return counts;
+}
+
+std::vector<uint64_t> AuditHistory::riskHistogram(const Filter& filter, const std::vector<float>& edges) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const float* risks = risks_.as<float>();
+
+    std::vector<uint64_t> counts(edges.size() + 1, 0);
+    scan(filter, [&](size_t row) {
+        counts[std::upper_bound(edges.begin(), edges.end(), risks[row]) - edges.begin()]++;
+    });
+    return counts;
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+// --------------------
+// Колоночная история аудита на mmap
+// --------------------
+
+/**
+ * @struct MappedColumn
+ * @brief Файл фиксированной ширины строки, отображённый в память
+ *
+ * Файл растёт удвоением (ftruncate + новое отображение); содержимое за
+ * пределами числа строк истории не читается.
+ */
+struct MappedColumn {
+    int fd = -1;
+    char* data = nullptr;
+    size_t width = 0;       // байт на строку
+    size_t capacity = 0;    // строк помещается в отображение
+
+    bool open(const std::string& path, size_t row_width, size_t min_rows);
+    bool reserve(size_t rows);
+    void sync(bool wait);
+    void close();
+
+    template<typename T> T* as() { return reinterpret_cast<T*>(data); }
+    template<typename T> const T* as() const { return reinterpret_cast<const T*>(data); }
+};
+
+/**
+ * @class AuditHistory
+ * @brief Колоночное хранилище проверенных действий для аналитики
+ *
+ * Логика:
+ * - столбцы — отдельные файлы dir/<имя>.col: время (мс), агент, тип действия,
+ *   инструмент, риск, энтропия, allowed; строки — словарные id (dir/<имя>.dict,
+ *   строка JSON на запись), поэтому строка истории — 29 байт
+ * - число строк лежит в dir/history.meta (обычный файл, не отображение) и
+ *   публикуется только в sync(): при wait — после msync столбцов и fdatasync
+ *   словарей, поэтому meta не опережает данные и при сбое питания; без wait —
+ *   сразу, что защищает лишь от падения процесса. Строки после последней
+ *   публикации после перезапуска просто не видны
+ * - на каждые ZONE_ROWS строк хранится мин/макс времени: фильтр по времени
+ *   пропускает блоки целиком, не трогая их страницы
+ * - примитивы summarize/countBy/timeline/riskHistogram — один проход по
+ *   отобранным блокам; читатели разделяют блокировку, append берёт её монопольно
+ */
+class AuditHistory {
+public:
+    static constexpr size_t ZONE_ROWS = 4096;
+    static constexpr size_t INITIAL_ROWS = 1u << 16;
+
+    enum Column { AGENT, ACTION, TOOL, DICTIONARIES };
+
+    struct Record {
+        int64_t timestamp_ms = 0;
+        std::string agent_id;
+        std::string action;
+        std::string tool;
+        float risk = 0.0f;
+        float entropy = 0.0f;
+        bool allowed = true;
+    };
+
+    // Условия отбора; -1 — любое значение
+    struct Filter {
+        int64_t from_ms = std::numeric_limits<int64_t>::min();
+        int64_t to_ms = std::numeric_limits<int64_t>::max();
+        int64_t agent = -1;
+        int64_t action = -1;
+        int64_t tool = -1;
+        int allowed = -1;
+        float min_risk = -std::numeric_limits<float>::infinity();
+        float max_risk = std::numeric_limits<float>::infinity();
+    };
+
+    struct Summary {
+        uint64_t rows = 0;
+        uint64_t allowed = 0;
+        double risk_sum = 0.0;
+        double entropy_sum = 0.0;
+        float max_risk = 0.0f;
+        uint64_t scanned = 0;   // строк в непропущенных блоках
+    };
+
+    explicit AuditHistory(const std::string& dir);
+    ~AuditHistory();
+
+    AuditHistory(const AuditHistory&) = delete;
+    AuditHistory& operator=(const AuditHistory&) = delete;
+
+    bool isOpen() const { return open_; }
+    uint64_t size() const;
+
+    void append(const std::vector<Record>& records);
+    // Сбрасывает столбцы и публикует число строк; wait — с fsync в нужном порядке
+    void sync(bool wait);
+
+    // Словари
+    int64_t lookup(Column column, const std::string& name) const;   // -1 — нет такого
+    std::string name(Column column, uint32_t id) const;
+
+    // Примитивы
+    Summary summarize(const Filter& filter) const;
+    // Число строк по словарному id столбца (индекс — id)
+    std::vector<uint64_t> countBy(Column column, const Filter& filter) const;
+    // Число строк в buckets интервалах по bucket_ms, начиная с start_ms
+    std::vector<uint64_t> timeline(const Filter& filter, int64_t start_ms, int64_t bucket_ms, size_t buckets) const;
+    // Гистограмма риска: edges по возрастанию, edges.size() + 1 корзин
+    std::vector<uint64_t> riskHistogram(const Filter& filter, const std::vector<float>& edges) const;
+
+private:
+    struct Zone {
+        int64_t min_ms = std::numeric_limits<int64_t>::max();
+        int64_t max_ms = std::numeric_limits<int64_t>::min();
+    };
+
+    struct Dictionary {
+        std::vector<std::string> names;
+        std::unordered_map<std::string, uint32_t> ids;
+        int fd = -1;
+    };
+
+    struct Meta {
+        uint64_t magic;
+        uint64_t rows;
+    };
+
+    static constexpr uint64_t MAGIC = 0x4155444954484931ull;  // "AUDITHI1"
+
+    bool openDictionary(Dictionary& dict, const std::string& path);
+    uint32_t intern(Column column, const std::string& name);
+    bool reserve(size_t rows);
+    void publishRows();     // Meta{MAGIC, rows_} в history.meta
+
+    // Вызывает visit(row) для каждой подходящей строки; mutex_ уже захвачен
+    template<typename Visit>
+    uint64_t scan(const Filter& filter, Visit&& visit) const;
+
+    std::string dir_;
+    bool open_ = false;
+    uint64_t rows_ = 0;
+
+    int meta_fd_ = -1;
+    MappedColumn timestamps_;   // int64 мс
+    MappedColumn agents_;       // uint32
+    MappedColumn actions_;      // uint32
+    MappedColumn tools_;        // uint32
+    MappedColumn risks_;        // float
+    MappedColumn entropies_;    // float
+    MappedColumn allowed_;      // uint8
+
+    Dictionary dicts_[DICTIONARIES];
+    std::vector<Zone> zones_;
+
+    mutable std::shared_mutex mutex_;
+};
@@ -0,0 +1,279 @@
+#include "AuditRollups.hpp"
+#include <algorithm>
+#include <cctype>
+#include <ctime>
+
+namespace {
+    void bump(std::unordered_map<std::string, int>& counts, const std::string& key, int by = 1) {
+        auto it = counts.find(key);
+        if (it != counts.end()) {
+            it->second += by;
+        } else if (counts.size() < AuditRollups::MAX_KEYS) {
+            counts.emplace(key, by);
+        } else {
+            counts["other"] += by;
+        }
+    }
+
+    void mergeCounts(std::unordered_map<std::string, int>& into, const std::unordered_map<std::string, int>& from) {
+        for (const auto& [key, count] : from) {
+            into[key] += count;
+        }
+    }
+
+    int64_t epochSeconds(std::chrono::system_clock::time_point time) {
+        return static_cast<int64_t>(std::chrono::system_clock::to_time_t(time));
+    }
+}
+
+// ============================================================================
+// КОРЗИНА
+// ============================================================================
+
+void RollupBucket::add(const RollupSample& sample) {
+    total++;
+    if (sample.allowed) {
+        successful++;
+    } else {
+        blocked++;
+    }
+
+    risk_sum += sample.hallucination_risk;
+    max_risk = std::max(max_risk, sample.hallucination_risk);
+    entropy_sum += sample.entropy;
+    min_entropy = std::min(min_entropy, sample.entropy);
+    max_entropy = std::max(max_entropy, sample.entropy);
+
+    bump(actions_by_type, sample.action_type);
+    if (!sample.tool_name.empty()) {
+        bump(tool_usage, sample.tool_name);
+    }
+    if (!sample.reason.empty() && !sample.allowed) {
+        bump(constraint_violations, sample.reason);
+    }
+}
+
+void RollupBucket::merge(const RollupBucket& other) {
+    if (other.total == 0) return;
+    total += other.total;
+    successful += other.successful;
+    blocked += other.blocked;
+    warnings += other.warnings;
+    risk_sum += other.risk_sum;
+    max_risk = std::max(max_risk, other.max_risk);
+    entropy_sum += other.entropy_sum;
+    min_entropy = std::min(min_entropy, other.min_entropy);
+    max_entropy = std::max(max_entropy, other.max_entropy);
+    mergeCounts(actions_by_type, other.actions_by_type);
+    mergeCounts(tool_usage, other.tool_usage);
+    mergeCounts(constraint_violations, other.constraint_violations);
+}
+
+AggregatedStats RollupBucket::toStats() const {
+    AggregatedStats stats;
+    stats.total_actions = total;
+    stats.successful_actions = successful;
+    stats.blocked_actions = blocked;
+    stats.warnings = warnings;
+    if (total > 0) {
+        stats.avg_hallucination_risk = static_cast<float>(risk_sum / total);
+        stats.avg_entropy = static_cast<float>(entropy_sum / total);
+    }
+    stats.max_hallucination_risk = max_risk;
+    stats.min_entropy = min_entropy;
+    stats.max_entropy = max_entropy;
+    stats.actions_by_type = actions_by_type;
+    stats.tool_usage = tool_usage;
+    stats.constraint_violations = constraint_violations;
+    return stats;
+}
+
+nlohmann::json RollupBucket::toJson() const {
+    nlohmann::json j;
+    j["unit"] = unit;
+    j["total"] = total;
+    j["successful"] = successful;
+    j["blocked"] = blocked;
+    j["warnings"] = warnings;
+    j["risk_sum"] = risk_sum;
+    j["max_risk"] = max_risk;
+    j["entropy_sum"] = entropy_sum;
+    j["min_entropy"] = min_entropy;
+    j["max_entropy"] = max_entropy;
+    j["actions_by_type"] = actions_by_type;
+    j["tool_usage"] = tool_usage;
+    j["constraint_violations"] = constraint_violations;
+    return j;
+}
+
+RollupBucket RollupBucket::fromJson(const nlohmann::json& j) {
+    RollupBucket bucket;
+    bucket.unit = j.value("unit", int64_t{-1});
+    bucket.total = j.value("total", 0);
+    bucket.successful = j.value("successful", 0);
+    bucket.blocked = j.value("blocked", 0);
+    bucket.warnings = j.value("warnings", 0);
+    bucket.risk_sum = j.value("risk_sum", 0.0);
+    bucket.max_risk = j.value("max_risk", 0.0f);
+    bucket.entropy_sum = j.value("entropy_sum", 0.0);
+    bucket.min_entropy = j.value("min_entropy", 1.0f);
+    bucket.max_entropy = j.value("max_entropy", 0.0f);
+    if (j.contains("actions_by_type")) {
+        bucket.actions_by_type = j["actions_by_type"].get<std::unordered_map<std::string, int>>();
+    }
+    if (j.contains("tool_usage")) {
+        bucket.tool_usage = j["tool_usage"].get<std::unordered_map<std::string, int>>();
+    }
+    if (j.contains("constraint_violations")) {
+        bucket.constraint_violations = j["constraint_violations"].get<std::unordered_map<std::string, int>>();
+    }
+    return bucket;
+}
+
+// ============================================================================
+// КОЛЬЦА
+// ============================================================================
+
+AuditRollups::AuditRollups() {
+    for (int tier = 0; tier < TIERS; ++tier) {
+        rings_[tier].resize(CAPACITY[tier]);
+    }
+}
+
+void AuditRollups::add(const RollupSample& sample) {
+    const int64_t seconds = epochSeconds(sample.timestamp);
+    if (seconds < 0) return;
+
+    for (int tier = 0; tier < TIERS; ++tier) {
+        const int64_t unit = seconds / UNIT_SECONDS[tier];
+        RollupBucket& slot = rings_[tier][static_cast<size_t>(unit) % CAPACITY[tier]];
+        if (slot.unit > unit) continue;     // запоздалое действие: его корзину уже вытеснили
+        if (slot.unit < unit) {
+            slot = RollupBucket();
+            slot.unit = unit;
+        }
+        slot.add(sample);
+    }
+}
+
+const RollupBucket* AuditRollups::bucket(int tier, int64_t unit) const {
+    if (unit < 0) return nullptr;
+    const RollupBucket& slot = rings_[tier][static_cast<size_t>(unit) % CAPACITY[tier]];
+    return slot.unit == unit ? &slot : nullptr;
+}
+
+AggregatedStats AuditRollups::query(std::chrono::system_clock::time_point start,
+                                    std::chrono::system_clock::time_point end) const {
+    const int64_t now = epochSeconds(std::chrono::system_clock::now());
+    auto covered = [now](int tier, int64_t unit) {
+        return unit > now / UNIT_SECONDS[tier] - static_cast<int64_t>(CAPACITY[tier]);
+    };
+
+    // Старше кольца суток данных нет; t — начало ещё не собранного куска окна
+    const int64_t oldest = (now / UNIT_SECONDS[DAY] - static_cast<int64_t>(CAPACITY[DAY]) + 1) * UNIT_SECONDS[DAY];
+    const int64_t last = epochSeconds(end);
+    int64_t t = std::max(epochSeconds(start), oldest);
+    t -= t % UNIT_SECONDS[MINUTE];
+
+    RollupBucket total;
+    while (t <= last) {
+        // Самая крупная корзина, начинающаяся в t и целиком лежащая в окне;
+        // текущая минута берётся и неполной
+        int tier = DAY;
+        for (; tier >= MINUTE; --tier) {
+            const int64_t len = UNIT_SECONDS[tier];
+            if (t % len == 0 && (tier == MINUTE || t + len - 1 <= last) && covered(tier, t / len)) break;
+        }
+        // Минуты уже вытеснены: край окна округляется до накрывающего часа или суток
+        if (tier < MINUTE) {
+            tier = covered(HOUR, t / UNIT_SECONDS[HOUR]) ? HOUR : DAY;
+        }
+
+        const int64_t len = UNIT_SECONDS[tier];
+        if (const RollupBucket* b = bucket(tier, t / len)) {
+            total.merge(*b);
+        }
+        t = (t / len + 1) * len;
+    }
+
+    AggregatedStats stats = total.toStats();
+    stats.start_time = start;
+    stats.end_time = end;
+    return stats;
+}
+
+bool AuditRollups::parsePeriod(const std::string& period, std::chrono::seconds& window) {
+    using namespace std::chrono;
+    if (period == "5h") { window = hours(5); return true; }
+    if (period == "12h") { window = hours(12); return true; }
+    if (period == "24h") { window = hours(24); return true; }
+    if (period == "week") { window = hours(168); return true; }
+    if (period == "month") { window = hours(720); return true; }
+    if (period == "year") { window = hours(8760); return true; }
+
+    // Произвольное окно: число и единица m/h/d/w
+    if (period.size() < 2 || period.size() > 8) return false;
+    int64_t count = 0;
+    for (size_t i = 0; i + 1 < period.size(); ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(period[i]))) return false;
+        count = count * 10 + (period[i] - '0');
+    }
+    if (count <= 0) return false;
+
+    int64_t unit_seconds = 0;
+    switch (period.back()) {
+        case 'm': unit_seconds = 60; break;
+        case 'h': unit_seconds = 3600; break;
+        case 'd': unit_seconds = 86400; break;
+        case 'w': unit_seconds = 7 * 86400; break;
+        default: return false;
+    }
+    window = std::min(seconds(count * unit_seconds), maxWindow());
+    return true;
+}
+
+std::vector<std::string> AuditRollups::namedPeriods() {
+    return {"5h", "12h", "24h", "week", "month", "year"};
+}
+
+size_t AuditRollups::bucketCount() const {
+    size_t count = 0;
+    for (const auto& ring : rings_) {
+        for (const auto& bucket : ring) {
+            if (bucket.unit >= 0) ++count;
+        }
+    }
+    return count;
+}
+
+const char* AuditRollups::tierName(int tier) {
+    switch (tier) {
+        case MINUTE: return "minute";
+        case HOUR: return "hour";
+        default: return "day";
+    }
+}
+
+nlohmann::json AuditRollups::toJson() const {
+    nlohmann::json j;
+    for (int tier = 0; tier < TIERS; ++tier) {
+        nlohmann::json buckets = nlohmann::json::array();
+        for (const auto& bucket : rings_[tier]) {
+            if (bucket.unit >= 0) buckets.push_back(bucket.toJson());
+        }
+        j[tierName(tier)] = std::move(buckets);
+    }
+    return j;
+}
+
+void AuditRollups::fromJson(const nlohmann::json& j) {
+    for (int tier = 0; tier < TIERS; ++tier) {
+        if (!j.contains(tierName(tier)) || !j[tierName(tier)].is_array()) continue;
+        for (const auto& item : j[tierName(tier)]) {
+            RollupBucket bucket = RollupBucket::fromJson(item);
+            if (bucket.unit < 0) continue;
+            RollupBucket& slot = rings_[tier][static_cast<size_t>(bucket.unit) % CAPACITY[tier]];
+            if (slot.unit < bucket.unit) slot = std::move(bucket);
+        }
+    }
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+// ============================================================================
+// СИСТЕМА АГРЕГИРОВАННОГО ЛОГИРОВАНИЯ
+// ============================================================================
+
+/**
+ * @struct AggregatedStats
+ * @brief Агрегированная статистика за период
+ */
+struct AggregatedStats {
+    std::string period;  // "5h", "12h", "24h", "week", "month", "year" или произвольное "90m", "3d"
+    std::chrono::system_clock::time_point start_time;
+    std::chrono::system_clock::time_point end_time;
+
+    // Счётчики
+    int total_actions = 0;
+    int successful_actions = 0;
+    int blocked_actions = 0;
+    int warnings = 0;
+
+    // Риски и энтропия
+    float avg_hallucination_risk = 0.0f;
+    float max_hallucination_risk = 0.0f;
+    float avg_entropy = 0.0f;
+    float min_entropy = 1.0f;
+    float max_entropy = 0.0f;
+
+    // По типам действий
+    std::unordered_map<std::string, int> actions_by_type;
+
+    // По инструментам
+    std::unordered_map<std::string, int> tool_usage;
+
+    // Ограничения
+    std::unordered_map<std::string, int> constraint_violations;
+
+    // Конвертация в JSON
+    nlohmann::json toJson() const {
+        nlohmann::json j;
+        j["period"] = period;
+        j["start_time"] = std::chrono::system_clock::to_time_t(start_time);
+        j["end_time"] = std::chrono::system_clock::to_time_t(end_time);
+        j["total_actions"] = total_actions;
+        j["successful_actions"] = successful_actions;
+        j["blocked_actions"] = blocked_actions;
+        j["warnings"] = warnings;
+        j["avg_hallucination_risk"] = avg_hallucination_risk;
+        j["max_hallucination_risk"] = max_hallucination_risk;
+        j["avg_entropy"] = avg_entropy;
+        j["min_entropy"] = min_entropy;
+        j["max_entropy"] = max_entropy;
+        j["actions_by_type"] = actions_by_type;
+        j["tool_usage"] = tool_usage;
+        j["constraint_violations"] = constraint_violations;
+        return j;
+    }
+};
+
+/**
+ * @struct RollupSample
+ * @brief Одно проверенное действие, как его видят свёртки
+ */
+struct RollupSample {
+    std::chrono::system_clock::time_point timestamp;
+    std::string action_type;
+    std::string tool_name;
+    std::string reason;         // причина блокировки (только для !allowed)
+    bool allowed = true;
+    float hallucination_risk = 0.0f;
+    float entropy = 0.0f;
+};
+
+/**
+ * @struct RollupBucket
+ * @brief Частичная сумма за одну минуту, час или сутки
+ *
+ * Хранятся суммы, а не средние: корзины складываются без потери точности,
+ * средние считаются один раз в toStats().
+ */
+struct RollupBucket {
+    int64_t unit = -1;          // номер минуты/часа/суток от эпохи (UTC); -1 — пусто
+    int total = 0;
+    int successful = 0;
+    int blocked = 0;
+    int warnings = 0;
+    double risk_sum = 0.0;
+    float max_risk = 0.0f;
+    double entropy_sum = 0.0;
+    float min_entropy = 1.0f;
+    float max_entropy = 0.0f;
+    std::unordered_map<std::string, int> actions_by_type;
+    std::unordered_map<std::string, int> tool_usage;
+    std::unordered_map<std::string, int> constraint_violations;
+
+    void add(const RollupSample& sample);
+    void merge(const RollupBucket& other);
+    AggregatedStats toStats() const;
+
+    nlohmann::json toJson() const;
+    static RollupBucket fromJson(const nlohmann::json& j);
+};
+
+/**
+ * @class AuditRollups
+ * @brief Иерархические свёртки журнала аудита: минуты → часы → сутки в кольцах
+ *
+ * Логика:
+ * - каждое действие добавляется сразу в корзину своей минуты, часа и суток;
+ *   слот кольца — unit % CAPACITY, слот с другим unit считается пустым,
+ *   поэтому старые данные истекают сами, а память не зависит от нагрузки
+ * - окно [start, end] собирается из самых крупных корзин, целиком лежащих в нём:
+ *   O(сутки + 2·23 часа + 2·59 минут) слияний для любого окна
+ * - край окна старше покрытия минут (сутки) округляется до часа,
+ *   старше покрытия часов (35 суток) — до суток
+ * - число разных ключей в картах корзины ограничено MAX_KEYS, остальное — в "other"
+ */
+class AuditRollups {
+public:
+    enum Tier { MINUTE, HOUR, DAY, TIERS };
+
+    static constexpr std::array<int64_t, TIERS> UNIT_SECONDS = {60, 3600, 86400};
+    static constexpr std::array<size_t, TIERS> CAPACITY = {1440, 840, 400};
+    static constexpr size_t MAX_KEYS = 64;
+
+    AuditRollups();
+
+    void add(const RollupSample& sample);
+
+    // Статистика за [start, end]
+    AggregatedStats query(std::chrono::system_clock::time_point start,
+                          std::chrono::system_clock::time_point end) const;
+
+    // Самое длинное окно, которое ещё покрыто (кольцо суток)
+    static std::chrono::seconds maxWindow() {
+        return std::chrono::seconds(UNIT_SECONDS[DAY] * static_cast<int64_t>(CAPACITY[DAY]));
+    }
+
+    // "5h", "12h", "24h", "week", "month", "year" или число с единицей m/h/d/w
+    static bool parsePeriod(const std::string& period, std::chrono::seconds& window);
+    static std::vector<std::string> namedPeriods();
+
+    size_t bucketCount() const;     // непустых корзин во всех кольцах
+
+    nlohmann::json toJson() const;
+    void fromJson(const nlohmann::json& j);
+
+private:
+    static const char* tierName(int tier);
+
+    // Корзина unit, если она ещё в кольце; иначе nullptr
+    const RollupBucket* bucket(int tier, int64_t unit) const;
+
+    std::array<std::vector<RollupBucket>, TIERS> rings_;
+};
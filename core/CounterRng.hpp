@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+
+// --------------------
+// Счётчиковый генератор случайных чисел (SplitMix64)
+// --------------------
+/**
+ * @class CounterRng
+ * @brief Случайное число как чистая функция ключа (seed, group, stream, step, neuron, index)
+ *
+ * Логика:
+ * - состояния нет: одно и то же значение ключа всегда даёт одно и то же число,
+ *   поэтому группы берут числа независимо, без блокировок и без влияния
+ *   порядка обхода групп
+ * - stream разделяет назначения (начальные веса, нейрогенез, ...), чтобы
+ *   одинаковые (step, neuron, index) разных назначений не коррелировали
+ * - ключ сворачивается цепочкой финализаторов SplitMix64; для инициализации
+ *   весов и мутаций этого качества достаточно
+ * - повтор сессии: тот же seed и та же последовательность шагов дают
+ *   побитово те же веса
+ */
+class CounterRng {
+public:
+    enum Stream : uint32_t {
+        INIT_WEIGHTS = 1,   // начальные веса группы
+        NEUROGENESIS = 2,   // мутация связей нового нейрона
+        INHERIT      = 3,   // наследование паттерна из завещания
+        FIELD_MUTATION = 4  // NeuralFieldSystem::applyTargetedMutation
+    };
+
+    CounterRng() = default;
+    CounterRng(uint64_t seed, uint32_t group)
+        : key_(mix(mix(seed ^ GOLDEN) ^ (static_cast<uint64_t>(group) * GOLDEN + 1))),
+          seed_(seed), group_(group) {}
+
+    uint64_t seed() const { return seed_; }
+    uint32_t group() const { return group_; }
+
+    uint64_t bits(Stream s, int64_t step, uint32_t neuron, uint32_t index) const {
+        uint64_t h = mix(key_ ^ (static_cast<uint64_t>(s) * GOLDEN));
+        h = mix(h ^ static_cast<uint64_t>(step));
+        h = mix(h ^ ((static_cast<uint64_t>(neuron) << 32) | index));
+        return h;
+    }
+
+    // Равномерно в [lo, hi)
+    double uniform(Stream s, int64_t step, uint32_t neuron, uint32_t index,
+                   double lo, double hi) const {
+        const double u = static_cast<double>(bits(s, step, neuron, index) >> 11) * 0x1.0p-53;
+        return lo + (hi - lo) * u;
+    }
+
+    // Равномерно в [0, n)
+    uint32_t below(Stream s, int64_t step, uint32_t neuron, uint32_t index, uint32_t n) const {
+        return static_cast<uint32_t>(((bits(s, step, neuron, index) >> 32) * n) >> 32);
+    }
+
+private:
+    static constexpr uint64_t GOLDEN = 0x9E3779B97F4A7C15ull;
+
+    // Финализатор SplitMix64
+    static uint64_t mix(uint64_t z) {
+        z += GOLDEN;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t key_ = 0;
+    uint64_t seed_ = 0;
+    uint32_t group_ = 0;
+};
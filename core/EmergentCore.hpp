@@ -10,6 +10,7 @@
 #include <cassert>
 #include <random>
 #include <memory>
+#include "FieldTopology.hpp"
 
 // Forward declarations
 class NeuralGroup;
@@ -397,7 +398,16 @@ public:
     const std::deque<NeuroMemoryRecord>& getLTM() const { return ltm_; }
     const std::deque<NeuroMemoryRecord>& getSTM() const { return stm_; }
     const LTMCache& getCache() const { return ltm_cache_; }
-    
+
+    // ===== ВОССТАНОВЛЕНИЕ ИЗ СНИМКА =====
+    void restore(std::deque<NeuroMemoryRecord> stm, std::deque<NeuroMemoryRecord> ltm) {
+        stm_ = std::move(stm);
+        ltm_ = std::move(ltm);
+        enforceSTMCapacity();
+        enforceLTMCapacity();
+        ltm_cache_.rebuild(ltm_);
+    }
+
     // ===== ПОИСК ПО ТЕГУ =====
     std::vector<const NeuroMemoryRecord*> findByTag(const std::string& tag) const {
         std::vector<const NeuroMemoryRecord*> result;
@@ -507,18 +517,36 @@ private:
 
 class PredictionUnit {
 public:
-    static constexpr int N = 32; // NUM_GROUPS
-    
-    PredictionUnit() {
-        weights_.assign(N * N, 0.f);
-        bias_.assign(N, 0.f);
-        prev_state_.assign(N, 0.5f);
+    static constexpr int DEFAULT_N = FieldTopology::DEFAULT_NUM_GROUPS;
+    
+    explicit PredictionUnit(int n = DEFAULT_N) { resize(n); }
+    
+    // Смена числа групп сбрасывает обученную модель
+    void resize(int n) {
+        n_ = n;
+        weights_.assign(n * n, 0.f);
+        bias_.assign(n, 0.f);
+        prev_state_.assign(n, 0.5f);
+        last_total_error_ = 0.f;
+        step_count_ = 0;
     }
+    int size() const { return n_; }
     
     // Предсказание на основе групповых активностей
     std::vector<float> step(const std::vector<float>& current_state) {
-        assert((int)current_state.size() == N);
-        
+        if ((int)current_state.size() != n_) resize((int)current_state.size());
+        if (n_ == 0) return {};
+        // Для 16/32/64/128 групп размер известен при компиляции
+        return dispatchSize(n_, [&](auto n) { return stepImpl(n, current_state); });
+    }
+    
+    float getLastError() const { return last_total_error_; }
+    float getSurprise() const { return std::tanh(last_total_error_ * 3.f); }
+    
+private:
+    template<typename Size>
+    std::vector<float> stepImpl(Size sz, const std::vector<float>& current_state) {
+        const int N = sz;
         std::vector<float> predicted(N, 0.f);
         for (int j = 0; j < N; ++j) {
             float val = bias_[j];
@@ -561,10 +589,7 @@ public:
         return reward;
     }
     
-    float getLastError() const { return last_total_error_; }
-    float getSurprise() const { return std::tanh(last_total_error_ * 3.f); }
-    
-private:
+    int n_ = 0;
     std::vector<float> weights_;
     std::vector<float> bias_;
     std::vector<float> prev_state_;
@@ -0,0 +1,183 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+// --------------------
+// Инкрементальные гистограммы энтропии поля
+// --------------------
+/**
+ * @class EntropyTracker
+ * @brief Гистограммы phi на 32 бина (getUnifiedEntropy) и 20 бинов (computeSystemEntropy)
+ *
+ * Логика:
+ * - для каждого нейрона хранится текущий бин в обеих гистограммах; при новом phi
+ *   группы меняются только счётчики нейронов, сменивших бин (перенос бина)
+ * - updateGroup(g) пишет переносы в дельты своей группы, поэтому группы можно
+ *   обновлять параллельно; commit() последовательно переносит дельты изменённых
+ *   групп в общие гистограммы
+ * - энтропии считаются по гистограммам лениво, один раз после commit() с переносами;
+ *   повторные чтения за шаг — O(1)
+ * - verify() строит гистограммы заново по плоскому phi и сравнивает: счётчики
+ *   целые, формула та же, поэтому совпадение точное
+ */
+class EntropyTracker {
+public:
+    static constexpr int UNIFIED_BINS = 32;
+    static constexpr int SYSTEM_BINS  = 20;
+
+    EntropyTracker() = default;
+    EntropyTracker(int groups, int group_size) { resize(groups, group_size); }
+
+    // Все нейроны — в нулевом бине (phi = 0)
+    void resize(int groups, int group_size) {
+        groups_ = groups;
+        group_size_ = group_size;
+        const size_t total = static_cast<size_t>(groups) * group_size;
+        bin_unified_.assign(total, 0);
+        bin_system_.assign(total, 0);
+        delta_unified_.assign(static_cast<size_t>(groups) * UNIFIED_BINS, 0);
+        delta_system_.assign(static_cast<size_t>(groups) * SYSTEM_BINS, 0);
+        group_moved_.assign(groups, 0);
+        hist_unified_.fill(0);
+        hist_system_.fill(0);
+        hist_unified_[0] = static_cast<int>(total);
+        hist_system_[0] = static_cast<int>(total);
+        entropy_dirty_ = true;
+        moves_ = 0;
+    }
+
+    static int unifiedBin(double phi) {
+        return std::clamp(static_cast<int>(phi * UNIFIED_BINS), 0, UNIFIED_BINS - 1);
+    }
+    static int systemBin(double phi) {
+        return std::clamp(static_cast<int>(phi * SYSTEM_BINS), 0, SYSTEM_BINS - 1);
+    }
+
+    // Новый phi группы g (group_size значений). Трогает только данные группы g.
+    void updateGroup(int g, const double* phi) {
+        const size_t base = static_cast<size_t>(g) * group_size_;
+        uint8_t* bu = bin_unified_.data() + base;
+        uint8_t* bs = bin_system_.data() + base;
+        int* du = delta_unified_.data() + static_cast<size_t>(g) * UNIFIED_BINS;
+        int* ds = delta_system_.data() + static_cast<size_t>(g) * SYSTEM_BINS;
+        int moved = 0;
+
+        for (int i = 0; i < group_size_; ++i) {
+            const int u = unifiedBin(phi[i]);
+            const int s = systemBin(phi[i]);
+            if (u != bu[i]) {
+                du[bu[i]]--;
+                du[u]++;
+                bu[i] = static_cast<uint8_t>(u);
+                ++moved;
+            }
+            if (s != bs[i]) {
+                ds[bs[i]]--;
+                ds[s]++;
+                bs[i] = static_cast<uint8_t>(s);
+                ++moved;
+            }
+        }
+        if (moved) group_moved_[g] = 1;
+    }
+
+    // Перенос дельт в общие гистограммы (последовательно, после updateGroup)
+    void commit() {
+        for (int g = 0; g < groups_; ++g) {
+            if (!group_moved_[g]) continue;
+            int* du = delta_unified_.data() + static_cast<size_t>(g) * UNIFIED_BINS;
+            int* ds = delta_system_.data() + static_cast<size_t>(g) * SYSTEM_BINS;
+            for (int b = 0; b < UNIFIED_BINS; ++b) {
+                hist_unified_[b] += du[b];
+                moves_ += std::max(du[b], 0);
+                du[b] = 0;
+            }
+            for (int b = 0; b < SYSTEM_BINS; ++b) {
+                hist_system_[b] += ds[b];
+                moves_ += std::max(ds[b], 0);
+                ds[b] = 0;
+            }
+            group_moved_[g] = 0;
+            entropy_dirty_ = true;
+        }
+    }
+
+    // Нормированная энтропия (log2 / log2(32)) в [0, 1]
+    double unifiedEntropy() const { refreshEntropy(); return unified_entropy_; }
+    // Энтропия в натуральных логарифмах
+    double systemEntropy() const { refreshEntropy(); return system_entropy_; }
+
+    const std::array<int, UNIFIED_BINS>& unifiedHistogram() const { return hist_unified_; }
+    const std::array<int, SYSTEM_BINS>& systemHistogram() const { return hist_system_; }
+
+    // Суммарное число переносов (нетто по бинам групп) с последнего resize
+    uint64_t binMoves() const { return moves_; }
+
+    // Сверка с полным пересчётом по плоскому phi (после commit())
+    bool verify(const std::vector<double>& flat_phi) const {
+        if (flat_phi.size() != bin_unified_.size()) return false;
+        std::array<int, UNIFIED_BINS> hu{};
+        std::array<int, SYSTEM_BINS> hs{};
+        for (double phi : flat_phi) {
+            hu[unifiedBin(phi)]++;
+            hs[systemBin(phi)]++;
+        }
+        if (hu != hist_unified_ || hs != hist_system_) return false;
+        const double total = static_cast<double>(flat_phi.size());
+        return normalizedEntropy(hu, total) == unifiedEntropy() &&
+               naturalEntropy(hs, total) == systemEntropy();
+    }
+
+private:
+    template<size_t B>
+    static double naturalEntropy(const std::array<int, B>& hist, double total) {
+        double H = 0.0;
+        for (int count : hist) {
+            if (count > 0) {
+                double p = static_cast<double>(count) / total;
+                H -= p * std::log(p);
+            }
+        }
+        return H;
+    }
+
+    template<size_t B>
+    static double normalizedEntropy(const std::array<int, B>& hist, double total) {
+        double H = 0.0;
+        for (int count : hist) {
+            if (count > 0) {
+                double p = count / total;
+                H -= p * std::log2(p);
+            }
+        }
+        return std::clamp(H / std::log2(static_cast<double>(B)), 0.0, 1.0);
+    }
+
+    void refreshEntropy() const {
+        if (!entropy_dirty_) return;
+        const double total = static_cast<double>(bin_unified_.size());
+        if (total > 0) {
+            unified_entropy_ = normalizedEntropy(hist_unified_, total);
+            system_entropy_ = naturalEntropy(hist_system_, total);
+        }
+        entropy_dirty_ = false;
+    }
+
+    int groups_ = 0;
+    int group_size_ = 0;
+    std::vector<uint8_t> bin_unified_;     // текущий бин нейрона
+    std::vector<uint8_t> bin_system_;
+    std::vector<int> delta_unified_;       // UNIFIED_BINS дельт на группу
+    std::vector<int> delta_system_;        // SYSTEM_BINS дельт на группу
+    std::vector<uint8_t> group_moved_;     // 1 — у группы есть непереданные дельты
+    std::array<int, UNIFIED_BINS> hist_unified_{};
+    std::array<int, SYSTEM_BINS>  hist_system_{};
+    uint64_t moves_ = 0;
+
+    mutable bool entropy_dirty_ = true;
+    mutable double unified_entropy_ = 0.0;
+    mutable double system_entropy_ = 0.0;
+};
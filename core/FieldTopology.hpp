@@ -0,0 +1,110 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// --------------------
+// Топология поля: число групп, размер группы, роли групп
+// --------------------
+/**
+ * @struct FieldTopology
+ * @brief Размеры поля, задаваемые во время выполнения (конфиг / командная строка)
+ *
+ * Роли групп (input, sensory, motor, ...) масштабируются пропорционально
+ * исходной раскладке 32 групп: 1 / 3 / 4 / 8 / 6 / 6 / 4. При 32 группах
+ * индексы совпадают с прежними константами (sensory 1-3, ..., self-model 28-31).
+ */
+struct FieldTopology {
+    static constexpr int DEFAULT_NUM_GROUPS = 32;
+    static constexpr int DEFAULT_GROUP_SIZE = 32;
+    static constexpr int MIN_NUM_GROUPS = 8;    // каждой роли хотя бы одна группа
+    static constexpr int MIN_GROUP_SIZE = 16;   // эмбеддинг действия: 4 блока по ≥4
+    static constexpr int MAX_GROUP_SIZE = 1024; // NeuralGroup::MAX_NEURONS
+
+    int num_groups = DEFAULT_NUM_GROUPS;
+    int group_size = DEFAULT_GROUP_SIZE;
+
+    // Роли: включительные диапазоны [start, end]
+    int input_group = 0;
+    int sensory_start = 1,      sensory_end = 3;
+    int motor_start = 4,        motor_end = 7;
+    int associative_start = 8,  associative_end = 15;
+    int semantic_start = 16,    semantic_end = 21;
+    int context_start = 22,     context_end = 27;
+    int self_model_start = 28,  self_model_end = 31;
+
+    FieldTopology() = default;
+
+    FieldTopology(int groups, int size) : num_groups(groups), group_size(size) {
+        if (groups < MIN_NUM_GROUPS) {
+            throw std::invalid_argument("FieldTopology: num_groups < " + std::to_string(MIN_NUM_GROUPS));
+        }
+        if (size < MIN_GROUP_SIZE || size > MAX_GROUP_SIZE) {
+            throw std::invalid_argument("FieldTopology: group_size out of [" +
+                                        std::to_string(MIN_GROUP_SIZE) + ", " +
+                                        std::to_string(MAX_GROUP_SIZE) + "]");
+        }
+        layoutRoles();
+    }
+
+    int totalNeurons() const { return num_groups * group_size; }
+
+    static int count(int start, int end) { return end - start + 1; }
+
+private:
+    void layoutRoles() {
+        // Границы ролей в раскладке на 32 группы
+        static constexpr std::array<int, 8> BOUNDS = {0, 1, 4, 8, 16, 22, 28, 32};
+        std::array<int, 8> b{};
+        for (size_t k = 0; k < BOUNDS.size(); ++k) {
+            b[k] = (BOUNDS[k] * num_groups + DEFAULT_NUM_GROUPS / 2) / DEFAULT_NUM_GROUPS;
+        }
+        // Не меньше одной группы на роль
+        for (size_t k = 1; k < b.size(); ++k) {
+            b[k] = std::max(b[k], b[k - 1] + 1);
+        }
+        for (size_t k = b.size() - 1; k > 0; --k) {
+            b[k - 1] = std::min(b[k - 1], b[k] - 1);
+        }
+
+        input_group = b[0];
+        sensory_start = b[1];      sensory_end = b[2] - 1;
+        motor_start = b[2];        motor_end = b[3] - 1;
+        associative_start = b[3];  associative_end = b[4] - 1;
+        semantic_start = b[4];     semantic_end = b[5] - 1;
+        context_start = b[5];      context_end = b[6] - 1;
+        self_model_start = b[6];   self_model_end = b[7] - 1;
+    }
+};
+
+// --------------------
+// Компиляционные быстрые пути для типичных размеров
+// --------------------
+// dispatchSize(n, f) вызывает f(FixedSize<N>{}) для N ∈ {16, 32, 64, 128}
+// и f(DynamicSize{n}) иначе. Внутри f размер берётся как `int(sz)` —
+// для FixedSize это константа, и циклы по ней разворачиваются и векторизуются.
+
+template<int N>
+struct FixedSize {
+    static constexpr bool fixed = true;
+    constexpr operator int() const { return N; }
+};
+
+struct DynamicSize {
+    static constexpr bool fixed = false;
+    int n;
+    operator int() const { return n; }
+};
+
+template<typename F>
+decltype(auto) dispatchSize(int n, F&& f) {
+    switch (n) {
+        case 16:  return std::forward<F>(f)(FixedSize<16>{});
+        case 32:  return std::forward<F>(f)(FixedSize<32>{});
+        case 64:  return std::forward<F>(f)(FixedSize<64>{});
+        case 128: return std::forward<F>(f)(FixedSize<128>{});
+        default:  return std::forward<F>(f)(DynamicSize{n});
+    }
+}
@@ -0,0 +1,161 @@
+#include "InterGroupWeights.hpp"
+#include <algorithm>
+
+InterGroupWeights::InterGroupWeights(int n, InterWeightStorage::Type storage)
+    : storage_(storage) {
+    reset(n);
+}
+
+void InterGroupWeights::reset(int n) {
+    build(n, {});
+}
+
+bool InterGroupWeights::chooseDense(size_t nnz) const {
+    switch (storage_) {
+        case InterWeightStorage::DENSE:  return true;
+        case InterWeightStorage::SPARSE: return false;
+        default: {
+            const double cells = static_cast<double>(n_) * std::max(n_ - 1, 1);
+            return static_cast<double>(nnz) > AUTO_DENSE_FILL * cells;
+        }
+    }
+}
+
+void InterGroupWeights::build(int n, std::vector<Entry> entries) {
+    n_ = n;
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [n](const Entry& e) {
+        return e.from == e.to || e.from < 0 || e.to < 0 || e.from >= n || e.to >= n;
+    }), entries.end());
+    // stable: из повторов пары остаётся последнее значение
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.from != b.from ? a.from < b.from : a.to < b.to;
+    });
+    std::vector<Entry> unique;
+    unique.reserve(entries.size());
+    for (const Entry& e : entries) {
+        if (!unique.empty() && unique.back().from == e.from && unique.back().to == e.to) {
+            unique.back().w = e.w;
+        } else {
+            unique.push_back(e);
+        }
+    }
+
+    row_ptr_.assign(n_ + 1, 0);
+    col_.resize(unique.size());
+    values_.resize(unique.size());
+    for (size_t k = 0; k < unique.size(); ++k) {
+        row_ptr_[unique[k].from + 1]++;
+        col_[k] = unique[k].to;
+        values_[k] = unique[k].w;
+    }
+    for (int i = 0; i < n_; ++i) row_ptr_[i + 1] += row_ptr_[i];
+    dense_ = false;
+
+    if (chooseDense(unique.size())) convert(true);
+}
+
+void InterGroupWeights::setStorage(InterWeightStorage::Type storage) {
+    storage_ = storage;
+    convert(chooseDense(nonZeros()));
+}
+
+void InterGroupWeights::convert(bool dense) {
+    if (dense == dense_) return;
+    if (dense) {
+        std::vector<double> full(static_cast<size_t>(n_) * n_, 0.0);
+        for (int i = 0; i < n_; ++i) {
+            for (int k = row_ptr_[i]; k < row_ptr_[i + 1]; ++k) {
+                full[static_cast<size_t>(i) * n_ + col_[k]] = values_[k];
+            }
+        }
+        values_.swap(full);
+        row_ptr_.clear();
+        col_.clear();
+    } else {
+        // Из плотной матрицы в CSR переходят только ненулевые связи
+        std::vector<int> row_ptr(n_ + 1, 0);
+        std::vector<int> col;
+        std::vector<double> values;
+        for (int i = 0; i < n_; ++i) {
+            const double* row = values_.data() + static_cast<size_t>(i) * n_;
+            for (int j = 0; j < n_; ++j) {
+                if (j != i && row[j] != 0.0) {
+                    col.push_back(j);
+                    values.push_back(row[j]);
+                }
+            }
+            row_ptr[i + 1] = static_cast<int>(col.size());
+        }
+        row_ptr_.swap(row_ptr);
+        col_.swap(col);
+        values_.swap(values);
+    }
+    dense_ = dense;
+}
+
+size_t InterGroupWeights::nonZeros() const {
+    if (!dense_) return col_.size();
+    size_t nnz = 0;
+    forEach([&](int, int, double w) { nnz += (w != 0.0); });
+    return nnz;
+}
+
+double InterGroupWeights::get(int from, int to) const {
+    if (from < 0 || to < 0 || from >= n_ || to >= n_ || from == to) return 0.0;
+    if (dense_) return values_[static_cast<size_t>(from) * n_ + to];
+    auto begin = col_.begin() + row_ptr_[from];
+    auto end = col_.begin() + row_ptr_[from + 1];
+    auto it = std::lower_bound(begin, end, to);
+    return (it != end && *it == to) ? values_[it - col_.begin()] : 0.0;
+}
+
+void InterGroupWeights::set(int from, int to, double w) {
+    if (from < 0 || to < 0 || from >= n_ || to >= n_ || from == to) return;
+    if (dense_) {
+        values_[static_cast<size_t>(from) * n_ + to] = w;
+        return;
+    }
+    auto begin = col_.begin() + row_ptr_[from];
+    auto end = col_.begin() + row_ptr_[from + 1];
+    auto it = std::lower_bound(begin, end, to);
+    const size_t k = it - col_.begin();
+    if (it != end && *it == to) {
+        values_[k] = w;
+        return;
+    }
+    col_.insert(it, to);
+    values_.insert(values_.begin() + k, w);
+    for (int i = from + 1; i <= n_; ++i) row_ptr_[i]++;
+    // AUTO: связей стало достаточно для плотного формата
+    if (chooseDense(col_.size())) convert(true);
+}
+
+void InterGroupWeights::multiply(const double* x, double* y) const {
+    if (dense_) {
+        for (int i = 0; i < n_; ++i) {
+            const double* row = values_.data() + static_cast<size_t>(i) * n_;
+            double sum = 0.0;
+            for (int j = 0; j < n_; ++j) {
+                if (j != i) sum += row[j] * x[j];
+            }
+            y[i] = sum;
+        }
+        return;
+    }
+    for (int i = 0; i < n_; ++i) {
+        double sum = 0.0;
+        for (int k = row_ptr_[i]; k < row_ptr_[i + 1]; ++k) sum += values_[k] * x[col_[k]];
+        y[i] = sum;
+    }
+}
+
+void InterGroupWeights::multiplyTransposed(const double* x, double* y) const {
+    std::fill_n(y, n_, 0.0);
+    forEach([&](int i, int j, double w) { y[j] += w * x[i]; });
+}
+
+double InterGroupWeights::quadraticForm(const double* x) const {
+    double sum = 0.0;
+    forEach([&](int i, int j, double w) { sum += w * x[i] * x[j]; });
+    return sum;
+}
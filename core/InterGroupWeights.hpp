@@ -0,0 +1,136 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @struct InterWeightStorage
+ * @brief Формат хранения межгрупповых весов
+ */
+struct InterWeightStorage {
+    enum Type {
+        AUTO,    // CSR, пока заполнение не выше AUTO_DENSE_FILL, иначе плотная матрица
+        SPARSE,  // всегда CSR
+        DENSE    // всегда плотная матрица n×n
+    };
+
+    static const char* toString(Type t) {
+        switch (t) {
+            case AUTO:   return "auto";
+            case SPARSE: return "sparse";
+            case DENSE:  return "dense";
+            default:     return "unknown";
+        }
+    }
+
+    static Type fromString(const std::string& name) {
+        if (name == "sparse") return SPARSE;
+        if (name == "dense") return DENSE;
+        return AUTO;
+    }
+};
+
+// --------------------
+// Межгрупповые веса: CSR с плотным запасным вариантом
+// --------------------
+/**
+ * @class InterGroupWeights
+ * @brief Матрица w[from][to] связей между группами поля
+ *
+ * Логика:
+ * - в CSR хранятся только структурные связи (то, что заложено топологией
+ *   или добавлено set/add); диагональ не хранится никогда
+ * - multiply / multiplyTransposed / quadraticForm — O(nnz) вместо O(n²);
+ *   обход строк и столбцов по возрастанию, поэтому суммы совпадают
+ *   побитово с плотным проходом (нулевые слагаемые сумму не меняют)
+ * - добавление новой связи в CSR сдвигает хвост массивов — O(nnz);
+ *   массовое построение — build() из списка связей
+ * - формат выбирается при build(): AUTO переходит на плотную матрицу,
+ *   когда CSR перестаёт окупаться
+ */
+class InterGroupWeights {
+public:
+    struct Entry {
+        int from;
+        int to;
+        double w;
+    };
+
+    static constexpr double AUTO_DENSE_FILL = 0.5;
+
+    InterGroupWeights() = default;
+    explicit InterGroupWeights(int n, InterWeightStorage::Type storage = InterWeightStorage::AUTO);
+
+    // Все связи удаляются, формат пересчитывается (для AUTO — по пустой матрице)
+    void reset(int n);
+    // Построение по списку связей; повтор пары — последнее значение, диагональ отбрасывается
+    void build(int n, std::vector<Entry> entries);
+
+    // Смена формата с сохранением связей
+    void setStorage(InterWeightStorage::Type storage);
+    InterWeightStorage::Type storage() const { return storage_; }
+    bool isDense() const { return dense_; }
+
+    int size() const { return n_; }
+    // Структурные связи (для плотной матрицы — все внедиагональные ненулевые)
+    size_t nonZeros() const;
+
+    double get(int from, int to) const;
+    // Запись значения; в CSR при отсутствии связи она добавляется
+    void set(int from, int to, double w);
+
+    // y[i] = Σ_j w[i][j] * x[j]
+    void multiply(const double* x, double* y) const;
+    // y[j] = Σ_i w[i][j] * x[i]
+    void multiplyTransposed(const double* x, double* y) const;
+    // Σ_{i≠j} w[i][j] * x[i] * x[j] (порядок сложения — построчно)
+    double quadraticForm(const double* x) const;
+
+    // f(from, to, w&) по всем хранимым связям, построчно
+    template<typename F>
+    void forEach(F&& f) {
+        if (dense_) {
+            for (int i = 0; i < n_; ++i) {
+                double* row = values_.data() + static_cast<size_t>(i) * n_;
+                for (int j = 0; j < n_; ++j) {
+                    if (j != i) f(i, j, row[j]);
+                }
+            }
+        } else {
+            for (int i = 0; i < n_; ++i) {
+                for (int k = row_ptr_[i]; k < row_ptr_[i + 1]; ++k) f(i, col_[k], values_[k]);
+            }
+        }
+    }
+
+    template<typename F>
+    void forEach(F&& f) const {
+        if (dense_) {
+            for (int i = 0; i < n_; ++i) {
+                const double* row = values_.data() + static_cast<size_t>(i) * n_;
+                for (int j = 0; j < n_; ++j) {
+                    if (j != i) f(i, j, row[j]);
+                }
+            }
+        } else {
+            for (int i = 0; i < n_; ++i) {
+                for (int k = row_ptr_[i]; k < row_ptr_[i + 1]; ++k) f(i, col_[k], values_[k]);
+            }
+        }
+    }
+
+private:
+    bool chooseDense(size_t nnz) const;
+    void convert(bool dense);
+
+    int n_ = 0;
+    InterWeightStorage::Type storage_ = InterWeightStorage::AUTO;
+    bool dense_ = false;
+
+    // CSR: строка i — [row_ptr_[i], row_ptr_[i+1]), столбцы по возрастанию.
+    // Плотный формат: values_ — n×n по строкам, row_ptr_ и col_ пусты.
+    std::vector<int> row_ptr_;
+    std::vector<int> col_;
+    std::vector<double> values_;
+};
@@ -15,34 +15,35 @@ LagrangianAuditor::LagrangianAuditor(const LagrangianAuditorConfig& cfg)
 }
 
 CanonicalState LagrangianAuditor::toCanonical(const std::vector<NeuralGroup>& groups,
-                                               const std::vector<std::vector<double>>& interWeights,
+                                               const std::vector<double>& averages,
+                                               const InterGroupWeights& interWeights,
                                                double dt) {
     const int N = (int)groups.size();
     CanonicalState state;
     state.resize(N);
     
-    // Сохраняем предыдущие q для вычисления p
-    static std::vector<double> prev_q(N, 0.5);
-    static bool first_call = true;
+    // Предыдущие q для вычисления p; первый вызов (или смена числа групп) — p = 0
+    const bool first_call = (int)prev_q_.size() != N;
+    if (first_call) prev_q_.assign(N, 0.5);
     
     for (int i = 0; i < N; ++i) {
         // q = средняя активность группы (позиция)
-        state.q[i] = groups[i].getAverageActivity();
+        state.q[i] = averages[i];
+        // Lagrangian нейронов уже посчитан в evolve() — только читаем
+        state.neural_lagrangian[i] = groups[i].getGroupLagrangian();
         
         if (!first_call) {
             // p = производная q (импульс)
-            state.p[i] = (state.q[i] - prev_q[i]) / dt;
+            state.p[i] = (state.q[i] - prev_q_[i]) / dt;
             // Ограничиваем импульс
             state.p[i] = std::clamp(state.p[i], -10.0, 10.0);
         } else {
             state.p[i] = 0.0;
         }
         
-        prev_q[i] = state.q[i];
+        prev_q_[i] = state.q[i];
     }
     
-    first_call = false;
-    
     // Вычисляем энергию
     state.total_energy = computeTotalEnergy(state, interWeights);
     
@@ -59,17 +60,12 @@ double LagrangianAuditor::computeKineticEnergy(const CanonicalState& state) cons
 }
 
 double LagrangianAuditor::computePotentialEnergy(const CanonicalState& state,
-                                                  const std::vector<std::vector<double>>& interWeights) const {
+                                                  const InterGroupWeights& interWeights) const {
     // V = Σ w_ij * q_i * q_j (взаимодействие групп)
+    // O(nnz): обходятся только хранимые связи
     double potential = 0.0;
-    int N = (int)state.q.size();
-    
-    for (int i = 0; i < N; ++i) {
-        for (int j = 0; j < N; ++j) {
-            if (i != j && i < (int)interWeights.size() && j < (int)interWeights[i].size()) {
-                potential += interWeights[i][j] * state.q[i] * state.q[j];
-            }
-        }
+    if ((int)state.q.size() == interWeights.size()) {
+        potential = interWeights.quadraticForm(state.q.data());
     }
     
     // Добавляем "потенциальную яму" для удержания q в [0,1]
@@ -81,12 +77,12 @@ double LagrangianAuditor::computePotentialEnergy(const CanonicalState& state,
 }
 
 double LagrangianAuditor::computeTotalEnergy(const CanonicalState& state,
-                                              const std::vector<std::vector<double>>& interWeights) const {
+                                              const InterGroupWeights& interWeights) const {
     return computeKineticEnergy(state) + computePotentialEnergy(state, interWeights);
 }
 
 double LagrangianAuditor::computeLagrangian(const CanonicalState& state,
-                                             const std::vector<std::vector<double>>& interWeights) const {
+                                             const InterGroupWeights& interWeights) const {
     // L = T - V
     return computeKineticEnergy(state) - computePotentialEnergy(state, interWeights);
 }
@@ -146,7 +142,7 @@ bool LagrangianAuditor::auditEnergyConservation(const CanonicalState& current_st
 
 float LagrangianAuditor::auditAction(const CanonicalState& before_state,
                                       const CanonicalState& after_state,
-                                      const std::vector<std::vector<double>>& interWeights,
+                                      const InterGroupWeights& interWeights,
                                       double dt) {
     // Вычисляем энергии
     double E_before = computeTotalEnergy(before_state, interWeights);
@@ -186,7 +182,7 @@ float LagrangianAuditor::auditAction(const CanonicalState& before_state,
 
 void LagrangianAuditor::correctState(CanonicalState& state,
                                       double target_energy,
-                                      const std::vector<std::vector<double>>& interWeights) {
+                                      const InterGroupWeights& interWeights) {
     double current_energy = computeTotalEnergy(state, interWeights);
     
     if (target_energy == 0.0) {
@@ -222,18 +218,19 @@ void LagrangianAuditor::correctState(CanonicalState& state,
 
 std::vector<double> LagrangianAuditor::computePotentialGradient(
     const CanonicalState& state,
-    const std::vector<std::vector<double>>& interWeights) const {
+    const InterGroupWeights& interWeights) const {
     
     int N = (int)state.q.size();
     std::vector<double> grad(N, 0.0);
     
-    // ∂V/∂q_i = Σ_j (w_ij + w_ji) * q_j + 20 * (q_i - 0.5)
+    // ∂V/∂q_i = Σ_j (w_ij + w_ji) * q_j + 20 * (q_i - 0.5) = (W q)_i + (Wᵀ q)_i + яма
+    if (N == interWeights.size()) {
+        std::vector<double> wt(N);
+        interWeights.multiply(state.q.data(), grad.data());
+        interWeights.multiplyTransposed(state.q.data(), wt.data());
+        for (int i = 0; i < N; ++i) grad[i] += wt[i];
+    }
     for (int i = 0; i < N; ++i) {
-        for (int j = 0; j < N; ++j) {
-            if (i != j && i < (int)interWeights.size() && j < (int)interWeights[i].size()) {
-                grad[i] += (interWeights[i][j] + interWeights[j][i]) * state.q[j];
-            }
-        }
         // Потенциальная яма
         grad[i] += 20.0 * (state.q[i] - 0.5);
     }
@@ -243,7 +240,7 @@ std::vector<double> LagrangianAuditor::computePotentialGradient(
 
 CanonicalState LagrangianAuditor::hamiltonianStep(
     const CanonicalState& state,
-    const std::vector<std::vector<double>>& interWeights,
+    const InterGroupWeights& interWeights,
     double dt) {
     
     CanonicalState next;
@@ -6,6 +6,7 @@
 #include <cmath>
 #include <algorithm>
 #include <numeric>
+#include "InterGroupWeights.hpp"
 
 class NeuralFieldSystem;
 class NeuralGroup;
@@ -17,6 +18,7 @@ class NeuralGroup;
 struct CanonicalState {
     std::vector<double> q;  // "позиции" — активности групп
     std::vector<double> p;  // "импульсы" — скорости изменения активностей
+    std::vector<double> neural_lagrangian;  // Σ L_i нейронов каждой группы
     double total_energy;     // полная энергия системы
     
     CanonicalState() : total_energy(0.0) {}
@@ -24,6 +26,7 @@ struct CanonicalState {
     void resize(size_t n) {
         q.resize(n, 0.0);
         p.resize(n, 0.0);
+        neural_lagrangian.resize(n, 0.0);
     }
     
     size_t size() const { return q.size(); }
@@ -67,12 +70,14 @@ public:
     /**
      * @brief Преобразование сырых активностей в канонические координаты
      * @param groups Группы нейронов
+     * @param averages Средние активности групп за шаг (q)
      * @param interWeights Межгрупповые веса
      * @param dt Шаг времени
      * @return Каноническое состояние (q, p)
      */
     CanonicalState toCanonical(const std::vector<NeuralGroup>& groups,
-                               const std::vector<std::vector<double>>& interWeights,
+                               const std::vector<double>& averages,
+                               const InterGroupWeights& interWeights,
                                double dt);
     
     /**
@@ -82,7 +87,7 @@ public:
      * @return Значение Lagrangian L = T - V
      */
     double computeLagrangian(const CanonicalState& state,
-                             const std::vector<std::vector<double>>& interWeights) const;
+                             const InterGroupWeights& interWeights) const;
     
     /**
      * @brief Вычисление полной энергии (Hamiltonian)
@@ -91,7 +96,7 @@ public:
      * @return Полная энергия H = T + V
      */
     double computeTotalEnergy(const CanonicalState& state,
-                              const std::vector<std::vector<double>>& interWeights) const;
+                              const InterGroupWeights& interWeights) const;
     
     /**
      * @brief Проверка сохранения энергии (основной метод аудита)
@@ -111,7 +116,7 @@ public:
      */
     float auditAction(const CanonicalState& before_state,
                       const CanonicalState& after_state,
-                      const std::vector<std::vector<double>>& interWeights,
+                      const InterGroupWeights& interWeights,
                       double dt);
     
     /**
@@ -122,7 +127,7 @@ public:
      */
     void correctState(CanonicalState& state,
                       double target_energy,
-                      const std::vector<std::vector<double>>& interWeights);
+                      const InterGroupWeights& interWeights);
     
     /**
      * @brief Предсказание следующего состояния через уравнения Гамильтона
@@ -132,7 +137,7 @@ public:
      * @return Предсказанное состояние
      */
     CanonicalState hamiltonianStep(const CanonicalState& state,
-                                   const std::vector<std::vector<double>>& interWeights,
+                                   const InterGroupWeights& interWeights,
                                    double dt);
     
     // Геттеры
@@ -159,14 +164,17 @@ private:
     std::deque<double> energy_history_;
     std::deque<double> momentum_history_;
     
+    // q предыдущего шага (по числу групп) для p = Δq/dt
+    std::vector<double> prev_q_;
+    
     // Вспомогательные методы
     double computeKineticEnergy(const CanonicalState& state) const;
     double computePotentialEnergy(const CanonicalState& state,
-                                  const std::vector<std::vector<double>>& interWeights) const;
+                                  const InterGroupWeights& interWeights) const;
     double computeMomentumNorm(const CanonicalState& state) const;
     void updateEma(double& ema, double new_value);
     
     // Градиенты для уравнений Гамильтона
     std::vector<double> computePotentialGradient(const CanonicalState& state,
-                                                  const std::vector<std::vector<double>>& interWeights) const;
+                                                  const InterGroupWeights& interWeights) const;
 };
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "LifKernel.hpp"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// ============================================================================
+// ВЫБОР ISA
+// ============================================================================
+
+LifKernel::Type LifKernel::best() {
+    static const Type t = selfCheck(SimdLevel::AVX512) ? SimdLevel::AVX512
+                        : selfCheck(SimdLevel::AVX2)   ? SimdLevel::AVX2
+                        : SimdLevel::SCALAR;
+    return t;
+}
+
+bool LifKernel::selfCheck(Type t, int n, uint32_t seed) {
+    if (!SimdLevel::supported(t)) return false;
+
+    // Параметры по умолчанию MembraneParams, dt как у системы
+    Params p{-70.0, -80.0, -55.0, -35.0, 1.0, 0.1, 0.01, 5.0, 0.999, 5};
+
+    // Детерминированные входы: часть нейронов рефрактерна, часть у порога
+    uint32_t x = seed ? seed : 1;
+    auto next = [&x]() {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        return (x >> 8) * (1.0 / 16777216.0);
+    };
+    std::vector<double> V(n), th(n), I(n);
+    std::vector<int> refr(n);
+    for (int i = 0; i < n; ++i) {
+        V[i] = -85.0 + 55.0 * next();
+        th[i] = -55.0 + 20.0 * next();
+        I[i] = -200.0 + 400.0 * next();
+        refr[i] = static_cast<int>(next() * 4.0) - 1;
+    }
+
+    std::vector<double> V_ref = V, th_ref = th;
+    std::vector<int> refr_ref = refr;
+    std::vector<uint8_t> s(n), s_ref(n);
+    for (int k = 0; k < 4; ++k) {
+        step(t, p, n, V.data(), th.data(), refr.data(), I.data(), s.data());
+        stepScalar(p, 0, n, V_ref.data(), th_ref.data(), refr_ref.data(), I.data(), s_ref.data());
+    }
+    return std::memcmp(V.data(), V_ref.data(), n * sizeof(double)) == 0 &&
+           std::memcmp(th.data(), th_ref.data(), n * sizeof(double)) == 0 &&
+           refr == refr_ref && s == s_ref;
+}
+
+void LifKernel::step(Type t, const Params& p, int n,
+                     double* V, double* threshold, int* refractory,
+                     const double* I_syn, uint8_t* state) {
+    int done = 0;
+    if (t == SimdLevel::AVX512 && SimdLevel::supported(SimdLevel::AVX512)) {
+        done = stepAvx512(p, n, V, threshold, refractory, I_syn, state);
+    } else if (t != SimdLevel::SCALAR && SimdLevel::supported(SimdLevel::AVX2)) {
+        done = stepAvx2(p, n, V, threshold, refractory, I_syn, state);
+    }
+    // Хвост (и весь массив без SIMD)
+    stepScalar(p, done, n, V, threshold, refractory, I_syn, state);
+}
+
+// ============================================================================
+// СКАЛЯРНЫЙ ПУТЬ (эталон)
+// ============================================================================
+
+void LifKernel::stepScalar(const Params& p, int begin, int n,
+                           double* V, double* threshold, int* refractory,
+                           const double* I_syn, uint8_t* state) {
+    const double relax = p.v_threshold_base * (1.0 - p.threshold_decay);
+    for (int i = begin; i < n; ++i) {
+        if (refractory[i] > 0) {
+            refractory[i]--;
+            state[i] = REFRACTORY;
+            continue;
+        }
+
+        double I_leak = -p.g_leak * (V[i] - p.v_rest);
+        double v = V[i] + p.dt * (I_syn[i] + I_leak) / p.c_m;
+
+        if (v > threshold[i]) {
+            state[i] = SPIKE;
+            refractory[i] = p.refractory_period;
+            V[i] = p.v_reset;
+            threshold[i] = std::min(threshold[i] + p.spike_adaptation, p.v_threshold_max);
+        } else {
+            state[i] = QUIET;
+            V[i] = v;
+            threshold[i] = threshold[i] * p.threshold_decay + relax;
+        }
+    }
+}
+
+#ifdef SIMD_LEVEL_X86
+
+// ============================================================================
+// AVX2: 4 нейрона за итерацию
+// ============================================================================
+// Без FMA в target — компилятор не сливает mul+add, порядок как в эталоне.
+
+__attribute__((target("avx2")))
+int LifKernel::stepAvx2(const Params& p, int n,
+                        double* V, double* threshold, int* refractory,
+                        const double* I_syn, uint8_t* state) {
+    const __m256d neg_g  = _mm256_set1_pd(-p.g_leak);
+    const __m256d v_rest = _mm256_set1_pd(p.v_rest);
+    const __m256d v_reset = _mm256_set1_pd(p.v_reset);
+    const __m256d dt     = _mm256_set1_pd(p.dt);
+    const __m256d c_m    = _mm256_set1_pd(p.c_m);
+    const __m256d adapt  = _mm256_set1_pd(p.spike_adaptation);
+    const __m256d t_max  = _mm256_set1_pd(p.v_threshold_max);
+    const __m256d decay  = _mm256_set1_pd(p.threshold_decay);
+    const __m256d relax  = _mm256_set1_pd(p.v_threshold_base * (1.0 - p.threshold_decay));
+    const __m128i zero   = _mm_setzero_si128();
+    const __m128i period = _mm_set1_epi32(p.refractory_period);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(refractory + i));
+        __m128i refr32 = _mm_cmpgt_epi32(r, zero);
+        __m256d refr = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(refr32));
+
+        __m256d v  = _mm256_loadu_pd(V + i);
+        __m256d th = _mm256_loadu_pd(threshold + i);
+        __m256d I  = _mm256_loadu_pd(I_syn + i);
+
+        // Утечка и интегрирование
+        __m256d leak = _mm256_mul_pd(neg_g, _mm256_sub_pd(v, v_rest));
+        __m256d v_new = _mm256_add_pd(v, _mm256_div_pd(_mm256_mul_pd(dt, _mm256_add_pd(I, leak)), c_m));
+
+        // Спайк только у нерефрактерных
+        __m256d fire = _mm256_andnot_pd(refr, _mm256_cmp_pd(v_new, th, _CMP_GT_OQ));
+
+        // Порог: адаптация после спайка или релаксация к базе
+        __m256d th_fire  = _mm256_min_pd(_mm256_add_pd(th, adapt), t_max);
+        __m256d th_quiet = _mm256_add_pd(_mm256_mul_pd(th, decay), relax);
+        __m256d th_out = _mm256_blendv_pd(_mm256_blendv_pd(th_quiet, th_fire, fire), th, refr);
+        __m256d v_out  = _mm256_blendv_pd(_mm256_blendv_pd(v_new, v_reset, fire), v, refr);
+
+        // Рефрактерность: r-1 у рефрактерных, период у спайкнувших
+        __m128i fire32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(
+            _mm256_castpd_si256(fire), _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+        __m128i r_out = _mm_blendv_epi8(_mm_add_epi32(r, refr32), period, fire32);
+
+        _mm256_storeu_pd(V + i, v_out);
+        _mm256_storeu_pd(threshold + i, th_out);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(refractory + i), r_out);
+
+        int refr_bits = _mm256_movemask_pd(refr);
+        int fire_bits = _mm256_movemask_pd(fire);
+        for (int k = 0; k < 4; ++k) {
+            state[i + k] = (refr_bits >> k & 1) ? REFRACTORY
+                         : (fire_bits >> k & 1) ? SPIKE : QUIET;
+        }
+    }
+    return i;
+}
+
+// ============================================================================
+// AVX-512: 8 нейронов за итерацию
+// ============================================================================
+// avx512f включает FMA, поэтому арифметика через *_round_pd — они не сливаются.
+// (GCC 12 ложно предупреждает о _mm512_undefined_pd внутри этих интринсиков.)
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f")))
+int LifKernel::stepAvx512(const Params& p, int n,
+                          double* V, double* threshold, int* refractory,
+                          const double* I_syn, uint8_t* state) {
+    constexpr int RND = _MM_FROUND_CUR_DIRECTION;
+    const __m512d neg_g  = _mm512_set1_pd(-p.g_leak);
+    const __m512d v_rest = _mm512_set1_pd(p.v_rest);
+    const __m512d v_reset = _mm512_set1_pd(p.v_reset);
+    const __m512d dt     = _mm512_set1_pd(p.dt);
+    const __m512d c_m    = _mm512_set1_pd(p.c_m);
+    const __m512d adapt  = _mm512_set1_pd(p.spike_adaptation);
+    const __m512d t_max  = _mm512_set1_pd(p.v_threshold_max);
+    const __m512d decay  = _mm512_set1_pd(p.threshold_decay);
+    const __m512d relax  = _mm512_set1_pd(p.v_threshold_base * (1.0 - p.threshold_decay));
+    const __m256i zero   = _mm256_setzero_si256();
+    const __m512i period = _mm512_set1_epi32(p.refractory_period);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(refractory + i));
+        __m256i refr32 = _mm256_cmpgt_epi32(r, zero);
+        __mmask8 refr = static_cast<__mmask8>(_mm256_movemask_ps(_mm256_castsi256_ps(refr32)));
+
+        __m512d v  = _mm512_loadu_pd(V + i);
+        __m512d th = _mm512_loadu_pd(threshold + i);
+        __m512d I  = _mm512_loadu_pd(I_syn + i);
+
+        // Утечка и интегрирование
+        __m512d leak = _mm512_mul_round_pd(neg_g, _mm512_sub_round_pd(v, v_rest, RND), RND);
+        __m512d v_new = _mm512_add_round_pd(v, _mm512_div_round_pd(
+            _mm512_mul_round_pd(dt, _mm512_add_round_pd(I, leak, RND), RND), c_m, RND), RND);
+
+        // Спайк только у нерефрактерных
+        __mmask8 fire = _mm512_mask_cmp_pd_mask(static_cast<__mmask8>(~refr), v_new, th, _CMP_GT_OQ);
+
+        // Порог: адаптация после спайка или релаксация к базе
+        __m512d th_fire  = _mm512_min_pd(_mm512_add_round_pd(th, adapt, RND), t_max);
+        __m512d th_quiet = _mm512_add_round_pd(_mm512_mul_round_pd(th, decay, RND), relax, RND);
+        __m512d th_out = _mm512_mask_blend_pd(refr, _mm512_mask_blend_pd(fire, th_quiet, th_fire), th);
+        __m512d v_out  = _mm512_mask_blend_pd(refr, _mm512_mask_blend_pd(fire, v_new, v_reset), v);
+
+        // Рефрактерность: r-1 у рефрактерных, период у спайкнувших
+        __m512i r_dec = _mm512_inserti64x4(_mm512_setzero_si512(), _mm256_add_epi32(r, refr32), 0);
+        __m256i r_out = _mm512_castsi512_si256(_mm512_mask_mov_epi32(r_dec, fire, period));
+
+        _mm512_storeu_pd(V + i, v_out);
+        _mm512_storeu_pd(threshold + i, th_out);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(refractory + i), r_out);
+
+        for (int k = 0; k < 8; ++k) {
+            state[i + k] = (refr >> k & 1) ? REFRACTORY
+                         : (fire >> k & 1) ? SPIKE : QUIET;
+        }
+    }
+    return i;
+}
+#pragma GCC diagnostic pop
+
+#else
+
+int LifKernel::stepAvx2(const Params&, int, double*, double*, int*, const double*, uint8_t*) { return 0; }
+int LifKernel::stepAvx512(const Params&, int, double*, double*, int*, const double*, uint8_t*) { return 0; }
+
+#endif
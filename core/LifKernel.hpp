@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include "SimdLevel.hpp"
+
+// --------------------
+// Векторное ядро LIF (leak / integrate / threshold / adapt)
+// --------------------
+/**
+ * @struct LifKernel
+ * @brief Шаг мембранной динамики для всей группы с выбором ISA во время выполнения
+ *
+ * Логика:
+ * - на вход SoA-массивы V, порога и рефрактерности плюс готовый I_syn
+ * - ветвления заменены масками: рефрактерный нейрон не интегрируется,
+ *   спайк даёт сброс V и адаптацию порога, иначе порог релаксирует к базе
+ * - state[i]: 0 — рефрактерный (в историю не пишется), 1 — без спайка, 2 — спайк
+ * - все пути считают в double в одном и том же порядке операций (без FMA),
+ *   поэтому AVX2/AVX-512 совпадают со скалярным путём бит в бит
+ */
+struct LifKernel {
+    using Type = SimdLevel::Type;
+
+    enum State : uint8_t {
+        REFRACTORY = 0,
+        QUIET = 1,
+        SPIKE = 2
+    };
+
+    struct Params {
+        double v_rest;
+        double v_reset;
+        double v_threshold_base;
+        double v_threshold_max;
+        double c_m;
+        double g_leak;
+        double dt;
+        double spike_adaptation;
+        double threshold_decay;
+        int refractory_period;
+    };
+
+    // Лучшая ISA, поддерживаемая процессором и прошедшая selfCheck (один раз за процесс)
+    static Type best();
+    // Сравнение с эталонным скалярным путём на синтетической группе (бит в бит)
+    static bool selfCheck(Type t, int n = 67, uint32_t seed = 1);
+
+    static void step(Type t, const Params& p, int n,
+                     double* V, double* threshold, int* refractory,
+                     const double* I_syn, uint8_t* state);
+
+private:
+    static void stepScalar(const Params& p, int begin, int n,
+                           double* V, double* threshold, int* refractory,
+                           const double* I_syn, uint8_t* state);
+    static int stepAvx2(const Params& p, int n,
+                        double* V, double* threshold, int* refractory,
+                        const double* I_syn, uint8_t* state);
+    static int stepAvx512(const Params& p, int n,
+                          double* V, double* threshold, int* refractory,
+                          const double* I_syn, uint8_t* state);
+};
@@ -0,0 +1,282 @@
+#include "MemorySnapshot.hpp"
+#include "AtomicFile.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+    constexpr uint64_t MAGIC = 0x31504D454D464E4Eull;     // "NNFMEMP1"
+
+    struct Header {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t header_bytes;
+        uint32_t record_count;
+        uint32_t record_bytes;
+        uint32_t incoming_dim;
+        uint32_t outgoing_dim;
+        uint32_t embedding_dim;
+        uint32_t string_count;
+        uint64_t records_offset;
+        uint64_t vectors_offset;
+        uint64_t strings_offset;
+        uint64_t file_bytes;
+        uint32_t payload_crc;       // CRC32 всего, что после заголовка
+        uint32_t header_crc;        // CRC32 заголовка при header_crc = 0
+    };
+    static_assert(sizeof(Header) == 80, "layout of stm.bin/ltm.bin header changed");
+
+    struct Record {
+        int32_t group_id;
+        int32_t neuron_id;
+        float firing_rate;
+        float spike_timing_pattern;
+        float importance;
+        float decay_rate;
+        int32_t age;
+        int32_t last_accessed;
+        float trophic_history;
+        float avg_firing_rate;
+        float spike_variability;
+        uint32_t tag;               // индекс в таблице строк
+        uint32_t incoming_len;
+        uint32_t outgoing_len;
+        uint32_t embedding_len;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(Record) == 64, "layout of stm.bin/ltm.bin record changed");
+
+    size_t align8(size_t bytes) {
+        return (bytes + 7) & ~size_t(7);
+    }
+
+    bool fail(std::string* error, const std::string& message) {
+        if (error) *error = message;
+        return false;
+    }
+
+    uint32_t headerCrc(Header header) {
+        header.header_crc = 0;
+        return MemorySnapshot::crc32(&header, sizeof(header));
+    }
+
+    // Отображение файла только для чтения; снимается в деструкторе
+    struct MappedFile {
+        int fd = -1;
+        const char* data = nullptr;
+        size_t bytes = 0;
+
+        ~MappedFile() {
+            if (data) ::munmap(const_cast<char*>(data), bytes);
+            if (fd >= 0) ::close(fd);
+        }
+    };
+}
+
+uint32_t MemorySnapshot::crc32(const void* data, size_t bytes, uint32_t crc) {
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    const auto* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < bytes; ++i) {
+        crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// ============================================================================
+// СОХРАНЕНИЕ
+// ============================================================================
+
+bool MemorySnapshot::save(const std::string& path, const std::deque<NeuroMemoryRecord>& pool, std::string* error) {
+    Header header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.header_bytes = sizeof(Header);
+    header.record_count = static_cast<uint32_t>(pool.size());
+    header.record_bytes = sizeof(Record);
+
+    // Ширины массивов и таблица тегов
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, uint32_t> string_ids;
+    std::vector<uint32_t> tags;
+    tags.reserve(pool.size());
+    for (const auto& r : pool) {
+        header.incoming_dim = std::max<uint32_t>(header.incoming_dim, static_cast<uint32_t>(r.signature.incoming.size()));
+        header.outgoing_dim = std::max<uint32_t>(header.outgoing_dim, static_cast<uint32_t>(r.signature.outgoing.size()));
+        header.embedding_dim = std::max<uint32_t>(header.embedding_dim, static_cast<uint32_t>(r.embedding.size()));
+        auto [it, inserted] = string_ids.emplace(r.tag, static_cast<uint32_t>(strings.size()));
+        if (inserted) strings.push_back(r.tag);
+        tags.push_back(it->second);
+    }
+    header.string_count = static_cast<uint32_t>(strings.size());
+
+    size_t string_bytes = 0;
+    for (const auto& s : strings) string_bytes += s.size();
+
+    const size_t row_floats = size_t(header.incoming_dim) + header.outgoing_dim + header.embedding_dim;
+    header.records_offset = sizeof(Header);
+    header.vectors_offset = align8(header.records_offset + pool.size() * sizeof(Record));
+    header.strings_offset = align8(header.vectors_offset + pool.size() * row_floats * sizeof(float));
+    header.file_bytes = align8(header.strings_offset + (strings.size() + 1) * sizeof(uint32_t) + string_bytes);
+
+    std::vector<char> file(header.file_bytes, 0);
+    auto* records = reinterpret_cast<Record*>(file.data() + header.records_offset);
+    auto* vectors = reinterpret_cast<float*>(file.data() + header.vectors_offset);
+
+    size_t i = 0;
+    for (const auto& r : pool) {
+        Record& out = records[i];
+        out.group_id = r.group_id;
+        out.neuron_id = r.neuron_id;
+        out.firing_rate = r.signature.firing_rate;
+        out.spike_timing_pattern = r.signature.spike_timing_pattern;
+        out.importance = r.importance;
+        out.decay_rate = r.decay_rate;
+        out.age = r.age;
+        out.last_accessed = r.last_accessed;
+        out.trophic_history = r.trophic_history;
+        out.avg_firing_rate = r.avg_firing_rate;
+        out.spike_variability = r.spike_variability;
+        out.tag = tags[i];
+        out.incoming_len = static_cast<uint32_t>(r.signature.incoming.size());
+        out.outgoing_len = static_cast<uint32_t>(r.signature.outgoing.size());
+        out.embedding_len = static_cast<uint32_t>(r.embedding.size());
+
+        float* row = vectors + i * row_floats;
+        std::copy(r.signature.incoming.begin(), r.signature.incoming.end(), row);
+        std::copy(r.signature.outgoing.begin(), r.signature.outgoing.end(), row + header.incoming_dim);
+        std::copy(r.embedding.begin(), r.embedding.end(), row + header.incoming_dim + header.outgoing_dim);
+        ++i;
+    }
+
+    auto* offsets = reinterpret_cast<uint32_t*>(file.data() + header.strings_offset);
+    char* bytes = reinterpret_cast<char*>(offsets + strings.size() + 1);
+    uint32_t offset = 0;
+    for (size_t s = 0; s < strings.size(); ++s) {
+        offsets[s] = offset;
+        std::memcpy(bytes + offset, strings[s].data(), strings[s].size());
+        offset += static_cast<uint32_t>(strings[s].size());
+    }
+    offsets[strings.size()] = offset;
+
+    header.payload_crc = crc32(file.data() + sizeof(Header), file.size() - sizeof(Header));
+    header.header_crc = headerCrc(header);
+    std::memcpy(file.data(), &header, sizeof(Header));
+
+    if (!AtomicFile::write(path, file.data(), file.size())) {
+        return fail(error, "write " + path + ": " + std::strerror(errno));
+    }
+    return true;
+}
+
+// ============================================================================
+// ЗАГРУЗКА
+// ============================================================================
+
+bool MemorySnapshot::load(const std::string& path, std::deque<NeuroMemoryRecord>& pool, std::string* error) {
+    MappedFile file;
+    file.fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file.fd < 0) return fail(error, "open " + path + ": " + std::strerror(errno));
+
+    struct stat st {};
+    if (::fstat(file.fd, &st) != 0) return fail(error, "stat " + path + ": " + std::strerror(errno));
+    file.bytes = static_cast<size_t>(st.st_size);
+    if (file.bytes < sizeof(Header)) return fail(error, "truncated header");
+
+    void* mapped = ::mmap(nullptr, file.bytes, PROT_READ, MAP_PRIVATE, file.fd, 0);
+    if (mapped == MAP_FAILED) return fail(error, "mmap " + path + ": " + std::strerror(errno));
+    file.data = static_cast<const char*>(mapped);
+    ::madvise(mapped, file.bytes, MADV_SEQUENTIAL);
+
+    Header header;
+    std::memcpy(&header, file.data, sizeof(Header));
+    if (header.magic != MAGIC) return fail(error, "not a memory snapshot");
+    if (header.version != VERSION) return fail(error, "unsupported version " + std::to_string(header.version));
+    if (header.header_bytes != sizeof(Header) || header.record_bytes != sizeof(Record)) {
+        return fail(error, "unexpected header/record size");
+    }
+    if (headerCrc(header) != header.header_crc) return fail(error, "header checksum mismatch");
+    if (header.file_bytes != file.bytes) return fail(error, "file size does not match header");
+
+    // Секции должны лежать ровно там, куда их кладёт save
+    const size_t row_floats = size_t(header.incoming_dim) + header.outgoing_dim + header.embedding_dim;
+    const size_t count = header.record_count;
+    if (count > file.bytes / sizeof(Record) ||
+        (row_floats > 0 && count > file.bytes / (row_floats * sizeof(float))) ||
+        header.string_count > file.bytes / sizeof(uint32_t)) {
+        return fail(error, "counts exceed file size");
+    }
+    if (header.records_offset != sizeof(Header) ||
+        header.vectors_offset != align8(header.records_offset + count * sizeof(Record)) ||
+        header.strings_offset != align8(header.vectors_offset + count * row_floats * sizeof(float)) ||
+        header.strings_offset + (size_t(header.string_count) + 1) * sizeof(uint32_t) > file.bytes) {
+        return fail(error, "corrupt section layout");
+    }
+    if (crc32(file.data + sizeof(Header), file.bytes - sizeof(Header)) != header.payload_crc) {
+        return fail(error, "payload checksum mismatch");
+    }
+
+    std::vector<uint32_t> offsets(size_t(header.string_count) + 1);
+    std::memcpy(offsets.data(), file.data + header.strings_offset, offsets.size() * sizeof(uint32_t));
+    const char* bytes = file.data + header.strings_offset + offsets.size() * sizeof(uint32_t);
+    const size_t bytes_available = file.bytes - static_cast<size_t>(bytes - file.data);
+    std::vector<std::string> strings(header.string_count);
+    for (size_t s = 0; s < strings.size(); ++s) {
+        if (offsets[s] > offsets[s + 1] || offsets[s + 1] > bytes_available) return fail(error, "corrupt string table");
+        strings[s].assign(bytes + offsets[s], offsets[s + 1] - offsets[s]);
+    }
+
+    std::deque<NeuroMemoryRecord> loaded;
+    const auto* vectors = reinterpret_cast<const float*>(file.data + header.vectors_offset);
+    for (size_t i = 0; i < count; ++i) {
+        Record in;
+        std::memcpy(&in, file.data + header.records_offset + i * sizeof(Record), sizeof(Record));
+        if (in.tag >= header.string_count || in.incoming_len > header.incoming_dim ||
+            in.outgoing_len > header.outgoing_dim || in.embedding_len > header.embedding_dim) {
+            return fail(error, "corrupt record " + std::to_string(i));
+        }
+
+        NeuroMemoryRecord r;
+        r.group_id = in.group_id;
+        r.neuron_id = in.neuron_id;
+        r.signature.firing_rate = in.firing_rate;
+        r.signature.spike_timing_pattern = in.spike_timing_pattern;
+        r.importance = in.importance;
+        r.decay_rate = in.decay_rate;
+        r.age = in.age;
+        r.last_accessed = in.last_accessed;
+        r.trophic_history = in.trophic_history;
+        r.avg_firing_rate = in.avg_firing_rate;
+        r.spike_variability = in.spike_variability;
+        r.tag = strings[in.tag];
+
+        const float* row = vectors + i * row_floats;
+        r.signature.incoming.assign(row, row + in.incoming_len);
+        r.signature.outgoing.assign(row + header.incoming_dim, row + header.incoming_dim + in.outgoing_len);
+        const float* embedding = row + header.incoming_dim + header.outgoing_dim;
+        r.embedding.assign(embedding, embedding + in.embedding_len);
+        loaded.push_back(std::move(r));
+    }
+
+    pool = std::move(loaded);
+    return true;
+}
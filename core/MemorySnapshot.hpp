@@ -0,0 +1,39 @@
+#pragma once
+#include <deque>
+#include <string>
+#include <cstdint>
+#include "EmergentCore.hpp"
+
+// --------------------
+// Бинарные снимки пулов EmergentMemory (stm.bin / ltm.bin)
+// --------------------
+
+/**
+ * @class MemorySnapshot
+ * @brief Сохранение и загрузка пула NeuroMemoryRecord в версионированном бинарном формате
+ *
+ * Формат (little-endian, всё выровнено на 8 байт):
+ * - заголовок: магия, версия, число записей, ширины массивов, смещения секций,
+ *   размер файла, CRC32 содержимого и CRC32 самого заголовка
+ * - таблица записей фиксированного размера (скаляры, индекс тега, длины массивов)
+ * - массивы: на запись incoming_dim + outgoing_dim + embedding_dim float,
+ *   короче ширины — дополнены нулями, настоящая длина — в записи
+ * - таблица строк тегов: смещения (string_count + 1) и байты; одинаковые теги — одна строка
+ *
+ * Логика:
+ * - save пишет во временный файл, делает fsync и rename: на диске всегда
+ *   целый старый или целый новый снимок
+ * - load отображает файл (mmap), проверяет заголовок, границы секций и оба CRC,
+ *   и только потом строит записи; любая ошибка — false и пул не тронут
+ */
+class MemorySnapshot {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    static bool save(const std::string& path, const std::deque<NeuroMemoryRecord>& pool,
+                     std::string* error = nullptr);
+    static bool load(const std::string& path, std::deque<NeuroMemoryRecord>& pool,
+                     std::string* error = nullptr);
+
+    static uint32_t crc32(const void* data, size_t bytes, uint32_t crc = 0);
+};
@@ -7,6 +7,7 @@
 #include <random>
 #include <map>
 #include <string>
+#include <chrono>
 #include "LagrangianAuditor.hpp"
 
 // Константы
@@ -17,22 +18,47 @@ static constexpr int EVOLUTION_INTERVAL = 5000;
 // КОНСТРУКТОР И ИНИЦИАЛИЗАЦИЯ
 // ============================================================================
 
-NeuralFieldSystem::NeuralFieldSystem(double dt)
+NeuralFieldSystem::NeuralFieldSystem(double dt, int num_groups, int group_size)
     : dt_(dt),
+      topology_(num_groups, group_size),
       groups(),
-      interWeights(NUM_GROUPS, std::vector<double>(NUM_GROUPS, 0.0)),
-      flatPhi(TOTAL_NEURONS, 0.0),
-      flatPi(TOTAL_NEURONS, 0.0),
-      flatDirty(true)
-{}
+      interWeights(num_groups),
+      flatPhi(topology_.totalNeurons(), 0.0),
+      flatPi(topology_.totalNeurons(), 0.0),
+      pool_(std::make_unique<WorkerPool>(1))
+{
+    const int NG = numGroups();
+    frame_.averages.assign(NG, 0.0);
+    frame_.phi_dirty.assign(NG, 1);
+    entropy_.resize(NG, groupSize());
+    // До initialize() групп нет — публикуется пустой снимок
+    std::atomic_store(&published_snapshot_, std::make_shared<const SystemSnapshot>());
+}
+
+void NeuralFieldSystem::setWorkerThreads(int threads) {
+    if (threads <= 0) threads = WorkerPool::hardwareThreads();
+    // Больше потоков, чем групп, не нужно
+    threads = std::clamp(threads, 1, numGroups());
+    if (threads == pool_->threads()) return;
+    pool_ = std::make_unique<WorkerPool>(threads);
+}
 
 void NeuralFieldSystem::initialize(std::mt19937& rng) {
-    // Создаём группы с новой сигнатурой (без MassLimits)
-    auto shared_rng = std::make_shared<std::mt19937>(rng);
+    uint64_t hi = rng();
+    initialize((hi << 32) | rng());
+}
+
+void NeuralFieldSystem::initialize(uint64_t seed) {
+    // Случайность каждой группы — функция (seed, группа, шаг, нейрон):
+    // группы не делят генератор, и сессия повторяется по seed
+    seed_ = seed;
+    field_rng_ = CounterRng(seed, FIELD_RNG_STREAM);
+    mutation_calls_ = 0;
+    
     groups.clear();
-    groups.reserve(NUM_GROUPS);
-    for (int g = 0; g < NUM_GROUPS; ++g) {
-        groups.emplace_back(GROUP_SIZE, dt_, shared_rng);
+    groups.reserve(numGroups());
+    for (int g = 0; g < numGroups(); ++g) {
+        groups.emplace_back(groupSize(), dt_, CounterRng(seed, static_cast<uint32_t>(g)));
     }
     
     // Настраиваем специализации групп
@@ -41,100 +67,110 @@ void NeuralFieldSystem::initialize(std::mt19937& rng) {
     // Устанавливаем менеджер памяти
     for (auto& group : groups) {
         group.setMemoryManager(memory_manager);
+        group.setStdpGating(stdp_gating_);
     }
     
     // Настраиваем фиксированные межгрупповые связи
     setupFixedInterConnections();
     
-    flatDirty = true;
+    std::fill(frame_.phi_dirty.begin(), frame_.phi_dirty.end(), 1);
+    frame_.any_phi_dirty = true;
+    
+    publishSnapshot();
     
-    std::cout << "[NeuralFieldSystem] Initialized with " << NUM_GROUPS 
-              << " groups of " << GROUP_SIZE << " neurons" << std::endl;
+    std::cout << "[NeuralFieldSystem] Initialized with " << numGroups()
+              << " groups of " << groupSize() << " neurons, seed=" << seed_ << std::endl;
 }
 
 void NeuralFieldSystem::setupGroupSpecializations() {
+    const FieldTopology& T = topology_;
+    // Диапазоны ниже — для 32 групп; при другом числе групп масштабируются
+
     // Группа 0 — входная
-    groups[INPUT_GROUP].setInputGroup(true);
-    groups[INPUT_GROUP].setSpecialization("input");
+    groups[T.input_group].setInputGroup(true);
+    groups[T.input_group].setSpecialization("input");
     
     // Сенсорные группы (1-3)
-    for (int g = SENSORY_START; g <= SENSORY_END; ++g) {
+    for (int g = T.sensory_start; g <= T.sensory_end; ++g) {
         groups[g].setSpecialization("sensory");
     }
     
     // Моторные группы (4-7) — действия
-    for (int g = MOTOR_START; g <= MOTOR_END; ++g) {
+    for (int g = T.motor_start; g <= T.motor_end; ++g) {
         groups[g].setSpecialization("motor");
     }
     
     // Ассоциативные группы (8-15)
-    for (int g = ASSOCIATIVE_START; g <= ASSOCIATIVE_END; ++g) {
+    for (int g = T.associative_start; g <= T.associative_end; ++g) {
         groups[g].setSpecialization("associative");
     }
     
     // Семантические группы (16-21) — смыслы
-    for (int g = SEMANTIC_START; g <= SEMANTIC_END; ++g) {
+    for (int g = T.semantic_start; g <= T.semantic_end; ++g) {
         groups[g].setSpecialization("semantic");
     }
     
     // Контекстные группы (22-27)
-    for (int g = CONTEXT_START; g <= CONTEXT_END; ++g) {
+    for (int g = T.context_start; g <= T.context_end; ++g) {
         groups[g].setSpecialization("context");
     }
     
     // Self-model группы (28-31)
-    for (int g = SELF_MODEL_START; g <= SELF_MODEL_END; ++g) {
+    for (int g = T.self_model_start; g <= T.self_model_end; ++g) {
         groups[g].setSpecialization("self_model");
         groups[g].setSelfModelGroup(true);
     }
 }
 
 void NeuralFieldSystem::setupFixedInterConnections() {
-    // Обнуляем все связи
-    interWeights.assign(NUM_GROUPS, std::vector<double>(NUM_GROUPS, 0.0));
+    const FieldTopology& T = topology_;
+    // Связи собираются списком и строятся одним проходом (CSR или плотно — см. InterGroupWeights)
+    std::vector<InterGroupWeights::Entry> links;
     
     // 1. Вход → сенсорика
-    for (int s = SENSORY_START; s <= SENSORY_END; ++s) {
-        interWeights[INPUT_GROUP][s] = 0.8;
-        interWeights[s][INPUT_GROUP] = 0.2;
+    for (int s = T.sensory_start; s <= T.sensory_end; ++s) {
+        links.push_back({T.input_group, s, 0.8});
+        links.push_back({s, T.input_group, 0.2});
     }
     
     // 2. Сенсорика → ассоциативные
-    for (int s = SENSORY_START; s <= SENSORY_END; ++s) {
-        for (int a = ASSOCIATIVE_START; a <= ASSOCIATIVE_END; ++a) {
-            interWeights[s][a] = 0.5;
+    for (int s = T.sensory_start; s <= T.sensory_end; ++s) {
+        for (int a = T.associative_start; a <= T.associative_end; ++a) {
+            links.push_back({s, a, 0.5});
         }
     }
     
     // 3. Ассоциативные → семантические
-    for (int a = ASSOCIATIVE_START; a <= ASSOCIATIVE_END; ++a) {
-        for (int sem = SEMANTIC_START; sem <= SEMANTIC_END; ++sem) {
-            interWeights[a][sem] = 0.4;
+    for (int a = T.associative_start; a <= T.associative_end; ++a) {
+        for (int sem = T.semantic_start; sem <= T.semantic_end; ++sem) {
+            links.push_back({a, sem, 0.4});
         }
     }
     
     // 4. Семантические → моторные (действия)
-    for (int sem = SEMANTIC_START; sem <= SEMANTIC_END; ++sem) {
-        for (int m = MOTOR_START; m <= MOTOR_END; ++m) {
-            interWeights[sem][m] = 0.3;
+    for (int sem = T.semantic_start; sem <= T.semantic_end; ++sem) {
+        for (int m = T.motor_start; m <= T.motor_end; ++m) {
+            links.push_back({sem, m, 0.3});
         }
     }
     
     // 5. Контекст → все (кроме себя)
-    for (int ctx = CONTEXT_START; ctx <= CONTEXT_END; ++ctx) {
-        for (int g = 0; g < NUM_GROUPS; ++g) {
+    for (int ctx = T.context_start; ctx <= T.context_end; ++ctx) {
+        for (int g = 0; g < numGroups(); ++g) {
             if (g != ctx) {
-                interWeights[ctx][g] = 0.2;
+                links.push_back({ctx, g, 0.2});
             }
         }
     }
     
     // 6. Self-model → семантические (для интроспекции)
-    for (int sm = SELF_MODEL_START; sm <= SELF_MODEL_END; ++sm) {
-        for (int sem = SEMANTIC_START; sem <= SEMANTIC_END; ++sem) {
-            interWeights[sm][sem] = 0.15;
+    for (int sm = T.self_model_start; sm <= T.self_model_end; ++sm) {
+        for (int sem = T.semantic_start; sem <= T.semantic_end; ++sem) {
+            links.push_back({sm, sem, 0.15});
         }
     }
+    
+    interWeights.build(numGroups(), std::move(links));
 }
 
 // ============================================================================
@@ -144,15 +180,27 @@ void NeuralFieldSystem::setupFixedInterConnections() {
 void NeuralFieldSystem::step(float external_reward, int stepNumber) {
     stepCounter = stepNumber;
     
-    // ===== ФАЗА 1: Эволюция всех групп =====
-    for (auto& g : groups) {
-        g.evolve();
-    }
+    using Clock = std::chrono::steady_clock;
+    auto mark = Clock::now();
+    auto lap = [&](StepPhaseStats::Phase phase) {
+        auto now = Clock::now();
+        phase_stats_.total_us[phase] += std::chrono::duration<double, std::micro>(now - mark).count();
+        mark = now;
+    };
+    
+    // ===== ФАЗА 1: Эволюция всех групп (группы независимы — параллельно) =====
+    // Кадр поля собирается в том же проходе, слот группы пишет её поток
+    pool_->parallelFor(numGroups(), [this](int g) {
+        groups[g].evolve();
+        captureGroupFrame(g);
+    });
+    finishFrame(stepNumber);
+    const std::vector<double>& avgs = frame_.averages;
+    lap(StepPhaseStats::EVOLVE);
     
     // ===== ФАЗА 2: EmergentController — расчёт surprise, quality =====
     {
-        auto avgs_d = getGroupAverages();
-        std::vector<float> avgs_f(avgs_d.begin(), avgs_d.end());
+        std::vector<float> avgs_f(avgs.begin(), avgs.end());
         lastSignal_ = emergent_.tick(avgs_f, groups, external_reward, stepNumber);
     }
     
@@ -164,29 +212,31 @@ void NeuralFieldSystem::step(float external_reward, int stepNumber) {
         }
         attention.temperature = std::clamp(new_temp, 0.1f, 5.0f);
     }
+    lap(StepPhaseStats::CONTROLLER);
     
     // ===== ФАЗА 3: Self-model — сэмплирование и инъекция =====
     {
         auto snap = self_sampler_.sample(*this, lastSignal_, stepNumber);
         self_sampler_.inject(*this, snap);
     }
+    lap(StepPhaseStats::SELF_MODEL);
     
     // ===== ФАЗА 4: Межгрупповое взаимодействие (простая рекуррентная динамика) =====
     {
-        auto currAvg = getGroupAverages();
-        std::vector<double> newAvg(NUM_GROUPS, 0.0);
+        const int NG = numGroups();
+        const std::vector<double>& currAvg = avgs;
+        std::vector<double> newAvg(NG, 0.0);
+        
+        // Σ_h w[g][h] * avg[h] для всех g — одно SpMV по хранимым связям
+        std::vector<double> recurrent(NG);
+        interWeights.multiply(currAvg.data(), recurrent.data());
         
         // Простая рекуррентная динамика с межгрупповыми связями
-        for (int g = 0; g < NUM_GROUPS; ++g) {
-            double input = 0.0;
-            for (int h = 0; h < NUM_GROUPS; ++h) {
-                if (h != g) {
-                    input += interWeights[g][h] * currAvg[h];
-                }
-            }
+        for (int g = 0; g < NG; ++g) {
+            double input = recurrent[g];
             // Также учитываем внешние входы
-            if (g == INPUT_GROUP && !external_inputs_.empty()) {
-                for (size_t i = 0; i < std::min(external_inputs_.size(), (size_t)GROUP_SIZE); ++i) {
+            if (g == topology_.input_group && !external_inputs_.empty()) {
+                for (size_t i = 0; i < std::min(external_inputs_.size(), (size_t)groupSize()); ++i) {
                     input += external_inputs_[i] * 0.1;
                 }
             }
@@ -194,14 +244,12 @@ void NeuralFieldSystem::step(float external_reward, int stepNumber) {
         }
         
         // Применяем новые активности к группам
-        for (int g = 0; g < NUM_GROUPS; ++g) {
-            double diff = newAvg[g] - groups[g].getAverageActivity();
-            auto& phi = groups[g].getPhiNonConst();
-            for (int n = 0; n < GROUP_SIZE; ++n) {
-                phi[n] = std::clamp(phi[n] + dt_ * diff * 0.1, 0.0, 1.0);
-            }
+        for (int g = 0; g < NG; ++g) {
+            double diff = newAvg[g] - currAvg[g];
+            nudgePhi(g, dt_ * diff * 0.1);
         }
     }
+    lap(StepPhaseStats::INTER_GROUP);
 
     // ===== НОВАЯ ФАЗА 4.5: LAGRANGIAN АУДИТ =====
     if (energy_audit_enabled_) {
@@ -209,7 +257,7 @@ void NeuralFieldSystem::step(float external_reward, int stepNumber) {
         previous_canonical_state_ = canonical_state_;
         
         // Получаем текущее каноническое состояние
-        canonical_state_ = lagrangian_auditor_.toCanonical(groups, interWeights, dt_);
+        canonical_state_ = lagrangian_auditor_.toCanonical(groups, avgs, interWeights, dt_);
         
         // Аудируем сохранение энергии
         bool energy_conserved = lagrangian_auditor_.auditEnergyConservation(canonical_state_, dt_);
@@ -219,15 +267,12 @@ void NeuralFieldSystem::step(float external_reward, int stepNumber) {
             lagrangian_auditor_.correctState(canonical_state_, 0.0, interWeights);
             
             // Применяем коррекцию к группам
-            for (int g = 0; g < NUM_GROUPS; ++g) {
+            for (int g = 0; g < numGroups(); ++g) {
                 double target_q = canonical_state_.q[g];
-                double current_q = groups[g].getAverageActivity();
+                double current_q = avgs[g];
                 double delta = target_q - current_q;
                 
-                auto& phi = groups[g].getPhiNonConst();
-                for (int n = 0; n < GROUP_SIZE; ++n) {
-                    phi[n] = std::clamp(phi[n] + delta * 0.1, 0.0, 1.0);
-                }
+                nudgePhi(g, delta * 0.1);
             }
         }
         
@@ -235,10 +280,11 @@ void NeuralFieldSystem::step(float external_reward, int stepNumber) {
         float energy_risk = static_cast<float>(lagrangian_auditor_.getEnergyError());
         lastSignal_.hallucination_risk = std::max(lastSignal_.hallucination_risk, energy_risk);
     }
+    lap(StepPhaseStats::AUDIT);
     
     // ===== ФАЗА 5: Распределение наград =====
     routeRewards(lastSignal_, stepNumber);
-    
+    lap(StepPhaseStats::STDP);
 
     
     // ===== ФАЗА 7: Консолидация =====
@@ -247,23 +293,24 @@ void NeuralFieldSystem::step(float external_reward, int stepNumber) {
         float importance = lastSignal_.consolidation_pressure;
         if (importance < 0.1f && force_consolidate) importance = 0.2f;
         
-        for (auto& g : groups) {
-            g.consolidateEligibility(importance);
-            g.consolidateElevation(importance);
-        }
+        pool_->parallelFor(numGroups(), [this, importance](int g) {
+            groups[g].consolidateEligibility(importance);
+            groups[g].consolidateElevation(importance);
+        });
         consolidateInterWeights(importance);
         applyPruningByElevation();
         
         entropy_history.push_back(computeSystemEntropy());
         if (entropy_history.size() > HISTORY_SIZE) entropy_history.pop_front();
     }
+    lap(StepPhaseStats::CONSOLIDATE);
     
     // ===== ФАЗА 8: Латеральное торможение =====
     applyLateralInhibition();
     
     // ===== ФАЗА 9: Обновление elevation =====
-    for (int g = 0; g < NUM_GROUPS; ++g) {
-        groups[g].updateElevationFast(lastSignal_.quality, groups[g].getAverageActivity());
+    for (int g = 0; g < numGroups(); ++g) {
+        groups[g].updateElevationFast(lastSignal_.quality, avgs[g]);
     }
     
     // ===== ФАЗА 10: Диагностика =====
@@ -284,7 +331,11 @@ void NeuralFieldSystem::step(float external_reward, int stepNumber) {
         pendingEvolution_ = true;
     }
     
-    flatDirty = true;
+    // ===== ФАЗА 12: Публикация снимка для читателей API =====
+    publishSnapshot();
+    
+    lap(StepPhaseStats::TAIL);
+    phase_stats_.steps++;
 }
 
 // ============================================================================
@@ -293,8 +344,11 @@ void NeuralFieldSystem::step(float external_reward, int stepNumber) {
 
 void NeuralFieldSystem::routeRewards(const EmergentSignal& sig, int step) {
     constexpr float SURVIVAL = 0.02f;
+    const FieldTopology& T = topology_;
     
-    for (int g = 0; g < NUM_GROUPS; ++g) {
+    // Награды считаются последовательно, learnSTDP — параллельно по группам
+    group_rewards_.resize(numGroups());
+    for (int g = 0; g < numGroups(); ++g) {
         float pred_reward = (g < (int)sig.per_group_reward.size()) 
                             ? sig.per_group_reward[g] 
                             : 0.5f;
@@ -302,16 +356,16 @@ void NeuralFieldSystem::routeRewards(const EmergentSignal& sig, int step) {
         float reward;
         
         // Разные правила для разных типов групп
-        if (g == INPUT_GROUP) {
+        if (g == T.input_group) {
             reward = SURVIVAL + 0.08f * pred_reward;
         } 
-        else if (g >= SEMANTIC_START && g <= SEMANTIC_END) {
+        else if (g >= T.semantic_start && g <= T.semantic_end) {
             reward = pred_reward * 0.6f + sig.quality * 0.4f;
         }
-        else if (g >= MOTOR_START && g <= MOTOR_END) {
+        else if (g >= T.motor_start && g <= T.motor_end) {
             reward = pred_reward * 0.5f + sig.quality * 0.3f;
         }
-        else if (g >= SELF_MODEL_START && g <= SELF_MODEL_END) {
+        else if (g >= T.self_model_start && g <= T.self_model_end) {
             reward = pred_reward * 0.7f + sig.quality * 0.3f;
         }
         else {
@@ -323,9 +377,12 @@ void NeuralFieldSystem::routeRewards(const EmergentSignal& sig, int step) {
             reward += 0.05f * sig.surprise;
         }
         
-        reward = std::clamp(reward, 0.f, 1.f);
-        groups[g].learnSTDP(reward, step);
+        group_rewards_[g] = std::clamp(reward, 0.f, 1.f);
     }
+    
+    pool_->parallelFor(numGroups(), [this, step](int g) {
+        groups[g].learnSTDP(group_rewards_[g], step);
+    });
 }
 
 // ============================================================================
@@ -339,11 +396,9 @@ void NeuralFieldSystem::consolidateInterWeights(float pressure) {
     double scale = 0.999 + 0.001 * entropy_factor;
     double boost = 1.0 + static_cast<double>(pressure) * 0.01;
     
-    for (auto& row : interWeights) {
-        for (auto& w : row) {
-            w = std::clamp(w * scale * boost, -0.5, 0.5);
-        }
-    }
+    interWeights.forEach([&](int, int, double& w) {
+        w = std::clamp(w * scale * boost, -0.5, 0.5);
+    });
 }
 
 // ============================================================================
@@ -351,24 +406,29 @@ void NeuralFieldSystem::consolidateInterWeights(float pressure) {
 // ============================================================================
 
 void NeuralFieldSystem::applyLateralInhibition() {
-    const int NUM_SEM = SEMANTIC_END - SEMANTIC_START + 1;
-    std::vector<double> act(NUM_GROUPS, 0.0);
+    const FieldTopology& T = topology_;
+    // Нужны активности только семантических групп
+    std::vector<double> act(numGroups(), 0.0);
     
-    for (int g = 0; g < NUM_GROUPS; ++g) {
+    for (int g = T.semantic_start; g <= T.semantic_end; ++g) {
         const auto& phi = groups[g].getPhi();
-        act[g] = std::accumulate(phi.begin(), phi.end(), 0.0) / GROUP_SIZE;
+        act[g] = std::accumulate(phi.begin(), phi.end(), 0.0) / groupSize();
     }
     
     const double INHIB = 0.1;
-    for (int g = SEMANTIC_START; g <= SEMANTIC_END; ++g) {
+    for (int g = T.semantic_start; g <= T.semantic_end; ++g) {
         double inh = 0.0;
-        for (int o = SEMANTIC_START; o <= SEMANTIC_END; ++o) {
+        for (int o = T.semantic_start; o <= T.semantic_end; ++o) {
             if (o != g) inh += act[o];
         }
-        auto& phi = groups[g].getPhiNonConst();
-        for (int i = 0; i < GROUP_SIZE; ++i) {
-            phi[i] = std::max(0.0, phi[i] - INHIB * inh);
-        }
+        const double sub = INHIB * inh;
+        double* phi = groups[g].getPhiNonConst().data();
+        dispatchSize(groupSize(), [&](auto gs) {
+            for (int i = 0; i < int(gs); ++i) {
+                phi[i] = std::max(0.0, phi[i] - sub);
+            }
+        });
+        invalidatePhi(g);
     }
 }
 
@@ -388,56 +448,70 @@ void NeuralFieldSystem::applyPruningByElevation() {
 // ВСПОМОГАТЕЛЬНЫЕ МЕТОДЫ
 // ============================================================================
 
-void NeuralFieldSystem::rebuildFlatVectors() const {
-    if (!flatDirty) return;
-    int idx = 0;
-    for (const auto& grp : groups) {
-        const auto& phiGrp = grp.getPhi();
-        const auto& piGrp = grp.getPi();
-        for (int i = 0; i < GROUP_SIZE; ++i) {
-            flatPhi[idx] = phiGrp[i];
-            flatPi[idx] = piGrp[i];
-            ++idx;
+// phi[i] = clamp(phi[i] + delta, 0, 1) по всей группе g; для 16/32/64/128 нейронов —
+// с размером, известным при компиляции
+void NeuralFieldSystem::nudgePhi(int g, double delta) {
+    double* p = groups[g].getPhiNonConst().data();
+    dispatchSize(groupSize(), [&](auto gs) {
+        for (int n = 0; n < int(gs); ++n) {
+            p[n] = std::clamp(p[n] + delta, 0.0, 1.0);
         }
-    }
-    flatDirty = false;
+    });
+    invalidatePhi(g);
 }
 
-double NeuralFieldSystem::computeSystemEntropy() const {
-    rebuildFlatVectors();
-    const int BINS = 20;
-    std::vector<int> hist(BINS, 0);
-    for (double v : flatPhi) {
-        int bin = std::clamp(static_cast<int>(v * BINS), 0, BINS - 1);
-        hist[bin]++;
-    }
-    double entropy = 0.0;
-    double total = static_cast<double>(TOTAL_NEURONS);
-    for (int count : hist) {
-        if (count > 0) {
-            double p = static_cast<double>(count) / total;
-            entropy -= p * std::log(p);
+// ============================================================================
+// КАДР ПОЛЯ
+// ============================================================================
+
+void NeuralFieldSystem::captureGroupFrame(int g) const {
+    const NeuralGroup& grp = groups[g];
+    const int GS = groupSize();
+    
+    frame_.averages[g] = grp.getAverageActivity();
+    
+    // phi/pi группы — в свой слот плоских векторов
+    const double* phi = grp.getPhi().data();
+    const double* pi = grp.getPi().data();
+    std::copy_n(phi, GS, flatPhi.data() + static_cast<size_t>(g) * GS);
+    std::copy_n(pi, GS, flatPi.data() + static_cast<size_t>(g) * GS);
+    
+    // Переносы бинов энтропии (только нейроны, сменившие бин)
+    entropy_.updateGroup(g, phi);
+    frame_.phi_dirty[g] = 0;
+}
+
+void NeuralFieldSystem::finishFrame(int step) {
+    frame_.step = step;
+    frame_.any_phi_dirty = false;
+    entropy_.commit();
+}
+
+void NeuralFieldSystem::refreshPhiFrame() const {
+    if (!frame_.any_phi_dirty) return;
+    for (int g = 0; g < numGroups(); ++g) {
+        if (frame_.phi_dirty[g]) {
+            // averages от phi не зависят — пересчёт безвреден
+            captureGroupFrame(g);
         }
     }
-    return entropy;
+    frame_.any_phi_dirty = false;
+    entropy_.commit();
+}
+
+double NeuralFieldSystem::computeSystemEntropy() const {
+    refreshPhiFrame();
+    return entropy_.systemEntropy();
 }
 
 double NeuralFieldSystem::getUnifiedEntropy() const {
-    rebuildFlatVectors();
-    const int BINS = 32;
-    std::vector<int> hist(BINS, 0);
-    for (double v : flatPhi) {
-        int bin = std::clamp(static_cast<int>(v * BINS), 0, BINS - 1);
-        hist[bin]++;
-    }
-    double H = 0.0, total = static_cast<double>(TOTAL_NEURONS);
-    for (int count : hist) {
-        if (count > 0) {
-            double p = count / total;
-            H -= p * std::log2(p);
-        }
-    }
-    return std::clamp(H / std::log2(static_cast<double>(BINS)), 0.0, 1.0);
+    refreshPhiFrame();
+    return entropy_.unifiedEntropy();
+}
+
+bool NeuralFieldSystem::checkEntropyConsistency() const {
+    refreshPhiFrame();
+    return entropy_.verify(flatPhi);
 }
 
 double NeuralFieldSystem::getTargetUnifiedEntropy() const {
@@ -455,17 +529,50 @@ double NeuralFieldSystem::getTargetUnifiedEntropy() const {
     return std::clamp(base * err_factor * mode_factor, 0.2, 0.8);
 }
 
+void NeuralFieldSystem::publishSnapshot() {
+    auto snap = std::make_shared<SystemSnapshot>();
+    snap->energy = lagrangian_auditor_.getReferenceEnergy();
+    snap->energy_error = lagrangian_auditor_.getEnergyError();
+    snap->violations = static_cast<int>(lagrangian_auditor_.getConservationViolations());
+    snap->audit_enabled = energy_audit_enabled_;
+    snap->audit_config = lagrangian_auditor_.getConfig();
+    for (double l : canonical_state_.neural_lagrangian) snap->neural_lagrangian += l;
+    snap->entropy = getUnifiedEntropy();
+    snap->target_entropy = getTargetUnifiedEntropy();
+    snap->surprise = lastSignal_.surprise;
+    snap->quality = lastSignal_.quality;
+    snap->temperature = attention.temperature;
+    snap->seed = seed_;
+    snap->step = stepCounter;
+    snap->stm_size = emergent_.memory.stmSize();
+    snap->ltm_size = emergent_.memory.ltmSize();
+    snap->stdp_gating = stdp_gating_;
+    for (const auto& g : groups) {
+        const SynapticInputStats& in = g.getSynapticInputStats();
+        snap->synaptic_input.sparse_steps += in.sparse_steps;
+        snap->synaptic_input.dense_steps += in.dense_steps;
+        snap->synaptic_input.silent_steps += in.silent_steps;
+        snap->synaptic_input.events += in.events;
+        const StdpStats& stdp = g.getStdpStats();
+        snap->stdp.dense_calls += stdp.dense_calls;
+        snap->stdp.gated_calls += stdp.gated_calls;
+        snap->stdp.gated_synapses += stdp.gated_synapses;
+    }
+    // constraints нужно заполнить извне или добавить поле в EmergentSignal
+    std::atomic_store(&published_snapshot_, std::shared_ptr<const SystemSnapshot>(std::move(snap)));
+}
+
 std::vector<double> NeuralFieldSystem::getGroupAverages() const {
-    std::vector<double> avgs(NUM_GROUPS);
-    for (int g = 0; g < NUM_GROUPS; ++g) {
+    std::vector<double> avgs(numGroups());
+    for (int g = 0; g < numGroups(); ++g) {
         avgs[g] = groups[g].getAverageActivity();
     }
     return avgs;
 }
 
 void NeuralFieldSystem::strengthenInterConnection(int from, int to, double delta) {
-    if (from >= 0 && from < NUM_GROUPS && to >= 0 && to < NUM_GROUPS && from != to) {
-        interWeights[from][to] = std::clamp(interWeights[from][to] + delta, -0.5, 0.5);
+    if (from >= 0 && from < numGroups() && to >= 0 && to < numGroups() && from != to) {
+        interWeights.set(from, to, std::clamp(interWeights.get(from, to) + delta, -0.5, 0.5));
     }
 }
 
@@ -474,12 +581,14 @@ void NeuralFieldSystem::weakenInterConnection(int from, int to, double delta) {
 }
 
 std::vector<float> NeuralFieldSystem::getFeatures() const {
-    std::vector<float> features(64, 0.f);
+    // [0, NG) — средние активности, [NG, 2·NG) — энтропия распределения phi в группе
+    const int NG = numGroups();
+    std::vector<float> features(2 * NG, 0.f);
     auto avgs = getGroupAverages();
-    for (int g = 0; g < NUM_GROUPS; ++g) {
+    for (int g = 0; g < NG; ++g) {
         features[g] = static_cast<float>(avgs[g]);
     }
-    for (int g = 0; g < NUM_GROUPS; ++g) {
+    for (int g = 0; g < NG; ++g) {
         const auto& phi = groups[g].getPhi();
         const int BINS = 10;
         std::vector<int> hist(BINS, 0);
@@ -489,15 +598,22 @@ std::vector<float> NeuralFieldSystem::getFeatures() const {
         double H = 0.0;
         for (int c : hist) {
             if (c > 0) {
-                double p = c / (double)GROUP_SIZE;
+                double p = c / (double)groupSize();
                 H -= p * std::log(p);
             }
         }
-        features[NUM_GROUPS + g] = static_cast<float>(H);
+        features[NG + g] = static_cast<float>(H);
     }
     return features;
 }
 
+void NeuralFieldSystem::setStdpGating(StdpGating::Type gating) {
+    stdp_gating_ = gating;
+    for (auto& g : groups) {
+        g.setStdpGating(gating);
+    }
+}
+
 void NeuralFieldSystem::setOperatingMode(OperatingMode::Type mode) {
     current_mode_ = mode;
     for (auto& g : groups) {
@@ -532,7 +648,7 @@ void NeuralFieldSystem::logSystemHealth() {
     std::map<std::string, double> avg_activity;
     std::map<std::string, int> counts;
     
-    for (int g = 0; g < NUM_GROUPS; ++g) {
+    for (int g = 0; g < numGroups(); ++g) {
         std::string spec = groups[g].getSpecialization();
         avg_activity[spec] += groups[g].getAverageActivity();
         counts[spec]++;
@@ -588,47 +704,55 @@ void NeuralFieldSystem::enterLowPowerMode() {
             for (auto& v : phi) {
                 v = std::max(v * 0.7, 0.2);
             }
+            invalidatePhi(static_cast<int>(&g - groups.data()));
         }
     }
 }
 
 void NeuralFieldSystem::applyTargetPattern(const std::vector<float>& pat) {
-    for (int g = 0; g < 6 && g < (int)pat.size() / GROUP_SIZE; ++g) {
-        auto& phi = groups[SEMANTIC_START + g].getPhiNonConst();
-        for (int i = 0; i < GROUP_SIZE; ++i) {
-            float diff = pat[g * GROUP_SIZE + i] - static_cast<float>(phi[i]);
+    // Паттерн — до 6 семантических групп подряд (меньше, если их меньше в топологии)
+    const int GS = groupSize();
+    const int n_sem = std::min(6, FieldTopology::count(topology_.semantic_start, topology_.semantic_end));
+    for (int g = 0; g < n_sem && g < (int)pat.size() / GS; ++g) {
+        auto& phi = groups[topology_.semantic_start + g].getPhiNonConst();
+        for (int i = 0; i < GS; ++i) {
+            float diff = pat[g * GS + i] - static_cast<float>(phi[i]);
             phi[i] = std::clamp(phi[i] + diff * 0.1, 0.0, 1.0);
         }
+        invalidatePhi(topology_.semantic_start + g);
     }
 }
 
 void NeuralFieldSystem::applyTargetedMutation(double strength, int targetType) {
-    std::mt19937 gen(std::random_device{}());
-    std::uniform_real_distribution<double> d(-strength, strength);
+    // Ключ: (шаг, номер вызова) — воспроизводимо по seed и порядку вызовов
+    const uint32_t call = mutation_calls_++;
+    const int NG = numGroups();
+    auto d = [&](uint32_t index) {
+        return field_rng_.uniform(CounterRng::FIELD_MUTATION, stepCounter, call, index, -strength, strength);
+    };
     
     if (targetType == 0) {
-        for (int i = 0; i < NUM_GROUPS; ++i) {
-            for (int j = 0; j < NUM_GROUPS; ++j) {
-                if (i != j) {
-                    interWeights[i][j] += d(gen) * 0.1;
-                    interWeights[i][j] = std::clamp(interWeights[i][j], -0.5, 0.5);
-                }
-            }
-        }
+        // Шум — только по хранимым связям (в CSR мутация не уплотняет матрицу)
+        interWeights.forEach([&](int i, int j, double& w) {
+            w += d(static_cast<uint32_t>(i * NG + j)) * 0.1;
+            w = std::clamp(w, -0.5, 0.5);
+        });
     } else {
-        std::uniform_int_distribution<> gi(0, NUM_GROUPS - 1);
-        int g = gi(gen);
-        groups[g].setStdpRate(groups[g].getStdpRate() + d(gen) * 0.01f);
+        int g = static_cast<int>(field_rng_.below(CounterRng::FIELD_MUTATION, stepCounter, call,
+                                                  static_cast<uint32_t>(NG * NG), NG));
+        groups[g].setStdpRate(groups[g].getStdpRate() + d(static_cast<uint32_t>(NG * NG + 1)) * 0.01f);
     }
 }
 
 void NeuralFieldSystem::setInputText(const std::vector<float>& sig) {
-    auto& phi = groups[INPUT_GROUP].getPhiNonConst();
-    for (int i = 0; i < GROUP_SIZE && i < (int)sig.size(); ++i) {
+    const FieldTopology& T = topology_;
+    auto& phi = groups[T.input_group].getPhiNonConst();
+    for (int i = 0; i < groupSize() && i < (int)sig.size(); ++i) {
         phi[i] = sig[i];
     }
-    for (int t = SEMANTIC_START; t <= SEMANTIC_END; ++t) {
-        strengthenInterConnection(INPUT_GROUP, t, 0.1);
+    invalidatePhi(T.input_group);
+    for (int t = T.semantic_start; t <= T.semantic_end; ++t) {
+        strengthenInterConnection(T.input_group, t, 0.1);
     }
 }
 
@@ -12,6 +12,12 @@
 #include <mutex>
 #include <memory>
 #include "LagrangianAuditor.hpp"
+#include "FieldTopology.hpp"
+#include "WorkerPool.hpp"
+#include "EntropyTracker.hpp"
+#include "InterGroupWeights.hpp"
+#include <array>
+#include <cstdint>
 #include <map>
 #include <nlohmann/json.hpp>
 
@@ -60,34 +66,87 @@ struct AttentionMechanism {
     }
 };
 
+// ──────────────────────────────────────────────────────────────────────────────
+// FieldFrame — кадр поля за шаг (считается один раз после эволюции групп)
+// ──────────────────────────────────────────────────────────────────────────────
+/**
+ * @struct FieldFrame
+ * @brief То, что фазы step() читают после эволюции: средние, плоские phi/pi
+ *
+ * - averages зависят только от истории спайков — действительны весь шаг
+ * - плоские phi/pi и гистограммы энтропии (EntropyTracker) действительны, пока phi
+ *   групп не менялась; фазы, которые меняют phi, помечают свои группы грязными,
+ *   и при следующем чтении пересчитываются только эти группы
+ */
+struct FieldFrame {
+    int step = -1;
+    std::vector<double>   averages;        // средняя активность групп
+    
+    // phi-зависимая часть (по группам)
+    std::vector<uint8_t> phi_dirty;        // 1 — phi группы изменилась после кадра
+    bool any_phi_dirty = true;
+};
+
+// ──────────────────────────────────────────────────────────────────────────────
+// StepPhaseStats — суммарное время фаз step()
+// ──────────────────────────────────────────────────────────────────────────────
+struct StepPhaseStats {
+    enum Phase {
+        EVOLVE,        // фаза 1: evolve() групп (параллельно)
+        CONTROLLER,    // фаза 2: EmergentController
+        SELF_MODEL,    // фаза 3: self-model
+        INTER_GROUP,   // фаза 4: межгрупповая динамика
+        AUDIT,         // фаза 4.5: Lagrangian аудит
+        STDP,          // фаза 5: награды и learnSTDP (параллельно)
+        CONSOLIDATE,   // фаза 7: консолидация (параллельно по группам)
+        TAIL,          // фазы 8-11
+        COUNT
+    };
+    
+    std::array<double, COUNT> total_us{};
+    uint64_t steps = 0;
+    
+    static const char* toString(Phase p) {
+        switch (p) {
+            case EVOLVE:      return "evolve";
+            case CONTROLLER:  return "controller";
+            case SELF_MODEL:  return "self_model";
+            case INTER_GROUP: return "inter_group";
+            case AUDIT:       return "audit";
+            case STDP:        return "stdp";
+            case CONSOLIDATE: return "consolidate";
+            case TAIL:        return "tail";
+            default:          return "unknown";
+        }
+    }
+    
+    double averageUs(Phase p) const { return steps ? total_us[p] / steps : 0.0; }
+};
+
 // ──────────────────────────────────────────────────────────────────────────────
 // NeuralFieldSystem — новая версия без орбит
 // ──────────────────────────────────────────────────────────────────────────────
 class NeuralFieldSystem : public INeuralGroupAccess {
 public:
-    static constexpr int NUM_GROUPS   = 32;
-    static constexpr int GROUP_SIZE   = 32;
-    static constexpr int TOTAL_NEURONS = NUM_GROUPS * GROUP_SIZE;
-
-    // Роли групп (фиксированные)
-    static constexpr int INPUT_GROUP       = 0;
-    static constexpr int SENSORY_START     = 1;
-    static constexpr int SENSORY_END       = 3;
-    static constexpr int MOTOR_START       = 4;
-    static constexpr int MOTOR_END         = 7;
-    static constexpr int ASSOCIATIVE_START = 8;
-    static constexpr int ASSOCIATIVE_END   = 15;
-    static constexpr int SEMANTIC_START    = 16;
-    static constexpr int SEMANTIC_END      = 21;
-    static constexpr int CONTEXT_START     = 22;
-    static constexpr int CONTEXT_END       = 27;
-    static constexpr int SELF_MODEL_START  = 28;
-    static constexpr int SELF_MODEL_END    = 31;
-
-    NeuralFieldSystem(double dt);
+    // Топология по умолчанию; реальная задаётся в конструкторе (конфиг / --groups, --group-size)
+    static constexpr int DEFAULT_NUM_GROUPS = FieldTopology::DEFAULT_NUM_GROUPS;
+    static constexpr int DEFAULT_GROUP_SIZE = FieldTopology::DEFAULT_GROUP_SIZE;
+
+    NeuralFieldSystem(double dt,
+                      int num_groups = DEFAULT_NUM_GROUPS,
+                      int group_size = DEFAULT_GROUP_SIZE);
     ~NeuralFieldSystem() = default;
 
-    void initialize(std::mt19937& rng);
+    // Размеры поля и роли групп
+    int numGroups() const { return topology_.num_groups; }
+    int groupSize() const { return topology_.group_size; }
+    int totalNeurons() const { return topology_.totalNeurons(); }
+    const FieldTopology& topology() const { return topology_; }
+
+    // Все случайные числа поля выводятся из seed (см. CounterRng)
+    void initialize(uint64_t seed);
+    void initialize(std::mt19937& rng);  // seed из двух чисел rng
+    uint64_t getSeed() const { return seed_; }
     
     NeuralFieldSystem(const NeuralFieldSystem&) = delete;
     NeuralFieldSystem& operator=(const NeuralFieldSystem&) = delete;
@@ -103,16 +162,33 @@ public:
     void step(float external_reward, int stepNumber);
     int getCurrentStep() const { return stepCounter; }
 
+    // Потоки для пофазной обработки групп (вызывающий поток входит в счёт;
+    // 1 — последовательно, <= 0 — по числу ядер). Результат от числа потоков не зависит.
+    void setWorkerThreads(int threads);
+    int getWorkerThreads() const { return pool_->threads(); }
+    const StepPhaseStats& getPhaseStats() const { return phase_stats_; }
+    void resetPhaseStats() { phase_stats_ = StepPhaseStats{}; }
+
     // Состояние системы
-    const std::vector<double>& getPhi() const { rebuildFlatVectors(); return flatPhi; }
-    const std::vector<double>& getPi()  const { rebuildFlatVectors(); return flatPi; }
+    const std::vector<double>& getPhi() const { refreshPhiFrame(); return flatPhi; }
+    const std::vector<double>& getPi()  const { refreshPhiFrame(); return flatPi; }
     std::vector<double> getGroupAverages() const;
-    const std::vector<std::vector<double>>& getInterWeights() const { return interWeights; }
+    const FieldFrame& frame() const { refreshPhiFrame(); return frame_; }
+    // Вызывать после изменения phi группы g снаружи (например, инжекции self-model)
+    void invalidatePhi(int g) { frame_.phi_dirty[g] = 1; frame_.any_phi_dirty = true; }
+    const InterGroupWeights& getInterWeights() const { return interWeights; }
+    // Формат межгрупповых весов (по умолчанию AUTO: CSR для разреженной топологии)
+    void setInterWeightStorage(InterWeightStorage::Type storage) { interWeights.setStorage(storage); }
+    // Активностный STDP во всех группах (по умолчанию OFF: он меняет пластичность)
+    void setStdpGating(StdpGating::Type gating);
+    StdpGating::Type getStdpGating() const { return stdp_gating_; }
     
     // Энтропия и энергия (упрощённые)
     double computeSystemEntropy() const;
     double getUnifiedEntropy() const;
     double getTargetUnifiedEntropy() const;
+    // Сверка инкрементальных гистограмм энтропии с полным пересчётом по phi (--bench)
+    bool checkEntropyConsistency() const;
 
     // Emergent компоненты
     const EmergentSignal& lastSignal() const { return lastSignal_; }
@@ -216,51 +292,68 @@ public:
         double energy = 0.0;
         double kinetic = 0.0;
         double potential = 0.0;
+        double neural_lagrangian = 0.0;
         double energy_error = 0.0;
         double entropy = 0.0;
         double target_entropy = 0.5;
         double surprise = 0.0;
         double quality = 0.0;
         double temperature = 1.0;
+        uint64_t seed = 0;
+        int step = 0;
         size_t stm_size = 0;
         size_t ltm_size = 0;
         int violations = 0;
+        bool audit_enabled = true;
+        LagrangianAuditorConfig audit_config;
         std::map<std::string, bool> constraints;
+        // Пути синаптического входа и STDP — суммы по группам с запуска
+        SynapticInputStats synaptic_input;
+        StdpStats stdp;
+        StdpGating::Type stdp_gating = StdpGating::OFF;
         
         nlohmann::json toJson() const {
             nlohmann::json j;
             j["energy"] = energy;
             j["kinetic"] = kinetic;
             j["potential"] = potential;
+            j["neural_lagrangian"] = neural_lagrangian;
             j["energy_error"] = energy_error;
             j["entropy"] = entropy;
             j["target_entropy"] = target_entropy;
             j["surprise"] = surprise;
             j["quality"] = quality;
             j["temperature"] = temperature;
+            j["seed"] = seed;
+            j["step"] = step;
             j["stm_size"] = stm_size;
             j["ltm_size"] = ltm_size;
             j["violations"] = violations;
+            j["audit_enabled"] = audit_enabled;
             j["constraints"] = constraints;
+            j["synaptic_input"] = {{"sparse_steps", synaptic_input.sparse_steps},
+                                   {"dense_steps", synaptic_input.dense_steps},
+                                   {"silent_steps", synaptic_input.silent_steps},
+                                   {"events", synaptic_input.events}};
+            j["stdp"] = {{"gating", StdpGating::toString(stdp_gating)},
+                         {"dense_calls", stdp.dense_calls},
+                         {"gated_calls", stdp.gated_calls},
+                         {"gated_synapses", stdp.gated_synapses}};
             return j;
         }
     };
     
-    SystemSnapshot getSystemSnapshot() const {
-        SystemSnapshot snap;
-        snap.energy = lagrangian_auditor_.getReferenceEnergy();
-        snap.energy_error = lagrangian_auditor_.getEnergyError();
-        snap.violations = static_cast<int>(lagrangian_auditor_.getConservationViolations());
-        snap.entropy = getUnifiedEntropy();
-        snap.target_entropy = getTargetUnifiedEntropy();
-        snap.surprise = lastSignal_.surprise;
-        snap.quality = lastSignal_.quality;
-        snap.temperature = attention.temperature;
-        snap.stm_size = emergent_.memory.stmSize();
-        snap.ltm_size = emergent_.memory.ltmSize();
-        // constraints нужно заполнить извне или добавить поле в EmergentSignal
-        return snap;
+    // Снимок, опубликованный в конце последнего step() (RCU: новый снимок —
+    // новый объект, указатель меняется атомарно). Читатели из HTTP/SSE потоков
+    // не берут блокировок поля и не ждут шаг; старый снимок живёт, пока его держат.
+    std::shared_ptr<const SystemSnapshot> getPublishedSnapshot() const {
+        return std::atomic_load(&published_snapshot_);
     }
+    SystemSnapshot getSystemSnapshot() const { return *getPublishedSnapshot(); }
+    
+    // Собрать и опубликовать снимок. Вызывается потоком, который двигает поле:
+    // конец step(), initialize() и после изменения настроек аудита.
+    void publishSnapshot();
 
 private:
     // Основные компоненты
@@ -268,6 +361,7 @@ private:
     EmergentSignal     lastSignal_;
     AttentionMechanism attention;
     OperatingMode::Type current_mode_ = OperatingMode::NORMAL;
+    StdpGating::Type stdp_gating_ = StdpGating::OFF;
     EmergentMemory*     memory_manager = nullptr;
     
     // Self-model
@@ -276,15 +370,33 @@ private:
     // Мьютекс
     mutable std::mutex system_mutex_;
 
+    // Последний опубликованный снимок (только через atomic_load / atomic_store)
+    std::shared_ptr<const SystemSnapshot> published_snapshot_;
+
     // Группы нейронов
     double dt_;
+    FieldTopology topology_;
     std::vector<NeuralGroup> groups;
-    std::vector<std::vector<double>> interWeights;
+    InterGroupWeights interWeights;
 
-    // Кэши для внешнего доступа
+    // Кадр поля, плоские phi/pi (часть кадра) и гистограммы энтропии по phi
+    mutable FieldFrame frame_;
+    mutable EntropyTracker entropy_;
     mutable std::vector<double> flatPhi, flatPi;
-    mutable bool flatDirty = true;
-    void rebuildFlatVectors() const;
+    void captureGroupFrame(int g) const;   // слот группы g: средняя, phi/pi, бины энтропии
+    void finishFrame(int step);            // перенос бинов в гистограммы после эволюции
+    void refreshPhiFrame() const;          // пересчёт грязных групп
+
+    // Случайность: seed сессии и поток для мутаций уровня поля
+    static constexpr uint32_t FIELD_RNG_STREAM = 0xFFFFFFFFu;
+    uint64_t seed_ = 0;
+    CounterRng field_rng_;
+    uint32_t mutation_calls_ = 0;
+
+    // Пул потоков и время фаз
+    std::unique_ptr<WorkerPool> pool_;
+    StepPhaseStats phase_stats_;
+    std::vector<float> group_rewards_;
 
     // Счётчики и состояние
     int stepCounter = 0;
@@ -305,6 +417,7 @@ private:
     void routeRewards(const EmergentSignal& sig, int step);
     
     // Вспомогательные
+    void nudgePhi(int g, double delta);
     void setupFixedInterConnections();
     void setupGroupSpecializations();
     
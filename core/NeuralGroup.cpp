@@ -3,26 +3,31 @@
 #include <algorithm>
 #include <iostream>
 #include <numeric>
-#include <random>
 #include <deque>
+#include <cstring>
 
 // ============================================================================
 // КОНСТРУКТОР
 // ============================================================================
 
-NeuralGroup::NeuralGroup(int size, double dt, std::shared_ptr<std::mt19937> rng)
-    : size_(size), dt_(dt), rng_(std::move(rng))
+NeuralGroup::NeuralGroup(int size, double dt, const CounterRng& rng)
+    : size_(size), dt_(dt), rng_(rng)
 {
-    if (!rng_) {
-        throw std::runtime_error("NeuralGroup: RNG is null");
-    }
     // Инициализация мембранных полей
     V_.resize(size_, membrane_params_.v_rest);
     V_threshold_.resize(size_, membrane_params_.v_threshold_base);
     spike_.resize(size_, false);
     last_spike_step_.resize(size_, -1000);
     refractory_.resize(size_, 0);
-    spike_history_.resize(size_);
+    spike_history_.resize(size_, SPIKE_HISTORY_WINDOW);
+    active_spikes_.reserve(size_);
+    syn_input_.resize(size_, 0.0);
+    active_mask_.resize(size_, 0.0);
+    lif_state_.resize(size_, LifKernel::QUIET);
+    stdp_last_spike_.resize(size_, -1000000);
+    stdp_boost_.resize(size_, 1.0f);
+    stdp_recent_.resize((size_ + 63) / 64, 0);
+    stdp_recent_list_.reserve(size_);
     
     // Инициализация трофических полей
     trophic_signal_.resize(size_, 0.0);
@@ -34,18 +39,17 @@ NeuralGroup::NeuralGroup(int size, double dt, std::shared_ptr<std::mt19937> rng)
     plasticity_boost_.resize(size_, 1.0f);
     low_rate_timer_.resize(size_, 0);
     
-    // Инициализация весов (слабые случайные)
-    W_.assign(size_, std::vector<double>(size_, 0.0));
-    std::uniform_real_distribution<double> weight_dist(-0.1, 0.1);
-    for (int i = 0; i < size_; ++i) {
-        for (int j = i + 1; j < size_; ++j) {
-            double w = weight_dist(*rng_);
-            W_[i][j] = w;
-            W_[j][i] = w;
-        }
-    }
+    // Кэш Lagrangian
+    rate_cache_.resize(size_, 0.0);
+    potential_cache_.resize(size_, 0.0);
+    lagrangian_.resize(size_, 0.0);
     
-    buildSynapsesFromWeights();
+    // Инициализация весов (слабые случайные) — сразу в хранилище синапсов
+    synapses_.resize(size_);
+    for (size_t k = 0; k < synapses_.size(); ++k) {
+        synapses_.weight[k] = static_cast<float>(
+            rng_.uniform(CounterRng::INIT_WEIGHTS, 0, 0, static_cast<uint32_t>(k), -0.1, 0.1));
+    }
 }
 
 // ============================================================================
@@ -93,48 +97,199 @@ void NeuralGroup::evolve() {
 // ----------------------------------------------------------------------------
 
 void NeuralGroup::updateMembranePotentials() {
-    // Оптимизация: сбор активных спайков
-    std::vector<int> active_spikes;
-    active_spikes.reserve(size_);
+    // Сбор спайков предыдущего шага и синаптический ток от них
+    active_spikes_.clear();
     for (int j = 0; j < size_; ++j) {
         if (spike_[j] && step_counter_ - last_spike_step_[j] == 1) {
-            active_spikes.push_back(j);
+            active_spikes_.push_back(j);
         }
     }
+    accumulateSynapticInput();
+    const double* I = syn_input_.data();
+    if (!external_current_.empty()) {
+        for (int i = 0; i < size_; ++i) lif_input_[i] = syn_input_[i] + external_current_[i];
+        I = lif_input_.data();
+    }
+    
+    // Утечка, интегрирование, порог и адаптация — векторным ядром
+    LifKernel::Params p;
+    p.v_rest = membrane_params_.v_rest;
+    p.v_reset = membrane_params_.v_reset;
+    p.v_threshold_base = membrane_params_.v_threshold_base;
+    p.v_threshold_max = membrane_params_.v_threshold_max;
+    p.c_m = membrane_params_.c_m;
+    p.g_leak = membrane_params_.g_leak;
+    p.dt = dt_;
+    p.spike_adaptation = membrane_params_.spike_adaptation;
+    p.threshold_decay = membrane_params_.threshold_decay;
+    p.refractory_period = membrane_params_.refractory_period;
+    LifKernel::step(lif_kernel_, p, size_, V_.data(), V_threshold_.data(),
+                    refractory_.data(), I, lif_state_.data());
     
+    // Спайки и история (рефрактерные нейроны в историю не пишутся)
     for (int i = 0; i < size_; ++i) {
-        if (refractory_[i] > 0) {
-            refractory_[i]--;
-            spike_[i] = false;
-            continue;
+        const uint8_t s = lif_state_[i];
+        spike_[i] = (s == LifKernel::SPIKE);
+        if (s == LifKernel::REFRACTORY) continue;
+        if (spike_[i]) last_spike_step_[i] = step_counter_;
+        spike_history_.push(i, spike_[i]);
+    }
+}
+
+// Синаптический ток I_i = Σ_j W_ij s_j по спайкам предыдущего шага.
+// Оба пути складывают вклады в порядке возрастания j — результат совпадает.
+void NeuralGroup::accumulateSynapticInput() {
+    std::fill(syn_input_.begin(), syn_input_.end(), 0.0);
+    
+    const int active = static_cast<int>(active_spikes_.size());
+    if (active == 0) {
+        input_stats_.silent_steps++;
+        return;
+    }
+    input_stats_.events += active;
+    
+    bool dense = input_mode_ == SynapticInputMode::DENSE ||
+                 (input_mode_ == SynapticInputMode::AUTO &&
+                  active > dense_input_threshold_ * size_);
+    
+    const float* w = synapses_.weight.data();
+    double* I = syn_input_.data();
+    
+    if (!dense) {
+        // Событийный путь: каждый активный нейрон j рассылает свою строку
+        input_stats_.sparse_steps++;
+        for (int j : active_spikes_) {
+            // i < j: столбец j верхнего треугольника (шаг уменьшается на 1)
+            for (int i = 0; i < j; ++i) {
+                I[i] += w[SynapseStore::index(i, j, size_)];
+            }
+            // i > j: непрерывный отрезок строки j
+            const float* seg = w + SynapseStore::rowStart(j, size_);
+            double* out = I + j + 1;
+            const int len = size_ - j - 1;
+            for (int t = 0; t < len; ++t) {
+                out[t] += seg[t];
+            }
         }
-        
-        double I_syn = 0.0;
-        for (int j : active_spikes) {
-            I_syn += W_[j][i];
+        return;
+    }
+    
+    // Плотный путь: один проход по треугольнику, вклад в оба конца синапса
+    input_stats_.dense_steps++;
+    std::fill(active_mask_.begin(), active_mask_.end(), 0.0);
+    for (int j : active_spikes_) active_mask_[j] = 1.0;
+    
+    const double* s = active_mask_.data();
+    const float* row = w;
+    for (int a = 0; a < size_; ++a) {
+        const int len = size_ - a - 1;
+        const double* s_row = s + a + 1;
+        double acc = I[a];
+        for (int t = 0; t < len; ++t) {
+            acc += row[t] * s_row[t];
         }
+        I[a] = acc;
+        if (s[a] != 0.0) {
+            double* out = I + a + 1;
+            for (int t = 0; t < len; ++t) {
+                out[t] += row[t];
+            }
+        }
+        row += len;
+    }
+}
+
+void NeuralGroup::setExternalCurrent(int i, double I) {
+    if (i < 0 || i >= size_) return;
+    if (external_current_.empty()) {
+        if (I == 0.0) return;
+        external_current_.assign(size_, 0.0);
+        lif_input_.assign(size_, 0.0);
+    }
+    external_current_[i] = I;
+}
+
+// Ток подобран так, что нейроны под ним спайкают синхронно на первом шаге
+// после рефрактерности: на шагах со спайками доля активных равна active / size.
+bool NeuralGroup::checkSynapticInputModes(int size, int active, uint64_t seed,
+                                          SynapticInputStats* auto_stats) {
+    constexpr int STEPS = 60;
+    const SynapticInputMode::Type modes[] = {
+        SynapticInputMode::SPARSE, SynapticInputMode::DENSE, SynapticInputMode::AUTO
+    };
+    
+    std::vector<double> reference;  // I_syn и V всех шагов первого режима
+    bool same = true;
+    for (SynapticInputMode::Type mode : modes) {
+        NeuralGroup g(size, 0.01, CounterRng(seed, 0));
+        g.setSynapticInputMode(mode);
+        for (int k = 0; k < active; ++k) g.setExternalCurrent(k * size / active, 5000.0);
         
-        double I_leak = -membrane_params_.g_leak * (V_[i] - membrane_params_.v_rest);
-        V_[i] += dt_ * (I_syn + I_leak) / membrane_params_.c_m;
-        
-        if (V_[i] > V_threshold_[i]) {
-            spike_[i] = true;
-            last_spike_step_[i] = step_counter_;
-            refractory_[i] = membrane_params_.refractory_period;
-            V_[i] = membrane_params_.v_reset;
-            V_threshold_[i] += membrane_params_.spike_adaptation;
-            V_threshold_[i] = std::min(V_threshold_[i], membrane_params_.v_threshold_max);
-        } else {
-            spike_[i] = false;
-            V_threshold_[i] = V_threshold_[i] * membrane_params_.threshold_decay 
-                            + membrane_params_.v_threshold_base * (1.0 - membrane_params_.threshold_decay);
+        std::vector<double> trace;
+        trace.reserve(static_cast<size_t>(STEPS) * 2 * size);
+        for (int s = 0; s < STEPS; ++s) {
+            g.evolve();
+            trace.insert(trace.end(), g.syn_input_.begin(), g.syn_input_.end());
+            trace.insert(trace.end(), g.V_.begin(), g.V_.end());
         }
+        if (mode == SynapticInputMode::AUTO && auto_stats) *auto_stats = g.input_stats_;
+        if (g.input_stats_.events == 0) same = false;  // без спайков сравнивать нечего
         
-        spike_history_[i].push_back(spike_[i]);
-        if (spike_history_[i].size() > SPIKE_HISTORY_WINDOW) {
-            spike_history_[i].pop_front();
+        if (reference.empty()) {
+            reference = std::move(trace);
+        } else if (std::memcmp(trace.data(), reference.data(), trace.size() * sizeof(double)) != 0) {
+            same = false;
         }
     }
+    return same;
+}
+
+// ----------------------------------------------------------------------------
+// Сохранение энергии (Lagrangian constraint)
+// ----------------------------------------------------------------------------
+
+void NeuralGroup::computeLagrangians() {
+    for (int i = 0; i < size_; ++i) {
+        rate_cache_[i] = spike_history_.rate(i);
+    }
+    
+    // Потенциальная часть |W|·r: каждый синапс (i<j) отдаёт вклад обоим концам
+    std::fill(potential_cache_.begin(), potential_cache_.end(), 0.0);
+    const float* w = synapses_.weight.data();
+    int k = 0;
+    for (int i = 0; i < size_; ++i) {
+        double r_i = rate_cache_[i];
+        double pot_i = potential_cache_[i];
+        for (int j = i + 1; j < size_; ++j, ++k) {
+            double aw = std::abs(w[k]);
+            pot_i += aw * rate_cache_[j];
+            potential_cache_[j] += aw * r_i;
+        }
+        potential_cache_[i] = pot_i;
+    }
+    
+    group_lagrangian_ = 0.0;
+    for (int i = 0; i < size_; ++i) {
+        lagrangian_[i] = rate_cache_[i] - 0.5 * potential_cache_[i];
+        group_lagrangian_ += lagrangian_[i];
+    }
+}
+
+void NeuralGroup::enforceEnergyConservation() {
+    computeLagrangians();
+    double current_energy = group_lagrangian_;
+    
+    // Если энергия упала — восстановить
+    if (current_energy < conserved_energy_ * 0.95) {
+        double deficit = conserved_energy_ - current_energy;
+        // Распределить дефицит как "толчок"
+        for (int i = 0; i < size_; ++i) {
+            if (rate_cache_[i] < 0.5) {
+                V_[i] += deficit * 0.01 * dt_;
+            }
+        }
+    }
+    conserved_energy_ = conserved_energy_ * 0.999 + current_energy * 0.001;
 }
 
 // ----------------------------------------------------------------------------
@@ -146,13 +301,19 @@ void NeuralGroup::updateTrophicSignals() {
     std::fill(trophic_signal_.begin(), trophic_signal_.end(), 0.0);
     
     // Каждый нейрон выделяет трофин пропорционально своей активности и важности
+    std::vector<double> trophic_out(size_);
     for (int i = 0; i < size_; ++i) {
-        double trophic_out = computeTrophicOutput(i);
-        
-        // Передаём трофин постсинаптическим нейронам
-        for (int j = 0; j < size_; ++j) {
-            if (i != j && std::abs(W_[i][j]) > 0.01) {
-                trophic_signal_[j] += trophic_out * std::abs(W_[i][j]) * 0.1;
+        trophic_out[i] = computeTrophicOutput(i);
+    }
+    
+    // Передаём трофин по синапсам (синапс симметричен — обе стороны за один проход)
+    int k = 0;
+    for (int i = 0; i < size_; ++i) {
+        for (int j = i + 1; j < size_; ++j, ++k) {
+            double w = std::abs(synapses_.weight[k]);
+            if (w > 0.01) {
+                trophic_signal_[j] += trophic_out[i] * w * 0.1;
+                trophic_signal_[i] += trophic_out[j] * w * 0.1;
             }
         }
     }
@@ -222,8 +383,9 @@ void NeuralGroup::checkApoptosis() {
             will.incoming.resize(size_);
             will.outgoing.resize(size_);
             for (int j = 0; j < size_; ++j) {
-                will.incoming[j] = W_[j][i];
-                will.outgoing[j] = W_[i][j];
+                double w = getWeight(i, j);   // синапс симметричен
+                will.incoming[j] = w;
+                will.outgoing[j] = w;
             }
             will_pool_.push_back(will);
             if (will_pool_.size() > MAX_WILL_POOL) will_pool_.pop_front();
@@ -254,27 +416,22 @@ void NeuralGroup::neurogenesis(int i) {
     plasticity_boost_[i] = neuro_params_.plasticity_boost;
     
     // Небольшая случайная мутация оставшихся связей
-    static std::uniform_real_distribution<double> mutation_dist(-0.05, 0.05);
     for (int j = 0; j < size_; ++j) {
         if (i != j) {
-            W_[i][j] += mutation_dist(*rng_);
-            W_[j][i] = W_[i][j];
-            W_[i][j] = std::clamp(W_[i][j], -1.0, 1.0);
-            W_[j][i] = W_[i][j];
+            float& w = synapses_.weight[getSynapseIndex(i, j)];
+            double mutation = rng_.uniform(CounterRng::NEUROGENESIS, step_counter_, i, j, -0.05, 0.05);
+            w = static_cast<float>(std::clamp(w + mutation, -1.0, 1.0));
         }
     }
-    
-    syncWeightsFromSynapses();
 }
 
 void NeuralGroup::inheritBestPattern(int i) {
     if (will_pool_.empty()) {
         // Если нет завещаний — случайная инициализация
-        static std::uniform_real_distribution<double> init_dist(-0.2, 0.2);
         for (int j = 0; j < size_; ++j) {
             if (i != j) {
-                W_[i][j] = init_dist(*rng_);
-                W_[j][i] = W_[i][j];
+                synapses_.weight[getSynapseIndex(i, j)] = static_cast<float>(
+                    rng_.uniform(CounterRng::INHERIT, step_counter_, i, j, -0.2, 0.2));
             }
         }
         return;
@@ -287,13 +444,12 @@ void NeuralGroup::inheritBestPattern(int i) {
         });
     
     // Наследование: 70% от лучшего, 30% случайная мутация
-    static std::uniform_real_distribution<double> mutation_dist(-0.05, 0.05);
     for (int j = 0; j < size_; ++j) {
         if (i != j) {
             double inherited = best->outgoing[j] * 0.7;
-            double mutation = mutation_dist(*rng_) * 0.3;
-            W_[i][j] = std::clamp(inherited + mutation, -1.0, 1.0);
-            W_[j][i] = W_[i][j];
+            double mutation = rng_.uniform(CounterRng::INHERIT, step_counter_, i, j, -0.05, 0.05) * 0.3;
+            synapses_.weight[getSynapseIndex(i, j)] =
+                static_cast<float>(std::clamp(inherited + mutation, -1.0, 1.0));
         }
     }
 }
@@ -303,88 +459,232 @@ void NeuralGroup::inheritBestPattern(int i) {
 // ----------------------------------------------------------------------------
 
 void NeuralGroup::learnSTDP(float reward, int currentStep) {
-    // Использование LUT для оптимизации
-    static const auto exp_plus = getExpPlus();
-    static const auto exp_minus = []() {
-        std::array<float, 21> arr{};
-        for (int dt = 0; dt <= 20; ++dt) {
-            arr[dt] = std::exp(-static_cast<float>(dt) / 20.0f);
-        }
-        return arr;
-    }();
-    
-    int synIndex = 0;
-    
+    // Времена спайков и множители критического периода — по нейронам, один раз
     for (int i = 0; i < size_; ++i) {
-        for (int j = i + 1; j < size_; ++j) {
-            if (synIndex >= static_cast<int>(synapses_.size())) break;
-            
-            auto& syn = synapses_[synIndex++];
-            
-            if (spike_[i]) syn.lastPreFire = static_cast<float>(currentStep);
-            if (spike_[j]) syn.lastPostFire = static_cast<float>(currentStep);
-            
-            float dt = syn.lastPostFire - syn.lastPreFire;
-            float delta = 0.0f;
-            
-            int dt_int = static_cast<int>(std::abs(dt));
-            if (dt > 0 && dt_int <= 20) {
-                delta = params_.A_plus * exp_plus[dt_int];
-            } else if (dt < 0 && dt_int <= 20) {
-                delta = -params_.A_minus * exp_minus[dt_int];
+        if (spike_[i]) stdp_last_spike_[i] = currentStep;
+        stdp_boost_[i] = critical_period_remaining_[i] > 0 ? plasticity_boost_[i] : 1.0f;
+    }
+    
+    bool gated = stdp_gating_ == StdpGating::ALWAYS ||
+                 (stdp_gating_ == StdpGating::LOW_ACTIVITY &&
+                  (current_mode_ == OperatingMode::IDLE || current_mode_ == OperatingMode::SLEEP));
+    if (gated) {
+        // Битсет нейронов со спайком за последние WINDOW шагов
+        const int32_t since = currentStep - StdpKernel::WINDOW;
+        std::fill(stdp_recent_.begin(), stdp_recent_.end(), 0);
+        stdp_recent_list_.clear();
+        for (int i = 0; i < size_; ++i) {
+            if (stdp_last_spike_[i] >= since) {
+                stdp_recent_[i >> 6] |= uint64_t(1) << (i & 63);
+                stdp_recent_list_.push_back(i);
             }
-            
-            float reward_factor = std::min(1.0f, reward);
-            float boost = 1.0f;
-            if (critical_period_remaining_[i] > 0) boost *= plasticity_boost_[i];
-            if (critical_period_remaining_[j] > 0) boost *= plasticity_boost_[j];
-            
-            float weight_change = params_.stdpRate * reward_factor * delta * boost;
-            
-            syn.eligibility = syn.eligibility * params_.eligibilityDecay + delta;
-            syn.eligibility = std::clamp(syn.eligibility, -0.1f, 0.1f);
-            
-            syn.weight += weight_change;
-            syn.weight = std::clamp(syn.weight, -params_.maxWeight, params_.maxWeight);
-            
-            W_[i][j] = syn.weight;
-            W_[j][i] = syn.weight;
         }
+        // При высокой активности выборочный обход дороже полного
+        gated = stdp_recent_list_.size() <= STDP_GATE_MAX_FRACTION * size_;
+    }
+    // Плотный проход ведёт eligibility явно — сначала догнать отложенное затухание
+    if (!gated) flushEligibility();
+    stdp_calls_++;
+    
+    // LUT пересобирается только при смене амплитуд
+    if (params_.A_plus != stdp_lut_A_plus_ || params_.A_minus != stdp_lut_A_minus_) {
+        stdp_lut_ = StdpKernel::buildLut(params_.A_plus, params_.A_minus);
+        stdp_lut_A_plus_ = params_.A_plus;
+        stdp_lut_A_minus_ = params_.A_minus;
+    }
+    StdpKernel::Params p;
+    p.lut = stdp_lut_.data();
+    p.scale = params_.stdpRate * std::min(1.0f, reward);
+    p.decay = params_.eligibilityDecay;
+    p.max_weight = params_.maxWeight;
+    
+    auto& weight = synapses_.weight;
+    if (gated) {
+        learnSTDPGated(p);
+    } else {
+        // Построчно по упакованному треугольнику: синапсы (i, i+1..N-1) непрерывны
+        stdp_stats_.dense_calls++;
+        StdpKernel::triangle(stdp_kernel_, p, size_, weight.data(), synapses_.eligibility.data(),
+                             stdp_last_spike_.data(), stdp_boost_.data());
     }
     
     if (step_counter_ % 100 == 0) {
-        for (int i = 0; i < size_; ++i) {
-            for (int j = i + 1; j < size_; ++j) {
-                if (std::abs(W_[i][j]) < 0.01f) {
-                    W_[i][j] *= 0.99f;
-                    W_[j][i] = W_[i][j];
-                }
+        for (auto& w : weight) {
+            if (std::abs(w) < 0.01f) {
+                w *= 0.99f;
             }
         }
     }
 }
 
+// Активностный режим: обходятся только синапсы, у которых пре или пост
+// спайкнул за последние WINDOW шагов (stdp_recent_). Остальные пропускаются
+// целиком: их вес не меняется, хотя полный проход по правилу последних спайков
+// дал бы им ненулевую delta, — поэтому режим меняет пластичность и включается
+// явно. Затухание eligibility пропущенных синапсов применяется лениво:
+// e *= decay^(пропущенных вызовов) при следующем касании или в catchUpEligibility()
+// (консолидация, переход на полный проход).
+void NeuralGroup::learnSTDPGated(const StdpKernel::Params& p) {
+    stdp_stats_.gated_calls++;
+    
+    // Отметки ставятся и для вызова без активных нейронов, иначе его затухание потеряется
+    if (!eligibility_lazy_) {
+        // Все синапсы актуальны на предыдущий вызов; старые отметки не выше базы
+        if (eligibility_stamp_.empty()) eligibility_stamp_.assign(synapses_.size(), 0);
+        eligibility_touched_.assign(stdp_recent_.size(), 0);
+        eligibility_base_ = stdp_calls_ - 1;
+        eligibility_lazy_ = true;
+    }
+    if (stdp_recent_list_.empty()) return;
+    
+    float* w = synapses_.weight.data();
+    float* e = synapses_.eligibility.data();
+    int32_t* stamp = eligibility_stamp_.data();
+    const int32_t* T = stdp_last_spike_.data();
+    const float* g = stdp_boost_.data();
+    const int32_t call = stdp_calls_;
+    const int32_t base_stamp = eligibility_base_;
+    const int32_t span = StdpKernel::WINDOW + 1;
+    
+    const float* decay_pow = eligibilityDecayPowers();
+    auto catchUp = [&](int k) {
+        int32_t gap = call - 1 - std::max(stamp[k], base_stamp);
+        if (gap > 0) {
+            e[k] *= gap < DECAY_POW_TABLE ? decay_pow[gap] : std::pow(p.decay, static_cast<float>(gap));
+        }
+        stamp[k] = call;
+    };
+    
+    uint64_t visited = 0;
+    for (int r : stdp_recent_list_) {
+        eligibility_touched_[r >> 6] |= uint64_t(1) << (r & 63);
+        // Столбец r (i < r): только неактивные i — активные обойдут синапс своей строкой
+        for (int i = 0; i < r; ++i) {
+            if (stdp_recent_[i >> 6] >> (i & 63) & 1) continue;
+            const int k = SynapseStore::index(i, r, size_);
+            catchUp(k);
+            int32_t dt = std::clamp(T[r] - T[i], -span, span);
+            float delta = p.lut[dt + span];
+            float weight_change = p.scale * delta * (g[i] * g[r]);
+            e[k] = std::clamp(e[k] * p.decay + delta, -0.1f, 0.1f);
+            w[k] = std::clamp(w[k] + weight_change, -p.max_weight, p.max_weight);
+            visited++;
+        }
+        // Строка r (j > r): непрерывный отрезок — догнать затухание и отдать векторному ядру
+        const int base = SynapseStore::rowStart(r, size_);
+        const int len = size_ - r - 1;
+        for (int k = base; k < base + len; ++k) catchUp(k);
+        StdpKernel::row(stdp_kernel_, p, len, w + base, e + base, T + r + 1, g + r + 1, T[r], g[r]);
+        visited += len;
+    }
+    stdp_stats_.gated_synapses += visited;
+}
+
+// Синапсы вне строк и столбцов затронутых нейронов ждут одного и того же
+// затухания decay^(вызовы - база) — они отдаются отрезками с общим множителем;
+// затронутые синапсы — по одному, с множителем по своей отметке.
+// run(from, to, f): синапсы [from, to) умножить на f (1 — затухания нет).
+template <class Run>
+void NeuralGroup::walkPendingDecay(Run run) {
+    const int32_t calls = stdp_calls_;
+    const float* decay_pow = eligibilityDecayPowers();
+    auto factor = [&](int32_t gap) {
+        if (gap <= 0) return 1.0f;
+        return gap < DECAY_POW_TABLE ? decay_pow[gap] : std::pow(params_.eligibilityDecay, static_cast<float>(gap));
+    };
+    const float f = factor(calls - eligibility_base_);
+    
+    touched_list_.clear();
+    for (int i = 0; i < size_; ++i) {
+        if (eligibility_touched_[i >> 6] >> (i & 63) & 1) touched_list_.push_back(i);
+    }
+    
+    const int32_t* stamp = eligibility_stamp_.data();
+    auto single = [&](int k) {
+        run(k, k + 1, factor(calls - std::max(stamp[k], eligibility_base_)));
+    };
+    
+    size_t next = 0;   // первый затронутый нейрон правее строки
+    for (int i = 0; i < size_ - 1; ++i) {
+        const int base = SynapseStore::rowStart(i, size_);
+        const int end = base + size_ - i - 1;
+        while (next < touched_list_.size() && touched_list_[next] <= i) ++next;
+        if (eligibility_touched_[i >> 6] >> (i & 63) & 1) {
+            for (int k = base; k < end; ++k) single(k);
+            continue;
+        }
+        // Строка нетронутого нейрона: общий множитель между затронутыми столбцами
+        int from = base;
+        for (size_t t = next; t < touched_list_.size(); ++t) {
+            const int k = base + touched_list_[t] - i - 1;
+            run(from, k, f);
+            single(k);
+            from = k + 1;
+        }
+        run(from, end, f);
+    }
+    
+    eligibility_base_ = calls;
+    std::fill(eligibility_touched_.begin(), eligibility_touched_.end(), 0);
+}
+
+void NeuralGroup::catchUpEligibility() {
+    float* e = synapses_.eligibility.data();
+    walkPendingDecay([e](int from, int to, float f) {
+        if (f == 1.0f) return;
+        for (int k = from; k < to; ++k) e[k] *= f;
+    });
+}
+
+void NeuralGroup::flushEligibility() {
+    if (!eligibility_lazy_) return;
+    catchUpEligibility();
+    eligibility_lazy_ = false;
+}
+
+// decay^g для g < DECAY_POW_TABLE, пересчёт только при смене eligibilityDecay
+const float* NeuralGroup::eligibilityDecayPowers() {
+    if (decay_pow_.empty() || decay_pow_base_ != params_.eligibilityDecay) {
+        decay_pow_base_ = params_.eligibilityDecay;
+        decay_pow_.resize(DECAY_POW_TABLE);
+        for (int g = 0; g < DECAY_POW_TABLE; ++g) {
+            decay_pow_[g] = std::pow(decay_pow_base_, static_cast<float>(g));
+        }
+    }
+    return decay_pow_.data();
+}
+
 // ----------------------------------------------------------------------------
 // КОНСОЛИДАЦИЯ
 // ----------------------------------------------------------------------------
 
 void NeuralGroup::consolidate() {
-    for (auto& syn : synapses_) {
-        syn.weight += params_.consolidationRate * syn.eligibility;
-        syn.eligibility *= 0.9f;
-        syn.weight = std::clamp(syn.weight, -params_.maxWeight, params_.maxWeight);
-    }
-    syncWeightsFromSynapses();
+    transferEligibility(params_.consolidationRate, 0.9f);
 }
 
 void NeuralGroup::consolidateEligibility(float globalImportance) {
     // Аналогично consolidate, но с фактором важности
-    for (auto& syn : synapses_) {
-        syn.weight += params_.consolidationRate * globalImportance * syn.eligibility;
-        syn.eligibility *= 0.5f;
-        syn.weight = std::clamp(syn.weight, -params_.maxWeight, params_.maxWeight);
+    transferEligibility(params_.consolidationRate * globalImportance, 0.5f);
+}
+
+// w += rate * e, e *= keep. В активностном режиме отложенное затухание
+// догоняется в том же проходе (e *= f перед переносом), режим не сбрасывается
+void NeuralGroup::transferEligibility(float rate, float keep) {
+    float* w = synapses_.weight.data();
+    float* e = synapses_.eligibility.data();
+    const float max_weight = params_.maxWeight;
+    auto run = [=](int from, int to, float f) {
+        for (int k = from; k < to; ++k) {
+            const float ek = e[k] * f;
+            w[k] = std::clamp(w[k] + rate * ek, -max_weight, max_weight);
+            e[k] = ek * keep;
+        }
+    };
+    if (eligibility_lazy_) {
+        walkPendingDecay(run);
+    } else {
+        run(0, static_cast<int>(synapses_.size()), 1.0f);
     }
-    syncWeightsFromSynapses();
 }
 
 // ----------------------------------------------------------------------------
@@ -397,18 +697,22 @@ double NeuralGroup::getFiringRate(int i) const {
 
 double NeuralGroup::getFiringRateImpl(int i) const {
     if (i < 0 || i >= size_) return 0.0;
-    if (spike_history_[i].empty()) return 0.0;
-    int spike_count = 0;
-    for (bool s : spike_history_[i]) if (s) spike_count++;
-    return static_cast<double>(spike_count) / SPIKE_HISTORY_WINDOW;
+    return spike_history_.rate(i);
 }
 
-double NeuralGroup::getAverageActivity() const {
-    double sum = 0.0;
-    for (int i = 0; i < size_; ++i) {
-        sum += getFiringRateImpl(i);
+void NeuralGroup::firingRates(float* out, int count) const {
+    if (count >= size_) {
+        spike_history_.rates(out);
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        out[i] = static_cast<float>(spike_history_.rate(i));
     }
-    return sum / size_;
+}
+
+double NeuralGroup::getAverageActivity() const {
+    // Сумма по окнам поддерживается в SpikeHistory — O(1)
+    return static_cast<double>(spike_history_.totalCount()) / (spike_history_.window() * size_);
 }
 
 const std::vector<double>& NeuralGroup::getPhi() const {
@@ -444,25 +748,22 @@ void NeuralGroup::updateCache() const {
 
 void NeuralGroup::setWeight(int i, int j, double w) {
     if (i >= 0 && i < size_ && j >= 0 && j < size_) {
-        W_[i][j] = std::clamp(w, -1.0, 1.0);
-        W_[j][i] = W_[i][j];
         int idx = getSynapseIndex(i, j);
-        if (idx >= 0 && idx < (int)synapses_.size()) {
-            synapses_[idx].weight = W_[i][j];
+        if (idx >= 0) {
+            synapses_.weight[idx] = static_cast<float>(std::clamp(w, -1.0, 1.0));
         }
     }
 }
 
 double NeuralGroup::getWeight(int i, int j) const {
-    if (i >= 0 && i < size_ && j >= 0 && j < size_) return W_[i][j];
+    if (i >= 0 && i < size_ && j >= 0 && j < size_) return getWeights()(i, j);
     return 0.0;
 }
 
 void NeuralGroup::decayAllWeights(float factor) {
-    for (auto& syn : synapses_) {
-        syn.weight *= factor;
+    for (auto& w : synapses_.weight) {
+        w *= factor;
     }
-    syncWeightsFromSynapses();
 }
 
 void NeuralGroup::updateElevationFast(float reward, float activity) {
@@ -487,45 +788,19 @@ void NeuralGroup::applyGlobalPenalty(float penalty) {
     elevation_ = std::clamp(elevation_, -1.0f, 1.0f);
 }
 
-void NeuralGroup::buildSynapsesFromWeights() {
-    synapses_.clear();
-    for (int i = 0; i < size_; ++i) {
-        for (int j = i + 1; j < size_; ++j) {
-            Synapse syn;
-            syn.weight = static_cast<float>(W_[i][j]);
-            synapses_.push_back(syn);
-        }
-    }
-}
-
-void NeuralGroup::syncWeightsFromSynapses() {
-    int idx = 0;
-    for (int i = 0; i < size_; ++i) {
-        for (int j = i + 1; j < size_; ++j) {
-            if (idx < (int)synapses_.size()) {
-                W_[i][j] = synapses_[idx].weight;
-                W_[j][i] = synapses_[idx].weight;
-                idx++;
-            }
-        }
-    }
-}
-
 int NeuralGroup::getSynapseIndex(int i, int j) const {
     if (i == j) return -1;
     if (i > j) std::swap(i, j);
-    return i * size_ - (i * (i + 1)) / 2 + (j - i - 1);
+    return SynapseStore::index(i, j, size_);
 }
 
 void NeuralGroup::logStats() const {
     double avg_weight = 0.0;
     int nonzero = 0;
-    for (int i = 0; i < size_; ++i) {
-        for (int j = 0; j < size_; ++j) {
-            if (i != j && std::abs(W_[i][j]) > 0.01) {
-                avg_weight += std::abs(W_[i][j]);
-                nonzero++;
-            }
+    for (float w : synapses_.weight) {
+        if (std::abs(w) > 0.01) {
+            avg_weight += std::abs(w);
+            nonzero++;
         }
     }
     if (nonzero > 0) avg_weight /= nonzero;
@@ -539,5 +814,7 @@ void NeuralGroup::logStats() const {
               << "Active: " << active << "/" << size_
               << ", Avg weight: " << avg_weight
               << ", Elevation: " << elevation_
+              << ", Input sparse/dense/silent: " << input_stats_.sparse_steps
+              << "/" << input_stats_.dense_steps << "/" << input_stats_.silent_steps
               << std::endl;
 }
\ No newline at end of file
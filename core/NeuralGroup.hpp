@@ -8,9 +8,14 @@
 #include <algorithm>
 #include <iostream>
 #include "Synapse.hpp"
+#include "SpikeHistory.hpp"
+#include "LifKernel.hpp"
+#include "StdpKernel.hpp"
 #include "OperatingMode.hpp"
+#include "CounterRng.hpp"
 
 #include <memory>  // для shared_ptr
+#include <cstdint>
 #include <array>   // для LUT
 
 
@@ -56,6 +61,68 @@ struct MembraneParams {
     MembraneParams() = default;
 };
 
+/**
+ * @struct SynapticInputMode
+ * @brief Способ расчёта синаптического тока от спайков предыдущего шага
+ */
+struct SynapticInputMode {
+    enum Type {
+        AUTO,    // событийный, пока доля активных ниже порога, иначе плотный
+        SPARSE,  // всегда событийный (scatter строк активных нейронов)
+        DENSE    // всегда плотный проход по всей матрице
+    };
+};
+
+/**
+ * @struct SynapticInputStats
+ * @brief Счётчики выбранных путей расчёта синаптического тока
+ */
+struct SynapticInputStats {
+    uint64_t sparse_steps = 0;   // шагов событийного пути
+    uint64_t dense_steps = 0;    // шагов плотного пути
+    uint64_t silent_steps = 0;   // шагов без активных спайков
+    uint64_t events = 0;         // всего разосланных пресинаптических спайков
+};
+
+/**
+ * @struct StdpGating
+ * @brief Когда STDP обходит только синапсы недавно спайкнувших нейронов
+ *
+ * Активностный режим не эквивалентен полному проходу: синапсы между молчащими
+ * нейронами в нём не учатся. По умолчанию OFF.
+ */
+struct StdpGating {
+    enum Type {
+        OFF,           // всегда полный проход по треугольнику
+        LOW_ACTIVITY,  // активностный режим в IDLE и SLEEP
+        ALWAYS         // активностный режим во всех режимах
+    };
+
+    static const char* toString(Type t) {
+        switch (t) {
+            case LOW_ACTIVITY: return "low_activity";
+            case ALWAYS:       return "always";
+            default:           return "off";
+        }
+    }
+
+    static Type fromString(const std::string& name) {
+        if (name == "low_activity") return LOW_ACTIVITY;
+        if (name == "always") return ALWAYS;
+        return OFF;
+    }
+};
+
+/**
+ * @struct StdpStats
+ * @brief Счётчики путей STDP
+ */
+struct StdpStats {
+    uint64_t dense_calls = 0;     // полных проходов
+    uint64_t gated_calls = 0;     // вызовов в активностном режиме
+    uint64_t gated_synapses = 0;  // синапсов, обойдённых в активностном режиме
+};
+
 /**
  * @class NeuralGroup
  * @brief Группа нейронов с LIF динамикой, STDP, трофическими сигналами и апоптозом
@@ -69,8 +136,8 @@ struct MembraneParams {
  */
 class NeuralGroup {
 public:
-    // используем shared_ptr для безопасного владения RNG
-    NeuralGroup(int size, double dt, std::shared_ptr<std::mt19937> rng);
+    // Группа хранит копию ключа счётного RNG (seed поля, индекс группы)
+    NeuralGroup(int size, double dt, const CounterRng& rng);
 
     ~NeuralGroup() = default;
     
@@ -90,13 +157,40 @@ public:
     double getMembranePotential(int i) const { return i >= 0 && i < size_ ? V_[i] : 0.0; }
     bool getSpike(int i) const { return i >= 0 && i < size_ ? spike_[i] : false; }
     double getFiringRate(int i) const;
+    void firingRates(float* out, int count) const;   // все частоты за один проход
+    
+    // ===== СИНАПТИЧЕСКИЙ ВХОД =====
+    void setSynapticInputMode(SynapticInputMode::Type m) { input_mode_ = m; }
+    SynapticInputMode::Type getSynapticInputMode() const { return input_mode_; }
+    // Доля активных нейронов, выше которой AUTO переходит на плотный путь
+    void setDenseInputThreshold(double f) { dense_input_threshold_ = std::clamp(f, 0.0, 1.0); }
+    double getDenseInputThreshold() const { return dense_input_threshold_; }
+    const SynapticInputStats& getSynapticInputStats() const { return input_stats_; }
+    const std::vector<double>& getSynapticInput() const { return syn_input_; }  // I_syn последнего evolve()
+    // Внешний ток нейрона i, прибавляется к I_syn в каждом evolve() (0 — снять)
+    void setExternalCurrent(int i, double I);
+    void clearExternalCurrent() { external_current_.clear(); }
+    // SPARSE, DENSE и AUTO на одной затравленной группе с active нейронами под
+    // внешним током: true, если спайки были, а I_syn и V совпадают бит в бит на каждом шаге.
+    // auto_stats — счётчики путей прогона AUTO
+    static bool checkSynapticInputModes(int size, int active, uint64_t seed,
+                                        SynapticInputStats* auto_stats = nullptr);
+    // Ядро LIF: по умолчанию лучшее из поддерживаемых процессором
+    void setLifKernel(SimdLevel::Type t) { lif_kernel_ = SimdLevel::supported(t) ? t : SimdLevel::SCALAR; }
+    SimdLevel::Type getLifKernel() const { return lif_kernel_; }
+    void setStdpKernel(SimdLevel::Type t) { stdp_kernel_ = SimdLevel::supported(t) ? t : SimdLevel::SCALAR; }
+    SimdLevel::Type getStdpKernel() const { return stdp_kernel_; }
+    void setStdpGating(StdpGating::Type g) { stdp_gating_ = g; }
+    StdpGating::Type getStdpGating() const { return stdp_gating_; }
+    const StdpStats& getStdpStats() const { return stdp_stats_; }
+    void resetSynapticInputStats() { input_stats_ = SynapticInputStats{}; }
     
     // ===== ТРОФИЧЕСКИЕ СИГНАЛЫ =====
     void setNeurotrophinParams(const NeurotrophinParams& p) { neuro_params_ = p; }
     // ===== СИНАПСЫ =====
     void setWeight(int i, int j, double w);
     double getWeight(int i, int j) const;
-    const std::vector<std::vector<double>>& getWeights() const { return W_; }
+    WeightMatrixView getWeights() const { return {synapses_.weight.data(), size_}; }
     void decayAllWeights(float factor);
     
     // ===== АКТИВНОСТЬ (для обратной совместимости) =====
@@ -107,7 +201,6 @@ public:
     std::vector<double>& getPiNonConst();
 
     // ===== NEW DATA =====
-    std::vector<std::deque<bool>> spike_history_;
     static constexpr int SPIKE_HISTORY_WINDOW = 100;
     void setCurrentMode(OperatingMode::Type mode) { current_mode_ = mode; }
     OperatingMode::Type getCurrentMode() const { return current_mode_; }
@@ -116,8 +209,6 @@ public:
         return i >= 0 && i < size_ ? trophic_accumulator_[i] : 0.0; 
     }
     int getNeuronCount() const { return size_; }
-    // Для captureFromNeuron (дружественный доступ)
-    const std::vector<std::vector<double>>& getWeightMatrix() const { return W_; }
     // Добавить константу
     static constexpr int MAX_NEURONS = 1024;
     
@@ -139,6 +230,8 @@ public:
     
     // ===== ПАМЯТЬ =====
     void setMemoryManager(EmergentMemory* mm) { memory_manager_ = mm; }
+    // Ключ случайных чисел группы (seed поля, индекс группы)
+    const CounterRng& getRng() const { return rng_; }
     void setSpecialization(const std::string& spec) { specialization_ = spec; }
     const std::string& getSpecialization() const { return specialization_; }
     void setSelfModelGroup(bool v) { is_self_model_group_ = v; }
@@ -157,32 +250,24 @@ public:
         double kinetic = getFiringRate(neuron_idx);  // текущая активность
         
         double potential = 0.0;
-        for (int j = 0; j < size_; ++j) {
-            potential += std::abs(W_[neuron_idx][j]) * getFiringRate(j);
+        const auto& w = synapses_.weight;
+        for (int j = 0; j < neuron_idx; ++j) {   // синапсы (j, i), j < i
+            potential += std::abs(w[SynapseStore::index(j, neuron_idx, size_)]) * getFiringRate(j);
+        }
+        const float* seg = w.data() + SynapseStore::rowStart(neuron_idx, size_);
+        for (int j = neuron_idx + 1; j < size_; ++j) {   // отрезок строки (i, j), j > i
+            potential += std::abs(seg[j - neuron_idx - 1]) * getFiringRate(j);
         }
         
         return kinetic - 0.5 * potential;  // Lagrangian
     }
     
     // Сохранение энергии — ОГРАНИЧЕНИЕ, а не цель
-    void enforceEnergyConservation() {
-        double current_energy = 0.0;
-        for (int i = 0; i < size_; ++i) {
-            current_energy += computeNeuralLagrangian(i);
-        }
-        
-        // Если энергия упала — восстановить
-        if (current_energy < conserved_energy_ * 0.95) {
-            double deficit = conserved_energy_ - current_energy;
-            // Распределить дефицит как "толчок"
-            for (int i = 0; i < size_; ++i) {
-                if (getFiringRate(i) < 0.5) {
-                    V_[i] += deficit * 0.01 * dt_;
-                }
-            }
-        }
-        conserved_energy_ = conserved_energy_ * 0.999 + current_energy * 0.001;
-    }
+    void enforceEnergyConservation();
+    
+    // Lagrangian всех нейронов с последнего evolve() (без пересчёта)
+    const std::vector<double>& getNeuralLagrangians() const { return lagrangian_; }
+    double getGroupLagrangian() const { return group_lagrangian_; }
     
 private:
     // ===== ФУНДАМЕНТАЛЬНЫЕ ПАРАМЕТРЫ =====
@@ -198,8 +283,21 @@ private:
     std::vector<bool> spike_;               // спайк на текущем шаге
     std::vector<int> last_spike_step_;      // время последнего спайка
     std::vector<int> refractory_;           // счётчик рефрактерности
+    SpikeHistory spike_history_;            // окно спайков (битовое кольцо)
     MembraneParams membrane_params_;
     
+    // ===== СИНАПТИЧЕСКИЙ ВХОД =====
+    std::vector<int> active_spikes_;        // спайки предыдущего шага
+    std::vector<double> syn_input_;         // I_syn по постсинаптическим нейронам
+    std::vector<double> active_mask_;       // 0/1 по active_spikes_ (плотный путь)
+    SynapticInputMode::Type input_mode_ = SynapticInputMode::AUTO;
+    double dense_input_threshold_ = 0.25;
+    SynapticInputStats input_stats_;
+    std::vector<double> external_current_;  // пусто — внешнего тока нет
+    std::vector<double> lif_input_;         // I_syn + внешний ток
+    SimdLevel::Type lif_kernel_ = LifKernel::best();
+    std::vector<uint8_t> lif_state_;        // LifKernel::State по нейронам
+    
     // ===== ТРОФИЧЕСКИЕ СИГНАЛЫ =====
     std::vector<double> trophic_signal_;    // получаемый трофин (вход)
     std::vector<double> trophic_accumulator_; // накопленный трофин (скользящее среднее)
@@ -220,9 +318,28 @@ private:
     static constexpr int MAX_WILL_POOL = 50;
     
     // ===== СВЯЗИ =====
-    std::vector<std::vector<double>> W_;    // веса (size_ x size_)
-    std::vector<Synapse> synapses_;         // синапсы для STDP
+    SynapseStore synapses_;                 // единственное хранилище весов (i<j, SoA)
     PlasticityParams params_;               // параметры пластичности
+    std::vector<int32_t> stdp_last_spike_;  // шаг последнего спайка, учтённого STDP
+    std::vector<float> stdp_boost_;         // множитель критического периода (или 1)
+    SimdLevel::Type stdp_kernel_ = StdpKernel::best();
+    StdpKernel::Lut stdp_lut_{};            // delta(dt) для текущих A_plus/A_minus
+    float stdp_lut_A_plus_ = -1.0f;
+    float stdp_lut_A_minus_ = -1.0f;
+    StdpGating::Type stdp_gating_ = StdpGating::OFF;
+    static constexpr double STDP_GATE_MAX_FRACTION = 0.25;  // выше — полный проход
+    StdpStats stdp_stats_;
+    int32_t stdp_calls_ = 0;                // число вызовов learnSTDP
+    std::vector<uint64_t> stdp_recent_;     // битсет: спайк за последние WINDOW шагов
+    std::vector<int> stdp_recent_list_;     // те же нейроны списком
+    std::vector<int32_t> eligibility_stamp_; // вызов, на который eligibility актуальна (не ниже базы)
+    int32_t eligibility_base_ = 0;          // все нетронутые синапсы актуальны на этот вызов
+    std::vector<uint64_t> eligibility_touched_; // битсет: нейроны, чьи синапсы касались после базы
+    std::vector<int> touched_list_;         // те же нейроны списком (для catchUpEligibility)
+    bool eligibility_lazy_ = false;         // есть отложенное затухание
+    static constexpr int DECAY_POW_TABLE = 256;
+    std::vector<float> decay_pow_;          // eligibilityDecay^g
+    float decay_pow_base_ = 0.0f;
     
     // ===== ВСПОМОГАТЕЛЬНЫЕ ПОЛЯ (для обратной совместимости) =====
     mutable std::vector<double> phi_cache_;
@@ -240,37 +357,35 @@ private:
     EmergentMemory* memory_manager_ = nullptr;
     bool is_input_group_ = false;
     bool is_self_model_group_ = false;
-    std::shared_ptr<std::mt19937> rng_;  // shared_ptr
+    CounterRng rng_;  // (seed, группа); числа — функция (шаг, нейрон, индекс)
     // новые переменные для ии
-    double conserved_energy_;  // "Lagrangian" группы
+    double conserved_energy_ = 0.0;  // "Lagrangian" группы
+    std::vector<double> rate_cache_;     // частоты на момент расчёта Lagrangian
+    std::vector<double> potential_cache_; // Σ_j |W_ij| r_j
+    std::vector<double> lagrangian_;     // L_i = r_i - ½ Σ_j |W_ij| r_j
+    double group_lagrangian_ = 0.0;      // Σ_i L_i
     std::vector<double> canonical_momentum_;  // обобщённый импульс
     
     // ===== ПРИВАТНЫЕ МЕТОДЫ =====
     void updateMembranePotentials();           // обновление V, спайки
+    void accumulateSynapticInput();            // syn_input_ от active_spikes_
     void updateTrophicSignals();               // расчёт трофинов
     void checkApoptosis();                     // проверка условий смерти
     void neurogenesis(int i);                  // рождение нового нейрона
     void inheritBestPattern(int i);            // наследование из will_pool_
-    void buildSynapsesFromWeights();           // синхронизация W_ → synapses_
-    void syncWeightsFromSynapses();            // синхронизация synapses_ → W_
     void updateCache() const;                  // обновление phi_cache_, pi_cache_
+    void computeLagrangians();                 // lagrangian_ за один проход по синапсам
+    void learnSTDPGated(const StdpKernel::Params& p);
+    void flushEligibility();                   // применить отложенное затухание eligibility
+    void catchUpEligibility();                 // то же, не выходя из активностного режима
+    template <class Run> void walkPendingDecay(Run run);  // отрезки синапсов с общим множителем затухания
+    void transferEligibility(float rate, float keep);     // консолидация: w += rate·e, e *= keep
+    const float* eligibilityDecayPowers();     // таблица decay^g
     int getSynapseIndex(int i, int j) const;   // индекс в линейном массиве
     
     // Вспомогательные
     double computeTrophicOutput(int i) const;  // сколько трофина выделяет нейрон
     double getFiringRateImpl(int i) const;     // частота спайков (Гц)
-
-    // STDP LUT для оптимизации
-    static const std::array<float, 21> getExpPlus() {
-        static const std::array<float, 21> arr = []() {
-            std::array<float, 21> a{};
-            for (int dt = 0; dt <= 20; ++dt) {
-                a[dt] = std::exp(-static_cast<float>(dt) / 20.0f);
-            }
-            return a;
-        }();
-        return arr;
-    }
 };
 
 // ============================================================================
@@ -19,6 +19,7 @@ void SelfSignalSampler::reset() {
     neurogenesis_ema_ = 0.0f;
     consolidation_ema_ = 0.0f;
     firing_rate_ema_ = 0.0f;
+    low_trophic_ema_ = 0.0f;
     
     quality_history_.clear();
     entropy_history_.clear();
@@ -42,60 +43,50 @@ SelfSnapshot SelfSignalSampler::sample(const NeuralFieldSystem& sys,
     step_counter_ = step;
     SelfSnapshot snap;
     
-    const auto& groups = sys.getGroups();
-    constexpr int NG = NeuralFieldSystem::NUM_GROUPS;
-    constexpr int GS = NeuralFieldSystem::GROUP_SIZE;
+    const FieldTopology& T = sys.topology();
+    // Средние активности групп — из кадра поля, без обхода истории спайков
+    const std::vector<double>& averages = sys.frame().averages;
+    
+    // Средняя активность диапазона групп [start, end]
+    auto rangeAvg = [&averages](int start, int end) {
+        float sum = 0.0f;
+        for (int g = start; g <= end; ++g) {
+            sum += averages[g];
+        }
+        return end >= start ? sum / static_cast<float>(end - start + 1) : 0.0f;
+    };
     
     // ===== 1. АКТИВНОСТЬ НЕЙРОНОВ (16 сигналов) =====
+    // Номера групп в комментариях — для топологии 32 групп
     
     // Сенсорные группы (1-3)
-    float sensory_sum = 0.0f;
-    for (int g = NeuralFieldSystem::SENSORY_START; g <= NeuralFieldSystem::SENSORY_END; ++g) {
-        sensory_sum += groups[g].getAverageActivity();
-    }
-    snap.sensory_avg_rate = sensory_sum / 3.0f;
+    snap.sensory_avg_rate = rangeAvg(T.sensory_start, T.sensory_end);
     
     // Моторные группы (4-7)
-    float motor_sum = 0.0f;
-    for (int g = NeuralFieldSystem::MOTOR_START; g <= NeuralFieldSystem::MOTOR_END; ++g) {
-        motor_sum += groups[g].getAverageActivity();
-    }
-    snap.motor_avg_rate = motor_sum / 4.0f;
+    snap.motor_avg_rate = rangeAvg(T.motor_start, T.motor_end);
     
-    // Семантические группы (16-21) — каждая индивидуально
+    // Семантические группы (16-21) — каждая индивидуально (первые 6, остальные нули)
+    const int n_sem = FieldTopology::count(T.semantic_start, T.semantic_end);
     for (int i = 0; i < 6; ++i) {
-        int g = NeuralFieldSystem::SEMANTIC_START + i;
-        snap.semantic_rates[i] = groups[g].getAverageActivity();
+        snap.semantic_rates[i] = i < n_sem ? static_cast<float>(averages[T.semantic_start + i]) : 0.0f;
     }
     
     // Ассоциативные группы (8-15) — объединяем в 4 сигнала
-    // 8-11 (первые 4) и 12-15 (следующие 4)
-    float assoc_first_sum = 0.0f, assoc_second_sum = 0.0f;
-    for (int g = NeuralFieldSystem::ASSOCIATIVE_START; g <= NeuralFieldSystem::ASSOCIATIVE_END; ++g) {
-        if (g < NeuralFieldSystem::ASSOCIATIVE_START + 4) {
-            assoc_first_sum += groups[g].getAverageActivity();
-        } else {
-            assoc_second_sum += groups[g].getAverageActivity();
-        }
-    }
-    snap.associative_rates[0] = assoc_first_sum / 4.0f;
-    snap.associative_rates[1] = assoc_second_sum / 4.0f;
+    // 8-11 (первая половина) и 12-15 (вторая половина)
+    const int n_assoc = FieldTopology::count(T.associative_start, T.associative_end);
+    const int assoc_mid = T.associative_start + std::max(1, n_assoc / 2);
+    snap.associative_rates[0] = rangeAvg(T.associative_start, assoc_mid - 1);
+    snap.associative_rates[1] = assoc_mid <= T.associative_end
+                              ? rangeAvg(assoc_mid, T.associative_end)
+                              : snap.associative_rates[0];
     snap.associative_rates[2] = (snap.associative_rates[0] + snap.associative_rates[1]) / 2.0f;
     snap.associative_rates[3] = std::abs(snap.associative_rates[0] - snap.associative_rates[1]);
     
     // Контекстные группы (22-27)
-    float context_sum = 0.0f;
-    for (int g = NeuralFieldSystem::CONTEXT_START; g <= NeuralFieldSystem::CONTEXT_END; ++g) {
-        context_sum += groups[g].getAverageActivity();
-    }
-    snap.context_avg_rate = context_sum / 6.0f;
+    snap.context_avg_rate = rangeAvg(T.context_start, T.context_end);
     
     // Self-model группы (28-31)
-    float self_sum = 0.0f;
-    for (int g = NeuralFieldSystem::SELF_MODEL_START; g <= NeuralFieldSystem::SELF_MODEL_END; ++g) {
-        self_sum += groups[g].getAverageActivity();
-    }
-    snap.self_model_avg_rate = self_sum / 4.0f;
+    snap.self_model_avg_rate = rangeAvg(T.self_model_start, T.self_model_end);
     
     // ===== 2. ПАМЯТЬ (4 сигнала) =====
     
@@ -180,16 +171,19 @@ SelfSnapshot SelfSignalSampler::sample(const NeuralFieldSystem& sys,
 void SelfSignalSampler::inject(NeuralFieldSystem& sys, const SelfSnapshot& snap) {
     auto signals = snap.toVector();
     auto& groups = sys.getGroupsNonConst();
+    const FieldTopology& T = sys.topology();
     float alpha = injection_strength;
     
-    for (int gi = 0; gi < SELF_GROUP_COUNT; ++gi) {
-        int group_idx = SELF_GROUP_START + gi;
-        if (group_idx >= NeuralFieldSystem::NUM_GROUPS) break;
-        
-        auto& phi = groups[group_idx].getPhiNonConst();
-        int base = gi * SIGNALS_PER_GROUP;
+    // Сигналы раскладываются по первым SELF_GROUP_COUNT self-model группам;
+    // если групп меньше, на каждую приходится больше сигналов (сколько влезет)
+    const int n_groups = std::min(SELF_GROUP_COUNT, FieldTopology::count(T.self_model_start, T.self_model_end));
+    const int per_group = std::min(sys.groupSize(), (TOTAL_SIGNALS + n_groups - 1) / n_groups);
+    
+    for (int gi = 0; gi < n_groups; ++gi) {
+        auto& phi = groups[T.self_model_start + gi].getPhiNonConst();
+        int base = gi * per_group;
         
-        for (int ni = 0; ni < SIGNALS_PER_GROUP; ++ni) {
+        for (int ni = 0; ni < per_group; ++ni) {
             if (base + ni >= (int)signals.size()) break;
             float signal = signals[base + ni];
             // Плавное смешивание с текущей активностью
@@ -198,6 +192,7 @@ void SelfSignalSampler::inject(NeuralFieldSystem& sys, const SelfSnapshot& snap)
             if (phi[ni] < 0.0) phi[ni] = 0.0;
             if (phi[ni] > 1.0) phi[ni] = 1.0;
         }
+        sys.invalidatePhi(T.self_model_start + gi);
     }
 }
 
@@ -227,34 +222,25 @@ float SelfSignalSampler::computeTrend(const std::deque<float>& history, int wind
 }
 
 float SelfSignalSampler::computeActivityLevel(const NeuralFieldSystem& sys) const {
-    const auto& groups = sys.getGroups();
-    constexpr int GS = NeuralFieldSystem::GROUP_SIZE;
-    
+    // Плоская phi из кадра поля — без обхода групп
     int active_count = 0;
     int total_neurons = 0;
     
-    for (const auto& group : groups) {
-        const auto& phi = group.getPhi();
-        for (float activity : phi) {
-            if (activity > 0.1f) active_count++;
-            total_neurons++;
-        }
+    for (float activity : sys.getPhi()) {
+        if (activity > 0.1f) active_count++;
+        total_neurons++;
     }
     
     return total_neurons > 0 ? static_cast<float>(active_count) / total_neurons : 0.0f;
 }
 
 float SelfSignalSampler::computeAverageFiringRate(const NeuralFieldSystem& sys) const {
-    const auto& groups = sys.getGroups();
     float sum = 0.0f;
     int total = 0;
     
-    for (const auto& group : groups) {
-        const auto& phi = group.getPhi();
-        for (float activity : phi) {
-            sum += activity;
-            total++;
-        }
+    for (float activity : sys.getPhi()) {
+        sum += activity;
+        total++;
     }
     
     float current_avg = total > 0 ? sum / total : 0.0f;
@@ -294,11 +280,10 @@ int SelfSignalSampler::countApoptosisEvents(const NeuralFieldSystem& sys) const
         }
     }
     
-    // Сглаживаем через EMA
-    static float low_trophic_ema = 0.0f;
-    low_trophic_ema = computeEma(low_trophic_ema, low_trophic_count / 1024.0f);
+    // Сглаживаем через EMA (доля от всех нейронов поля)
+    low_trophic_ema_ = computeEma(low_trophic_ema_, low_trophic_count / static_cast<float>(sys.totalNeurons()));
     
-    return static_cast<int>(low_trophic_ema * 100.0f);
+    return static_cast<int>(low_trophic_ema_ * 100.0f);
 }
 
 int SelfSignalSampler::countNeurogenesisEvents(const NeuralFieldSystem& sys) const {
@@ -149,9 +149,8 @@ struct SelfSnapshot {
 
 class SelfSignalSampler {
 public:
-    // Группы для инжекции self-signals
-    static constexpr int SELF_GROUP_START = 28;
-    static constexpr int SELF_GROUP_COUNT = 4;      // группы 28, 29, 30, 31
+    // Группы для инжекции self-signals — первые из self-model диапазона топологии
+    static constexpr int SELF_GROUP_COUNT = 4;      // группы 28, 29, 30, 31 при 32 группах
     static constexpr int SIGNALS_PER_GROUP = 8;     // 4 × 8 = 32 сигнала
     static constexpr int TOTAL_SIGNALS = SELF_GROUP_COUNT * SIGNALS_PER_GROUP; // = 32
     
@@ -185,6 +184,7 @@ private:
     float neurogenesis_ema_ = 0.0f;
     float consolidation_ema_ = 0.0f;
     mutable float firing_rate_ema_ = 0.0f;
+    mutable float low_trophic_ema_ = 0.0f;
     
     // История для вычисления трендов
     std::deque<float> quality_history_;
@@ -0,0 +1,45 @@
+#pragma once
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_LEVEL_X86 1
+#include <immintrin.h>
+#endif
+
+// --------------------
+// Уровень SIMD для векторных ядер (LIF, STDP)
+// --------------------
+/**
+ * @struct SimdLevel
+ * @brief Набор инструкций ядра и его проверка по CPUID во время выполнения
+ *
+ * На не-x86 сборках поддерживается только SCALAR.
+ * Векторные пути собираются через __attribute__((target(...))), поэтому
+ * флаги -mavx2/-mavx512f для всего проекта не нужны.
+ */
+struct SimdLevel {
+    enum Type {
+        SCALAR,
+        AVX2,
+        AVX512
+    };
+
+    static bool supported(Type t) {
+        switch (t) {
+            case SCALAR: return true;
+#ifdef SIMD_LEVEL_X86
+            case AVX2:   return __builtin_cpu_supports("avx2");
+            case AVX512: return __builtin_cpu_supports("avx512f");
+#endif
+            default:     return false;
+        }
+    }
+
+    static const char* toString(Type t) {
+        switch (t) {
+            case SCALAR: return "SCALAR";
+            case AVX2:   return "AVX2";
+            case AVX512: return "AVX512";
+            default:     return "UNKNOWN";
+        }
+    }
+};
@@ -0,0 +1,203 @@
+#include "SimulationLoop.hpp"
+#include "NeuralFieldSystem.hpp"
+#include <algorithm>
+
+SimulationLoop::SimulationLoop(NeuralFieldSystem& nfs)
+    : SimulationLoop(nfs, Config{}) {}
+
+SimulationLoop::SimulationLoop(NeuralFieldSystem& nfs, Config config)
+    : nfs_(nfs), config_(config) {
+    stats_.queue_capacity = config_.capacity;
+}
+
+SimulationLoop::~SimulationLoop() {
+    stop();
+}
+
+void SimulationLoop::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) return;
+    running_ = true;
+    stopping_ = false;
+    thread_ = std::thread([this]() { run(); });
+}
+
+void SimulationLoop::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return;
+        stopping_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+    if (thread_.joinable()) thread_.join();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    drained_.notify_all();
+}
+
+bool SimulationLoop::isRunning() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_ && !stopping_;
+}
+
+SimulationLoop::SubmitResult SimulationLoop::submit(FieldCommand cmd) {
+    return submit(std::move(cmd), std::chrono::milliseconds(0));
+}
+
+SimulationLoop::SubmitResult SimulationLoop::submit(FieldCommand cmd, std::chrono::milliseconds wait) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_ || stopping_) return STOPPED;
+    if (queue_.size() >= config_.capacity) {
+        if (wait.count() <= 0 ||
+            !not_full_.wait_for(lock, wait, [this]() {
+                return stopping_ || queue_.size() < config_.capacity;
+            })) {
+            stats_.rejected++;
+            return QUEUE_FULL;
+        }
+        if (stopping_) return STOPPED;
+    }
+
+    cmd.enqueued = std::chrono::steady_clock::now();
+    queue_.push_back(std::move(cmd));
+    ++submitted_seq_;
+    stats_.accepted++;
+    stats_.high_water = std::max(stats_.high_water, queue_.size());
+    lock.unlock();
+    not_empty_.notify_one();
+    return ACCEPTED;
+}
+
+void SimulationLoop::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const uint64_t target = submitted_seq_;
+    drained_.wait(lock, [&]() { return applied_seq_ >= target || !running_; });
+}
+
+SimulationStats SimulationLoop::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SimulationStats s = stats_;
+    s.queue_depth = queue_.size();
+    s.backpressure = queue_.size() * 4 >= config_.capacity * 3;
+    s.avg_latency_us = s.commands ? latency_sum_us_ / s.commands : 0.0;
+    s.avg_step_us = s.steps ? step_sum_us_ / s.steps : 0.0;
+    return s;
+}
+
+void SimulationLoop::run() {
+    std::vector<FieldCommand> batch;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) break;  // stopping_ и всё выполнено
+            batch.assign(std::make_move_iterator(queue_.begin()), std::make_move_iterator(queue_.end()));
+            queue_.clear();
+        }
+        not_full_.notify_all();
+
+        applyBatch(batch);
+        batch.clear();
+    }
+    drained_.notify_all();
+}
+
+void SimulationLoop::applyBatch(std::vector<FieldCommand>& batch) {
+    const auto now = std::chrono::steady_clock::now();
+    double latency_sum = 0.0, latency_max = 0.0;
+    for (const auto& cmd : batch) {
+        double us = std::chrono::duration<double, std::micro>(now - cmd.enqueued).count();
+        latency_sum += us;
+        latency_max = std::max(latency_max, us);
+    }
+
+    // TASK делит пакет: слияние шагов не переходит через него
+    auto seg_begin = batch.begin();
+    for (auto it = batch.begin(); it != batch.end(); ++it) {
+        if (it->type == FieldCommand::TASK) {
+            applySegment(seg_begin, it);
+            if (it->task) it->task(nfs_);
+            seg_begin = it + 1;
+        }
+    }
+    applySegment(seg_begin, batch.end());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        applied_seq_ += batch.size();
+        stats_.commands += batch.size();
+        stats_.batches++;
+        latency_sum_us_ += latency_sum;
+        stats_.max_latency_us = std::max(stats_.max_latency_us, latency_max);
+    }
+    drained_.notify_all();
+}
+
+void SimulationLoop::applySegment(std::vector<FieldCommand>::iterator begin,
+                                  std::vector<FieldCommand>::iterator end) {
+    const size_t steps = std::count_if(begin, end, [](const FieldCommand& c) {
+        return c.type == FieldCommand::STEP;
+    });
+
+    if (steps == 0 || steps < config_.coalesce_threshold) {
+        for (auto it = begin; it != end; ++it) {
+            switch (it->type) {
+                case FieldCommand::INPUT:
+                    nfs_.setInputText(it->values);
+                    break;
+                case FieldCommand::EXTERNAL_INPUT:
+                    nfs_.addExternalInput(it->values);
+                    break;
+                case FieldCommand::STEP:
+                    if (!it->values.empty()) nfs_.setInputText(it->values);
+                    timedStep(it->reward);
+                    break;
+                default:
+                    break;
+            }
+        }
+        return;
+    }
+
+    // Очередь отстала: входы усредняются, внешний вход — последний, один шаг
+    std::vector<float> input_sum;
+    std::vector<int> input_count;
+    const std::vector<float>* external = nullptr;
+    double reward_sum = 0.0;
+    for (auto it = begin; it != end; ++it) {
+        if (it->type == FieldCommand::EXTERNAL_INPUT) {
+            external = &it->values;
+            continue;
+        }
+        if (it->type == FieldCommand::STEP) reward_sum += it->reward;
+        const auto& v = it->values;
+        if (v.size() > input_sum.size()) {
+            input_sum.resize(v.size(), 0.0f);
+            input_count.resize(v.size(), 0);
+        }
+        for (size_t i = 0; i < v.size(); ++i) {
+            input_sum[i] += v[i];
+            input_count[i]++;
+        }
+    }
+    for (size_t i = 0; i < input_sum.size(); ++i) input_sum[i] /= input_count[i];
+
+    if (!input_sum.empty()) nfs_.setInputText(input_sum);
+    if (external) nfs_.addExternalInput(*external);
+    timedStep(static_cast<float>(reward_sum / steps));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.coalesced_steps += steps - 1;
+}
+
+void SimulationLoop::timedStep(float reward) {
+    auto t0 = std::chrono::steady_clock::now();
+    nfs_.step(reward, nfs_.getCurrentStep() + 1);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.steps++;
+    step_sum_us_ += us;
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+class NeuralFieldSystem;
+
+/**
+ * @struct FieldCommand
+ * @brief Команда полю от любого потока; выполняет её поток-владелец SimulationLoop
+ */
+struct FieldCommand {
+    enum Type {
+        INPUT,           // setInputText(values)
+        EXTERNAL_INPUT,  // addExternalInput(values)
+        STEP,            // step(reward); непустой values подаётся на вход перед шагом
+        TASK             // произвольное действие над полем (настройки аудитора и т.п.)
+    };
+
+    Type type = STEP;
+    std::vector<float> values;
+    float reward = 0.0f;
+    std::function<void(NeuralFieldSystem&)> task;
+    std::chrono::steady_clock::time_point enqueued;
+
+    static FieldCommand input(std::vector<float> v) {
+        FieldCommand c; c.type = INPUT; c.values = std::move(v); return c;
+    }
+    static FieldCommand externalInput(std::vector<float> v) {
+        FieldCommand c; c.type = EXTERNAL_INPUT; c.values = std::move(v); return c;
+    }
+    static FieldCommand step(float reward, std::vector<float> v = {}) {
+        FieldCommand c; c.type = STEP; c.reward = reward; c.values = std::move(v); return c;
+    }
+    static FieldCommand run(std::function<void(NeuralFieldSystem&)> fn) {
+        FieldCommand c; c.type = TASK; c.task = std::move(fn); return c;
+    }
+};
+
+/**
+ * @struct SimulationStats
+ * @brief Глубина очереди, отказы, слияния шагов и задержки команд
+ */
+struct SimulationStats {
+    size_t queue_depth = 0;
+    size_t queue_capacity = 0;
+    size_t high_water = 0;          // максимальная глубина очереди
+    bool backpressure = false;      // очередь заполнена на 3/4 и больше
+    uint64_t accepted = 0;
+    uint64_t rejected = 0;          // отказ из-за полной очереди
+    uint64_t commands = 0;          // выполнено команд
+    uint64_t steps = 0;             // выполнено шагов поля
+    uint64_t coalesced_steps = 0;   // шагов, слитых с соседними
+    uint64_t batches = 0;
+    double avg_latency_us = 0.0;    // от submit до выполнения
+    double max_latency_us = 0.0;
+    double avg_step_us = 0.0;
+
+    nlohmann::json toJson() const {
+        nlohmann::json j;
+        j["queue_depth"] = queue_depth;
+        j["queue_capacity"] = queue_capacity;
+        j["high_water"] = high_water;
+        j["backpressure"] = backpressure;
+        j["accepted"] = accepted;
+        j["rejected"] = rejected;
+        j["commands"] = commands;
+        j["steps"] = steps;
+        j["coalesced_steps"] = coalesced_steps;
+        j["batches"] = batches;
+        j["avg_latency_us"] = avg_latency_us;
+        j["max_latency_us"] = max_latency_us;
+        j["avg_step_us"] = avg_step_us;
+        return j;
+    }
+};
+
+// --------------------
+// Поток-владелец нейронного поля
+// --------------------
+/**
+ * @class SimulationLoop
+ * @brief Единственный поток, который меняет NeuralFieldSystem; остальные шлют команды
+ *
+ * Логика:
+ * - ограниченная очередь с несколькими производителями и одним потребителем;
+ *   submit() не ждёт: при полной очереди — QUEUE_FULL (сигнал backpressure),
+ *   вызывающий решает, ждать (submit с таймаутом) или отбросить
+ * - поток забирает из очереди всё накопившееся пакетом; если в пакете
+ *   coalesce_threshold шагов и больше (очередь отстаёт), входы пакета
+ *   усредняются и выполняется один шаг со средней наградой
+ * - TASK выполняется на своём месте и делит пакет на независимые части
+ * - читатели состояния поля используют опубликованный снимок
+ *   (NeuralFieldSystem::getPublishedSnapshot), а не очередь
+ */
+class SimulationLoop {
+public:
+    struct Config {
+        size_t capacity = 256;
+        size_t coalesce_threshold = 4;
+    };
+
+    enum SubmitResult {
+        ACCEPTED,
+        QUEUE_FULL,
+        STOPPED
+    };
+
+    explicit SimulationLoop(NeuralFieldSystem& nfs);
+    SimulationLoop(NeuralFieldSystem& nfs, Config config);
+    ~SimulationLoop();
+
+    SimulationLoop(const SimulationLoop&) = delete;
+    SimulationLoop& operator=(const SimulationLoop&) = delete;
+
+    void start();
+    // Выполняет уже принятые команды и останавливает поток
+    void stop();
+    bool isRunning() const;
+
+    SubmitResult submit(FieldCommand cmd);
+    // Ждёт места в очереди не дольше wait
+    SubmitResult submit(FieldCommand cmd, std::chrono::milliseconds wait);
+
+    // Дождаться выполнения всех команд, принятых до вызова
+    void flush();
+
+    SimulationStats stats() const;
+    const Config& config() const { return config_; }
+
+private:
+    void run();
+    void applyBatch(std::vector<FieldCommand>& batch);
+    void applySegment(std::vector<FieldCommand>::iterator begin,
+                      std::vector<FieldCommand>::iterator end);
+    void timedStep(float reward);
+
+    NeuralFieldSystem& nfs_;
+    const Config config_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::condition_variable drained_;
+    std::deque<FieldCommand> queue_;
+    bool running_ = false;
+    bool stopping_ = false;
+    uint64_t submitted_seq_ = 0;    // номер последней принятой команды
+    uint64_t applied_seq_ = 0;      // номер последней выполненной
+
+    // Счётчики (под mutex_; поток-владелец копит пакет локально)
+    SimulationStats stats_;
+    double latency_sum_us_ = 0.0;
+    double step_sum_us_ = 0.0;
+
+    std::thread thread_;
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// --------------------
+// История спайков (битовое кольцо 128 бит на нейрон)
+// --------------------
+/**
+ * @class SpikeHistory
+ * @brief Скользящее окно спайков для группы нейронов
+ *
+ * Логика:
+ * - на нейрон два слова uint64 (кольцо на 128 позиций) + голова и длина
+ * - окно window <= 128 последних записей, старые биты вне окна игнорируются
+ * - счётчик спайков в окне поддерживается при каждом push, поэтому
+ *   частота спайков — O(1), а пакетный rates() — один линейный проход
+ */
+class SpikeHistory {
+public:
+    static constexpr int CAPACITY = 128;
+
+    SpikeHistory() = default;
+    SpikeHistory(int neurons, int window) { resize(neurons, window); }
+
+    void resize(int neurons, int window) {
+        neurons_ = neurons;
+        window_ = std::clamp(window, 1, CAPACITY);
+        bits_.assign(static_cast<size_t>(neurons) * 2, 0);
+        head_.assign(neurons, 0);
+        length_.assign(neurons, 0);
+        counts_.assign(neurons, 0);
+        total_count_ = 0;
+    }
+
+    // Добавить запись в историю нейрона i (вытесняет самую старую из окна)
+    void push(int i, bool spike) {
+        uint64_t* words = &bits_[static_cast<size_t>(i) * 2];
+        int head = head_[i];
+
+        if (length_[i] == window_) {
+            int tail = (head - window_) & (CAPACITY - 1);
+            int out = static_cast<int>((words[tail >> 6] >> (tail & 63)) & 1u);
+            counts_[i] -= out;
+            total_count_ -= out;
+        } else {
+            length_[i]++;
+        }
+
+        uint64_t mask = uint64_t(1) << (head & 63);
+        words[head >> 6] = spike ? (words[head >> 6] | mask) : (words[head >> 6] & ~mask);
+        counts_[i] += spike;
+        total_count_ += spike;
+        head_[i] = static_cast<uint8_t>((head + 1) & (CAPACITY - 1));
+    }
+
+    int count(int i) const { return counts_[i]; }
+    int length(int i) const { return length_[i]; }
+    int window() const { return window_; }
+    int totalCount() const { return total_count_; }
+
+    // Доля спайков в окне (делитель — полное окно, как и раньше)
+    double rate(int i) const { return static_cast<double>(counts_[i]) / window_; }
+
+    // Частоты всех нейронов за один проход (out — не меньше size() элементов)
+    void rates(float* out) const {
+        const float inv = 1.0f / static_cast<float>(window_);
+        const int32_t* counts = counts_.data();
+        for (int i = 0; i < neurons_; ++i) {
+            out[i] = static_cast<float>(counts[i]) * inv;
+        }
+    }
+
+    int size() const { return neurons_; }
+
+private:
+    int neurons_ = 0;
+    int window_ = 1;
+    std::vector<uint64_t> bits_;     // 2 слова на нейрон
+    std::vector<uint8_t> head_;      // следующая позиция записи [0,128)
+    std::vector<uint8_t> length_;    // заполненность окна [0,window]
+    std::vector<int32_t> counts_;    // спайков в окне
+    int total_count_ = 0;            // сумма counts_ по группе
+};
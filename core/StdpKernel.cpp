@@ -0,0 +1,314 @@
+#include "StdpKernel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// ============================================================================
+// LUT И ВЫБОР ISA
+// ============================================================================
+
+StdpKernel::Lut StdpKernel::buildLut(float A_plus, float A_minus) {
+    Lut lut{};  // lut[0] и lut[LUT_SIZE-1] — вне окна, нули
+    for (int dt = 1; dt <= WINDOW; ++dt) {
+        float e = std::exp(-static_cast<float>(dt) / 20.0f);
+        lut[WINDOW + 1 + dt] = A_plus * e;
+        lut[WINDOW + 1 - dt] = -A_minus * e;
+    }
+    return lut;
+}
+
+StdpKernel::Type StdpKernel::best() {
+    static const Type t = selfCheck(SimdLevel::AVX512) ? SimdLevel::AVX512
+                        : selfCheck(SimdLevel::AVX2)   ? SimdLevel::AVX2
+                        : SimdLevel::SCALAR;
+    return t;
+}
+
+bool StdpKernel::selfCheck(Type t, int n, uint32_t seed) {
+    if (!SimdLevel::supported(t)) return false;
+
+    const Lut lut = buildLut(0.5f, 0.6f);
+    Params p{lut.data(), 0.5f * 0.7f, 0.95f, 1.0f};
+
+    // Детерминированные входы: спайки в окне и вне его, часть нейронов в критическом периоде
+    uint32_t x = seed ? seed : 1;
+    auto next = [&x]() {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        return (x >> 8) * (1.0f / 16777216.0f);
+    };
+    const int32_t now = 1000;
+    std::vector<int32_t> T(n);
+    std::vector<float> g(n), w(n), e(n);
+    for (int j = 0; j < n; ++j) {
+        float r = next();
+        T[j] = r < 0.2f ? -1000000 : now - static_cast<int32_t>(next() * 30.0f);
+        g[j] = next() < 0.3f ? 3.0f : 1.0f;
+        w[j] = -1.2f + 2.4f * next();
+        e[j] = -0.12f + 0.24f * next();
+    }
+
+    std::vector<float> w_ref = w, e_ref = e;
+    for (int k = 0; k < 3; ++k) {
+        row(t, p, n, w.data(), e.data(), T.data(), g.data(), now - 7 * k, g[k]);
+        rowScalar(p, 0, n, w_ref.data(), e_ref.data(), T.data(), g.data(), now - 7 * k, g[k]);
+    }
+    return std::memcmp(w.data(), w_ref.data(), n * sizeof(float)) == 0 &&
+           std::memcmp(e.data(), e_ref.data(), n * sizeof(float)) == 0;
+}
+
+bool StdpKernel::legacyCheck(Type t, int n, uint32_t seed) {
+    if (!SimdLevel::supported(t) || n < 8) return false;
+
+    // Параметры PlasticityParams по умолчанию
+    const float A_plus = 0.5f, A_minus = 0.6f, stdpRate = 0.5f;
+    const float eligibilityDecay = 0.95f, maxWeight = 1.0f;
+    const Lut lut = buildLut(A_plus, A_minus);
+
+    uint32_t x = seed ? seed : 1;
+    auto next = [&x]() {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        return (x >> 8) * (1.0f / 16777216.0f);
+    };
+
+    // Прежнее хранилище: времена спайков в каждом синапсе
+    struct LegacySynapse {
+        float weight;
+        float lastPreFire = -1e6f;
+        float lastPostFire = -1e6f;
+        float eligibility;
+    };
+    const size_t count = static_cast<size_t>(n) * (n - 1) / 2;
+    std::vector<LegacySynapse> legacy(count);
+    std::vector<float> w(count), e(count);
+    for (size_t k = 0; k < count; ++k) {
+        w[k] = legacy[k].weight = -1.2f + 2.4f * next();
+        e[k] = legacy[k].eligibility = -0.12f + 0.24f * next();
+    }
+    std::vector<int> critical(n);
+    std::vector<float> boost(n), g(n);
+    for (int i = 0; i < n; ++i) {
+        critical[i] = next() < 0.3f;
+        boost[i] = 3.0f;
+        g[i] = critical[i] ? boost[i] : 1.0f;
+    }
+
+    // Нейрон 0 спайкает на шаге 100, нейроны 1-3 — через 20, 21, 22 шага,
+    // нейроны 4-6 — за 20, 21, 22 шага до него; остальные — случайно
+    const int steps = 160;
+    auto spikes = [&](int i, int step) {
+        switch (i) {
+            case 0: return step == 100;
+            case 1: return step == 120;
+            case 2: return step == 121;
+            case 3: return step == 122;
+            case 4: return step == 80;
+            case 5: return step == 79;
+            case 6: return step == 78;
+            default: return false;
+        }
+    };
+    std::vector<int32_t> T(n, -1000000);
+    std::vector<char> spike(n);
+
+    std::array<float, 21> exp_table{};
+    for (int dt = 0; dt <= 20; ++dt) exp_table[dt] = std::exp(-static_cast<float>(dt) / 20.0f);
+
+    for (int step = 1; step <= steps; ++step) {
+        const float reward = next() * 1.5f;
+        for (int i = 0; i < n; ++i) {
+            spike[i] = i < 7 ? spikes(i, step) : next() < 0.05f;
+            if (spike[i]) T[i] = step;
+        }
+
+        Params p{lut.data(), stdpRate * std::min(1.0f, reward), eligibilityDecay, maxWeight};
+        triangle(t, p, n, w.data(), e.data(), T.data(), g.data());
+
+        // Прежний learnSTDP (до упакованного ядра), без записи в W_
+        int synIndex = 0;
+        for (int i = 0; i < n; ++i) {
+            for (int j = i + 1; j < n; ++j) {
+                auto& syn = legacy[synIndex++];
+
+                if (spike[i]) syn.lastPreFire = static_cast<float>(step);
+                if (spike[j]) syn.lastPostFire = static_cast<float>(step);
+
+                float dt = syn.lastPostFire - syn.lastPreFire;
+                float delta = 0.0f;
+
+                int dt_int = static_cast<int>(std::abs(dt));
+                if (dt > 0 && dt_int <= 20) {
+                    delta = A_plus * exp_table[dt_int];
+                } else if (dt < 0 && dt_int <= 20) {
+                    delta = -A_minus * exp_table[dt_int];
+                }
+
+                float reward_factor = std::min(1.0f, reward);
+                float boost_ij = 1.0f;
+                if (critical[i]) boost_ij *= boost[i];
+                if (critical[j]) boost_ij *= boost[j];
+
+                float weight_change = stdpRate * reward_factor * delta * boost_ij;
+
+                syn.eligibility = syn.eligibility * eligibilityDecay + delta;
+                syn.eligibility = std::clamp(syn.eligibility, -0.1f, 0.1f);
+
+                syn.weight += weight_change;
+                syn.weight = std::clamp(syn.weight, -maxWeight, maxWeight);
+            }
+        }
+
+        for (size_t k = 0; k < count; ++k) {
+            if (std::memcmp(&w[k], &legacy[k].weight, sizeof(float)) != 0 ||
+                std::memcmp(&e[k], &legacy[k].eligibility, sizeof(float)) != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void StdpKernel::triangle(Type t, const Params& p, int n,
+                          float* weight, float* eligibility,
+                          const int32_t* T, const float* g) {
+    // ISA проверяется один раз на вызов, а не на строку
+    if (t == SimdLevel::AVX512 && !SimdLevel::supported(SimdLevel::AVX512)) t = SimdLevel::AVX2;
+    if (t == SimdLevel::AVX2 && !SimdLevel::supported(SimdLevel::AVX2)) t = SimdLevel::SCALAR;
+
+    for (int i = 0; i < n - 1; ++i) {
+        const int len = n - i - 1;
+        int done = 0;
+        if (t == SimdLevel::AVX512) {
+            done = rowAvx512(p, len, weight, eligibility, T + i + 1, g + i + 1, T[i], g[i]);
+        } else if (t == SimdLevel::AVX2) {
+            done = rowAvx2(p, len, weight, eligibility, T + i + 1, g + i + 1, T[i], g[i]);
+        }
+        rowScalar(p, done, len, weight, eligibility, T + i + 1, g + i + 1, T[i], g[i]);
+        weight += len;
+        eligibility += len;
+    }
+}
+
+void StdpKernel::row(Type t, const Params& p, int len,
+                     float* weight, float* eligibility,
+                     const int32_t* T_post, const float* g_post,
+                     int32_t T_pre, float g_pre) {
+    int done = 0;
+    if (t == SimdLevel::AVX512 && SimdLevel::supported(SimdLevel::AVX512)) {
+        done = rowAvx512(p, len, weight, eligibility, T_post, g_post, T_pre, g_pre);
+    } else if (t != SimdLevel::SCALAR && SimdLevel::supported(SimdLevel::AVX2)) {
+        done = rowAvx2(p, len, weight, eligibility, T_post, g_post, T_pre, g_pre);
+    }
+    // Хвост (и вся строка без SIMD)
+    rowScalar(p, done, len, weight, eligibility, T_post, g_post, T_pre, g_pre);
+}
+
+// ============================================================================
+// СКАЛЯРНЫЙ ПУТЬ (эталон)
+// ============================================================================
+
+void StdpKernel::rowScalar(const Params& p, int begin, int len,
+                           float* weight, float* eligibility,
+                           const int32_t* T_post, const float* g_post,
+                           int32_t T_pre, float g_pre) {
+    for (int j = begin; j < len; ++j) {
+        int32_t dt = std::clamp(T_post[j] - T_pre, -(WINDOW + 1), WINDOW + 1);
+        float delta = p.lut[dt + WINDOW + 1];
+        float boost = g_pre * g_post[j];
+        float weight_change = p.scale * delta * boost;
+
+        eligibility[j] = std::clamp(eligibility[j] * p.decay + delta, -0.1f, 0.1f);
+        weight[j] = std::clamp(weight[j] + weight_change, -p.max_weight, p.max_weight);
+    }
+}
+
+#ifdef SIMD_LEVEL_X86
+
+// ============================================================================
+// AVX2: 8 синапсов за итерацию
+// ============================================================================
+
+__attribute__((target("avx2")))
+int StdpKernel::rowAvx2(const Params& p, int len,
+                        float* weight, float* eligibility,
+                        const int32_t* T_post, const float* g_post,
+                        int32_t T_pre, float g_pre) {
+    const __m256i t_pre  = _mm256_set1_epi32(T_pre);
+    const __m256i lo     = _mm256_set1_epi32(-(WINDOW + 1));
+    const __m256i hi     = _mm256_set1_epi32(WINDOW + 1);
+    const __m256 gp      = _mm256_set1_ps(g_pre);
+    const __m256 scale   = _mm256_set1_ps(p.scale);
+    const __m256 decay   = _mm256_set1_ps(p.decay);
+    const __m256 e_lo    = _mm256_set1_ps(-0.1f);
+    const __m256 e_hi    = _mm256_set1_ps(0.1f);
+    const __m256 w_lo    = _mm256_set1_ps(-p.max_weight);
+    const __m256 w_hi    = _mm256_set1_ps(p.max_weight);
+
+    int j = 0;
+    for (; j + 8 <= len; j += 8) {
+        __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(T_post + j));
+        __m256i dt = _mm256_min_epi32(_mm256_max_epi32(_mm256_sub_epi32(t, t_pre), lo), hi);
+        __m256 delta = _mm256_i32gather_ps(p.lut, _mm256_add_epi32(dt, hi), 4);
+
+        __m256 boost = _mm256_mul_ps(gp, _mm256_loadu_ps(g_post + j));
+        __m256 change = _mm256_mul_ps(_mm256_mul_ps(scale, delta), boost);
+
+        __m256 e = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(eligibility + j), decay), delta);
+        __m256 w = _mm256_add_ps(_mm256_loadu_ps(weight + j), change);
+        _mm256_storeu_ps(eligibility + j, _mm256_min_ps(_mm256_max_ps(e, e_lo), e_hi));
+        _mm256_storeu_ps(weight + j, _mm256_min_ps(_mm256_max_ps(w, w_lo), w_hi));
+    }
+    return j;
+}
+
+// ============================================================================
+// AVX-512: 16 синапсов за итерацию
+// ============================================================================
+// avx512f включает FMA, поэтому арифметика через *_round_ps — они не сливаются.
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f")))
+int StdpKernel::rowAvx512(const Params& p, int len,
+                          float* weight, float* eligibility,
+                          const int32_t* T_post, const float* g_post,
+                          int32_t T_pre, float g_pre) {
+    constexpr int RND = _MM_FROUND_CUR_DIRECTION;
+    const __m512i t_pre  = _mm512_set1_epi32(T_pre);
+    const __m512i lo     = _mm512_set1_epi32(-(WINDOW + 1));
+    const __m512i hi     = _mm512_set1_epi32(WINDOW + 1);
+    const __m512 gp      = _mm512_set1_ps(g_pre);
+    const __m512 scale   = _mm512_set1_ps(p.scale);
+    const __m512 decay   = _mm512_set1_ps(p.decay);
+    const __m512 e_lo    = _mm512_set1_ps(-0.1f);
+    const __m512 e_hi    = _mm512_set1_ps(0.1f);
+    const __m512 w_lo    = _mm512_set1_ps(-p.max_weight);
+    const __m512 w_hi    = _mm512_set1_ps(p.max_weight);
+
+    // Хвост строки — той же итерацией под маской, без скалярного добора
+    for (int j = 0; j < len; j += 16) {
+        const int rem = len - j;
+        const __mmask16 m = rem >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << rem) - 1);
+
+        __m512i t = _mm512_maskz_loadu_epi32(m, T_post + j);
+        __m512i dt = _mm512_min_epi32(_mm512_max_epi32(_mm512_sub_epi32(t, t_pre), lo), hi);
+        __m512 delta = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), m, _mm512_add_epi32(dt, hi), p.lut, 4);
+
+        __m512 boost = _mm512_mul_round_ps(gp, _mm512_maskz_loadu_ps(m, g_post + j), RND);
+        __m512 change = _mm512_mul_round_ps(_mm512_mul_round_ps(scale, delta, RND), boost, RND);
+
+        __m512 e = _mm512_add_round_ps(_mm512_mul_round_ps(_mm512_maskz_loadu_ps(m, eligibility + j), decay, RND), delta, RND);
+        __m512 w = _mm512_add_round_ps(_mm512_maskz_loadu_ps(m, weight + j), change, RND);
+        _mm512_mask_storeu_ps(eligibility + j, m, _mm512_min_ps(_mm512_max_ps(e, e_lo), e_hi));
+        _mm512_mask_storeu_ps(weight + j, m, _mm512_min_ps(_mm512_max_ps(w, w_lo), w_hi));
+    }
+    return len;
+}
+#pragma GCC diagnostic pop
+
+#else
+
+int StdpKernel::rowAvx2(const Params&, int, float*, float*, const int32_t*, const float*, int32_t, float) { return 0; }
+int StdpKernel::rowAvx512(const Params&, int, float*, float*, const int32_t*, const float*, int32_t, float) { return 0; }
+
+#endif
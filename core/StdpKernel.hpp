@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include "SimdLevel.hpp"
+
+// --------------------
+// Векторное ядро reward-modulated STDP (одна строка упакованного треугольника)
+// --------------------
+/**
+ * @struct StdpKernel
+ * @brief Обновление eligibility и весов синапсов (i, j>i) строки i без ветвлений
+ *
+ * Логика:
+ * - времена последних спайков хранятся по нейронам, а не по синапсам:
+ *   dt = T_post[j] - T_pre, окно [-20, 20] шагов
+ * - delta берётся из LUT на 43 позиции (индекс clamp(dt, -21, 21) + 21,
+ *   крайние ячейки нулевые) — векторный gather вместо двух веток
+ * - boost = g_pre * g_post[j], где g — множитель критического периода (или 1)
+ * - eligibility = clamp(e * decay + delta, ±0.1), weight = clamp(w + scale*delta*boost, ±maxWeight)
+ * - векторные пути повторяют порядок операций скалярного и не используют FMA,
+ *   поэтому совпадают с ним бит в бит
+ */
+struct StdpKernel {
+    using Type = SimdLevel::Type;
+
+    static constexpr int WINDOW = 20;
+    static constexpr int LUT_SIZE = 2 * (WINDOW + 1) + 1;
+    using Lut = std::array<float, LUT_SIZE>;
+
+    struct Params {
+        const float* lut;    // LUT_SIZE значений delta по dt + WINDOW + 1
+        float scale;         // stdpRate * reward_factor
+        float decay;         // eligibilityDecay
+        float max_weight;
+    };
+
+    // Таблица delta(dt): A_plus·e^{-dt/20} при dt>0, -A_minus·e^{dt/20} при dt<0
+    static Lut buildLut(float A_plus, float A_minus);
+
+    // Лучшая ISA, прошедшая selfCheck (один раз за процесс)
+    static Type best();
+    static bool selfCheck(Type t, int n = 77, uint32_t seed = 1);
+    // triangle() против прежнего правила по синапсам (ветки, времена спайков в
+    // синапсе) на одной истории спайков, включая |dt| = 20, 21, 22: true, если
+    // веса и eligibility совпадают бит в бит после каждого вызова
+    static bool legacyCheck(Type t, int n = 48, uint32_t seed = 1);
+
+    // Весь упакованный треугольник группы из n нейронов (строки i = 0..n-2)
+    static void triangle(Type t, const Params& p, int n,
+                         float* weight, float* eligibility,
+                         const int32_t* T, const float* g);
+
+    // Строка i: len синапсов (i, i+1..), T_post/g_post — начиная с нейрона i+1
+    static void row(Type t, const Params& p, int len,
+                    float* weight, float* eligibility,
+                    const int32_t* T_post, const float* g_post,
+                    int32_t T_pre, float g_pre);
+
+private:
+    static void rowScalar(const Params& p, int begin, int len,
+                          float* weight, float* eligibility,
+                          const int32_t* T_post, const float* g_post,
+                          int32_t T_pre, float g_pre);
+    static int rowAvx2(const Params& p, int len,
+                       float* weight, float* eligibility,
+                       const int32_t* T_post, const float* g_post,
+                       int32_t T_pre, float g_pre);
+    static int rowAvx512(const Params& p, int len,
+                         float* weight, float* eligibility,
+                         const int32_t* T_post, const float* g_post,
+                         int32_t T_pre, float g_pre);
+};
@@ -1,6 +1,9 @@
 #pragma once
 #include <cmath>
 #include <algorithm>
+#include <vector>
+#include <cstddef>
+#include "AlignedAllocator.hpp"
 
 // --------------------
 // Синапс (STDP + eligibility trace)
@@ -37,6 +40,61 @@ struct Synapse
     {}
 };
 
+// --------------------
+// Хранилище синапсов группы (SoA, упакованный верхний треугольник)
+// --------------------
+/**
+ * @struct SynapseStore
+ * @brief Единственное хранилище весов группы: пары i<j, построчно
+ *
+ * Синапс (i, j), i<j, имеет индекс index(i, j). Отрезок строки i
+ * (все j>i) лежит непрерывно, начиная с rowStart(i).
+ * Каждое поле — отдельный выровненный массив (удобно для SIMD).
+ */
+struct SynapseStore {
+    using FloatArray = std::vector<float, AlignedAllocator<float>>;
+
+    FloatArray weight;        // вес синапса
+    FloatArray eligibility;   // eligibility trace
+    // времена спайков для STDP хранятся по нейронам (NeuralGroup), а не по синапсам
+
+    int neurons = 0;
+
+    void resize(int n) {
+        neurons = n;
+        std::size_t count = static_cast<std::size_t>(n) * (n - 1) / 2;
+        weight.assign(count, 0.1f);
+        eligibility.assign(count, 0.0f);
+    }
+
+    std::size_t size() const { return weight.size(); }
+
+    // Начало отрезка строки i (синапс (i, i+1))
+    static int rowStart(int i, int n) { return i * n - (i * (i + 1)) / 2; }
+    // Индекс синапса (i, j), требуется i < j
+    static int index(int i, int j, int n) { return rowStart(i, n) + (j - i - 1); }
+};
+
+/**
+ * @struct WeightMatrixView
+ * @brief Симметричное представление весов поверх SynapseStore (только чтение)
+ *
+ * (i, j) и (j, i) — один и тот же синапс, диагональ равна нулю.
+ * segment(i)[k] == W(i, i + 1 + k) — непрерывный отрезок длины n - i - 1.
+ */
+struct WeightMatrixView {
+    const float* data = nullptr;
+    int n = 0;
+
+    double operator()(int i, int j) const {
+        if (i == j) return 0.0;
+        if (i > j) std::swap(i, j);
+        return data[SynapseStore::index(i, j, n)];
+    }
+    const float* segment(int i) const { return data + SynapseStore::rowStart(i, n); }
+    int size() const { return n; }
+};
+
 // --------------------
 // Параметры пластичности
 // --------------------
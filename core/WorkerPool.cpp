@@ -0,0 +1,79 @@
+#include "WorkerPool.hpp"
+#include <algorithm>
+
+WorkerPool::WorkerPool(int threads) {
+    if (threads <= 0) threads = hardwareThreads();
+    workers_.reserve(threads - 1);
+    for (int t = 1; t < threads; ++t) {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& w : workers_) {
+        if (w.joinable()) w.join();
+    }
+}
+
+int WorkerPool::hardwareThreads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void WorkerPool::parallelFor(int n, const std::function<void(int)>& fn) {
+    if (n <= 0) return;
+    if (workers_.empty() || n == 1) {
+        for (int i = 0; i < n; ++i) fn(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &fn;
+        task_count_ = n;
+        next_index_.store(0, std::memory_order_relaxed);
+        active_workers_ = static_cast<int>(workers_.size());
+        ++generation_;
+    }
+    start_cv_.notify_all();
+
+    // Вызывающий поток работает наравне с рабочими
+    runTasks();
+
+    // Барьер: ждём, пока все рабочие выйдут из фазы
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this]() { return active_workers_ == 0; });
+    task_ = nullptr;
+}
+
+void WorkerPool::runTasks() {
+    const auto& fn = *task_;
+    for (;;) {
+        int i = next_index_.fetch_add(1, std::memory_order_relaxed);
+        if (i >= task_count_) break;
+        fn(i);
+    }
+}
+
+void WorkerPool::workerLoop() {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cv_.wait(lock, [&]() { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+        }
+
+        runTasks();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--active_workers_ == 0) done_cv_.notify_one();
+        }
+    }
+}
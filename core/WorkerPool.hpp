@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --------------------
+// Постоянный пул потоков для пофазного параллелизма по группам
+// --------------------
+/**
+ * @class WorkerPool
+ * @brief Потоки создаются один раз; каждая фаза — parallelFor с барьером в конце
+ *
+ * Логика:
+ * - threads() включает вызывающий поток: пул на N потоков держит N-1 рабочих,
+ *   вызывающий поток тоже разбирает индексы
+ * - индексы раздаются атомарным счётчиком; fn(i) для разных i не должны
+ *   пересекаться по данным — тогда результат не зависит от числа потоков
+ *   и порядка выполнения
+ * - parallelFor возвращается, когда выполнены все fn(i) (барьер между фазами)
+ * - при threads() == 1 или n == 1 всё выполняется в вызывающем потоке
+ * - вложенный parallelFor и вызовы из нескольких потоков не поддерживаются
+ */
+class WorkerPool {
+public:
+    // threads <= 0 — по числу аппаратных потоков
+    explicit WorkerPool(int threads = 1);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int threads() const { return static_cast<int>(workers_.size()) + 1; }
+
+    void parallelFor(int n, const std::function<void(int)>& fn);
+
+    static int hardwareThreads();
+
+private:
+    void workerLoop();
+    void runTasks();
+
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    uint64_t generation_ = 0;     // номер текущей фазы
+    int active_workers_ = 0;      // рабочих, ещё не закончивших фазу
+    bool stop_ = false;
+
+    const std::function<void(int)>* task_ = nullptr;
+    int task_count_ = 0;
+    std::atomic<int> next_index_{0};
+};
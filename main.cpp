@@ -1,7 +1,11 @@
 // main.cpp - ИСПРАВЛЕННАЯ ВЕРСИЯ
 #include "core/NeuralFieldSystem.hpp"
 #include "core/AgentAuditBridge.hpp"
+#include "core/SimulationLoop.hpp"
+#include "core/MemorySnapshot.hpp"
 #include "server/HttpServer.hpp"
+#include "server/HttpRequestParser.hpp"
+#include "server/HttpLoadGenerator.hpp"
 #include "server/ApiHandlers.hpp"
 #include "server/AgentRegistry.hpp"
 #include "application/AgentConfig.hpp"
@@ -10,6 +14,15 @@
 #include <filesystem>
 #include <atomic>
 #include <thread>
+#include <chrono>
+#include <iomanip>
+#include <cctype>
+#include <memory>
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <random>
+#include <unistd.h>
 
 NeuralFieldSystem* g_nfs = nullptr;
 AgentAuditBridge* g_auditor = nullptr;
@@ -46,6 +59,542 @@ void printBanner() {
     )" << std::endl;
 }
 
+// Стоимость шага поля в зависимости от топологии и числа потоков: --bench [steps].
+// После прогона инкрементальные гистограммы энтропии сверяются с полным пересчётом.
+int runFieldBenchmark(int steps, int threads) {
+    const std::pair<int, int> topologies[] = {
+        {16, 16}, {32, 32}, {16, 128}, {64, 32}, {128, 16}, {256, 16}, {48, 48}, {64, 64}
+    };
+    if (threads <= 0) threads = WorkerPool::hardwareThreads();
+    std::vector<int> thread_counts = {1};
+    if (threads > 1) thread_counts.push_back(threads);
+    
+    std::cout << "[Bench] " << steps << " steps per topology, LIF="
+              << SimdLevel::toString(LifKernel::best())
+              << ", STDP=" << SimdLevel::toString(StdpKernel::best()) << std::endl;
+    std::cout << std::setw(8) << "groups" << std::setw(8) << "size"
+              << std::setw(10) << "neurons" << std::setw(9) << "threads"
+              << std::setw(12) << "us/step" << std::setw(12) << "ns/neuron"
+              << "  entropy  phases us/step" << std::endl;
+    
+    int diverged = 0;
+    for (const auto& [num_groups, group_size] : topologies) {
+        for (int t : thread_counts) {
+            NeuralFieldSystem nfs(0.01, num_groups, group_size);
+            nfs.initialize(uint64_t{42});
+            nfs.setWorkerThreads(t);
+            
+            std::vector<float> input(group_size);
+            auto feed = [&](int s) {
+                for (int i = 0; i < group_size; ++i) input[i] = ((s * 7 + i * 13) % 17) / 17.0f;
+                nfs.setInputText(input);
+                nfs.step((s % 3) ? 0.8f : 0.2f, s);
+            };
+            
+            const int warmup = std::max(1, steps / 10);
+            for (int s = 1; s <= warmup; ++s) feed(s);
+            nfs.resetPhaseStats();
+            
+            auto t0 = std::chrono::steady_clock::now();
+            for (int s = warmup + 1; s <= warmup + steps; ++s) feed(s);
+            auto t1 = std::chrono::steady_clock::now();
+            
+            double us = std::chrono::duration<double, std::micro>(t1 - t0).count() / steps;
+            std::cout << std::setw(8) << num_groups << std::setw(8) << group_size
+                      << std::setw(10) << nfs.totalNeurons()
+                      << std::setw(9) << nfs.getWorkerThreads()
+                      << std::setw(12) << std::fixed << std::setprecision(1) << us
+                      << std::setw(12) << us * 1000.0 / nfs.totalNeurons() << " ";
+            const bool consistent = nfs.checkEntropyConsistency();
+            if (!consistent) ++diverged;
+            std::cout << (consistent ? "  ok     " : "  DIVERGED");
+            const auto& ps = nfs.getPhaseStats();
+            for (int p = 0; p < StepPhaseStats::COUNT; ++p) {
+                auto phase = static_cast<StepPhaseStats::Phase>(p);
+                std::cout << " " << StepPhaseStats::toString(phase) << "=" << ps.averageUs(phase);
+            }
+            std::cout << std::endl;
+        }
+    }
+    
+    // Пути синаптического тока: SPARSE, DENSE и AUTO на группе из 64 нейронов,
+    // доля спайкующих ниже, на и выше порога AUTO (0.25)
+    std::cout << std::setw(14) << "syn input" << std::setw(8) << "active" << std::setw(10) << "fraction"
+              << std::setw(12) << "auto sparse" << std::setw(12) << "auto dense"
+              << std::setw(10) << "events" << "  I_syn/V" << std::endl;
+    for (int active : {4, 16, 17, 40}) {
+        SynapticInputStats stats;
+        const bool same = NeuralGroup::checkSynapticInputModes(64, active, 42, &stats);
+        if (!same) ++diverged;
+        std::cout << std::setw(14) << "" << std::setw(8) << active
+                  << std::setw(10) << std::setprecision(3) << active / 64.0
+                  << std::setw(12) << stats.sparse_steps << std::setw(12) << stats.dense_steps
+                  << std::setw(10) << stats.events << (same ? "  identical" : "  DIVERGED") << std::endl;
+    }
+    
+    // Векторный шаг LIF против скалярного, для каждой ISA: best() при расхождении
+    // молча откатывается на другой путь, здесь расхождение валит бенчмарк
+    std::cout << std::setw(14) << "lif kernel" << std::setw(8) << "isa" << "  V/threshold/refractory/state" << std::endl;
+    for (SimdLevel::Type t : {SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (!SimdLevel::supported(t)) continue;
+        const bool same = LifKernel::selfCheck(t);
+        if (!same) ++diverged;
+        std::cout << std::setw(14) << "" << std::setw(8) << SimdLevel::toString(t)
+                  << (same ? "  identical" : "  DIVERGED") << std::endl;
+    }
+    
+    // Упакованное ядро STDP против прежнего правила по синапсам, для каждой ISA
+    std::cout << std::setw(14) << "stdp rule" << std::setw(8) << "isa" << "  weights/eligibility" << std::endl;
+    for (SimdLevel::Type t : {SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (!SimdLevel::supported(t)) continue;
+        const bool same = StdpKernel::legacyCheck(t);
+        if (!same) ++diverged;
+        std::cout << std::setw(14) << "" << std::setw(8) << SimdLevel::toString(t)
+                  << (same ? "  identical" : "  DIVERGED") << std::endl;
+    }
+    
+    // Активностный STDP против полного прохода: поле в IDLE с тем же входом.
+    // Сам вход поле не зажигает — в каждой группе три нейрона под внешним током
+    // получают по одному импульсу за 50 шагов (со сдвигом 0, 5 и 12 шагов)
+    // и спайкают на нём, остальные молчат
+    std::cout << std::setw(14) << "stdp gating" << std::setw(12) << "us/step" << std::setw(12) << "stdp us"
+              << std::setw(12) << "gated %" << std::setw(16) << "synapses/call"
+              << std::setw(14) << "max |dw|" << std::endl;
+    std::vector<float> dense_weights;  // веса после полного прохода — эталон для сравнения
+    for (StdpGating::Type gating : {StdpGating::OFF, StdpGating::LOW_ACTIVITY}) {
+        NeuralFieldSystem nfs(0.01, 32, 32);
+        nfs.setStdpGating(gating);
+        nfs.initialize(uint64_t{42});
+        nfs.setWorkerThreads(1);
+        nfs.setOperatingMode(OperatingMode::IDLE);
+        auto drive = [&](int s) {
+            const int phase = s % 50;
+            for (auto& g : nfs.getGroupsNonConst()) {
+                g.setExternalCurrent(3, phase == 0 ? 5000.0 : 0.0);
+                g.setExternalCurrent(14, phase == 5 ? 5000.0 : 0.0);
+                g.setExternalCurrent(25, phase == 12 ? 5000.0 : 0.0);
+            }
+        };
+        
+        std::vector<float> input(32);
+        auto feed = [&](int s) {
+            drive(s);
+            for (int i = 0; i < 32; ++i) input[i] = ((s * 7 + i * 13) % 17) / 17.0f;
+            nfs.setInputText(input);
+            nfs.step((s % 3) ? 0.8f : 0.2f, s);
+        };
+        
+        const int warmup = std::max(1, steps / 10);
+        for (int s = 1; s <= warmup; ++s) feed(s);
+        nfs.resetPhaseStats();
+        const StdpStats before = nfs.getPublishedSnapshot()->stdp;
+        
+        auto t0 = std::chrono::steady_clock::now();
+        for (int s = warmup + 1; s <= warmup + steps; ++s) feed(s);
+        const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / steps;
+        
+        const StdpStats after = nfs.getPublishedSnapshot()->stdp;
+        const uint64_t gated = after.gated_calls - before.gated_calls;
+        const uint64_t calls = gated + after.dense_calls - before.dense_calls;
+        const uint64_t synapses = after.gated_synapses - before.gated_synapses;
+        
+        std::vector<float> weights;
+        for (const auto& g : nfs.getGroups()) {
+            const WeightMatrixView w = g.getWeights();
+            weights.insert(weights.end(), w.data, w.data + static_cast<size_t>(w.n) * (w.n - 1) / 2);
+        }
+        if (gating == StdpGating::OFF) dense_weights = weights;
+        float max_dw = 0.0f;
+        for (size_t k = 0; k < weights.size() && k < dense_weights.size(); ++k) {
+            max_dw = std::max(max_dw, std::abs(weights[k] - dense_weights[k]));
+        }
+        std::cout << std::setw(14) << StdpGating::toString(gating)
+                  << std::setw(12) << std::setprecision(1) << us
+                  << std::setw(12) << nfs.getPhaseStats().averageUs(StepPhaseStats::STDP)
+                  << std::setw(12) << (calls ? 100.0 * gated / calls : 0.0)
+                  << std::setw(16) << (gated ? static_cast<double>(synapses) / gated : 0.0)
+                  << std::setw(14) << std::scientific << max_dw << std::fixed << std::endl;
+    }
+    return diverged == 0 ? 0 : 1;
+}
+
+// Нагрузка на HTTP-сервер: --http-bench [requests].
+// Сначала самопроверка разбора запросов; при несовпадении нагрузка не запускается.
+// Если на --port уже кто-то слушает (например, другая сборка), нагружается он,
+// иначе поднимается свой сервер с небольшим полем на свободном порту.
+int runHttpBenchmark(int requests, int port) {
+    std::vector<std::string> parser_failures;
+    const bool parser_ok = HttpRequestParser::selfCheck(&parser_failures);
+    std::cout << "[HttpBench] request parser: " << (parser_ok ? "ok" : "DIVERGED") << std::endl;
+    for (const auto& failure : parser_failures) {
+        std::cout << "[HttpBench]   " << failure << std::endl;
+    }
+    if (!parser_ok) return 1;
+    
+    std::unique_ptr<NeuralFieldSystem> nfs;
+    std::unique_ptr<AgentAuditBridge> auditor;
+    std::unique_ptr<HttpServer> server;
+    
+    HttpLoadOptions probe;
+    probe.connections = 1;
+    probe.requests = 1;
+    if (runHttpLoad("127.0.0.1", port, probe).ok == 0) {
+        nfs = std::make_unique<NeuralFieldSystem>(0.01, 16, 16);
+        nfs->initialize(uint64_t{42});
+        auditor = std::make_unique<AgentAuditBridge>(*nfs);
+        server = std::make_unique<HttpServer>(0, "agent_workspace", nfs.get(), auditor.get());
+        auto& config = AgentConfig::getInstance();
+        HttpServer::Config http_config;
+        http_config.workers = config.getHttpWorkers();
+        http_config.max_connections = static_cast<size_t>(std::max(1, config.getHttpMaxConnections()));
+        server->setConfig(http_config);
+        if (!server->start()) return 1;
+        port = server->port();
+    }
+    
+    std::cout << "[HttpBench] " << requests << " requests per mode, GET /api/metrics on port " << port << std::endl;
+    std::cout << std::setw(12) << "mode" << std::setw(8) << "conns"
+              << std::setw(10) << "ok" << std::setw(8) << "errors"
+              << std::setw(12) << "req/s" << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::endl;
+    
+    const HttpLoadOptions::Mode modes[] = {HttpLoadOptions::CLOSE, HttpLoadOptions::KEEP_ALIVE, HttpLoadOptions::PIPELINE};
+    for (auto mode : modes) {
+        for (int connections : {1, 16, 64}) {
+            HttpLoadOptions options;
+            options.mode = mode;
+            options.connections = connections;
+            options.requests = requests;
+            HttpLoadResult r = runHttpLoad("127.0.0.1", port, options);
+            std::cout << std::setw(12) << HttpLoadOptions::toString(mode) << std::setw(8) << connections
+                      << std::setw(10) << r.ok << std::setw(8) << r.errors
+                      << std::setw(12) << std::fixed << std::setprecision(0) << r.requests_per_sec
+                      << std::setw(12) << std::setprecision(1) << r.p50_us
+                      << std::setw(12) << r.p99_us << std::endl;
+        }
+    }
+    
+    if (server) {
+        std::cout << "[HttpBench] server: " << server->stats().toJson().dump() << std::endl;
+        server->stop();
+    }
+    return 0;
+}
+
+// Пакетный аудит против одиночных вызовов: --audit-bench [actions].
+// Обработчики API вызываются напрямую, без HTTP; тело разбирается из строки,
+// как на сервере. Каждый прогон — свежий аудитор на одном и том же поле.
+int runAuditBenchmark(int actions) {
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::temp_directory_path() / ("audit_bench_" + std::to_string(getpid()));
+    const fs::path cwd = fs::current_path();
+    fs::create_directories(dir);
+    fs::current_path(dir);  // сырые логи аудитора пишутся относительно рабочей директории
+    
+    AgentRegistryInitializer registryInit(dir.string());
+    const char* agents[] = {"bench-a", "bench-b", "bench-c", "bench-d"};
+    for (const char* id : agents) {
+        AgentRegistry::getInstance().registerAgent(id, "bench", "");
+    }
+    
+    NeuralFieldSystem nfs(0.01, 16, 16);
+    nfs.initialize(uint64_t{42});
+    
+    const char* tools[] = {"read_file", "write_file", "search", "delete_file", "http_get", "exec"};
+    nlohmann::json items = nlohmann::json::array();
+    for (int i = 0; i < actions; ++i) {
+        items.push_back({{"agent_id", agents[i % 4]}, {"action", "call_tool"},
+                         {"tool_name", tools[i % 6]}, {"thought", "step " + std::to_string(i)},
+                         {"step", i}});
+    }
+    
+    // Эталон: по одному запросу на действие; задержка вызова — с записью
+    // agents.json на каждое действие и с отложенной записью
+    std::vector<std::string> bodies;
+    for (const auto& item : items) bodies.push_back(item.dump());
+    std::vector<std::string> single;
+    double single_rate = 0.0;
+    
+    std::cout << "[AuditBench] " << actions << " actions, field 16x16" << std::endl;
+    std::cout << std::setw(14) << "registry" << std::setw(14) << "actions/s"
+              << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(10) << "flushes" << std::endl;
+    auto& registry = AgentRegistry::getInstance();
+    const AgentRegistry::Config registry_default = registry.config();
+    for (bool write_behind : {false, true}) {
+        AgentRegistry::Config registry_config = registry_default;
+        registry_config.write_behind = write_behind;
+        registry.setConfig(registry_config);
+        registry.flush();
+        const uint64_t flushes_before = registry.stats().flushes;
+        
+        single.clear();
+        single.reserve(bodies.size());
+        std::vector<double> latency_us;
+        latency_us.reserve(bodies.size());
+        AgentAuditBridge auditor(nfs);
+        ApiHandlers api(&nfs, &auditor, dir.string());
+        auto t0 = std::chrono::steady_clock::now();
+        for (const auto& body : bodies) {
+            auto c0 = std::chrono::steady_clock::now();
+            single.push_back(api.handleAuditAction(nlohmann::json::parse(body)));
+            latency_us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - c0).count());
+        }
+        const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        single_rate = actions / sec;
+        
+        std::sort(latency_us.begin(), latency_us.end());
+        std::cout << std::setw(14) << (write_behind ? "write-behind" : "sync")
+                  << std::setw(14) << std::fixed << std::setprecision(0) << single_rate
+                  << std::setw(12) << std::setprecision(1) << latency_us[latency_us.size() / 2]
+                  << std::setw(12) << latency_us[latency_us.size() * 99 / 100]
+                  << std::setw(10) << registry.stats().flushes - flushes_before << std::endl;
+    }
+    registry.setConfig(registry_default);
+    
+    std::cout << std::setw(10) << "batch" << std::setw(12) << "requests"
+              << std::setw(14) << "actions/s" << std::setw(10) << "speedup" << std::setw(8) << "match" << std::endl;
+    std::cout << std::setw(10) << 1 << std::setw(12) << actions
+              << std::setw(14) << std::fixed << std::setprecision(0) << single_rate
+              << std::setw(10) << std::setprecision(2) << 1.0 << std::setw(8) << "-" << std::endl;
+    
+    int mismatches = 0;
+    for (int batch : {16, 128, actions}) {
+        if (batch > actions) continue;
+        std::vector<std::string> batch_bodies;
+        for (int i = 0; i < actions; i += batch) {
+            nlohmann::json chunk = nlohmann::json::array();
+            for (int j = i; j < std::min(actions, i + batch); ++j) chunk.push_back(items[j]);
+            batch_bodies.push_back(chunk.dump());
+        }
+        
+        std::vector<std::string> responses;
+        double sec;
+        {
+            AgentAuditBridge auditor(nfs);
+            ApiHandlers api(&nfs, &auditor, dir.string());
+            auto t0 = std::chrono::steady_clock::now();
+            for (const auto& body : batch_bodies) {
+                responses.push_back(api.handleAuditActions(nlohmann::json::parse(body)));
+            }
+            sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        }
+        
+        // Вердикты пакета должны совпасть с одиночными вызовами
+        size_t k = 0;
+        bool match = true;
+        for (const auto& response : responses) {
+            for (const auto& verdict : nlohmann::json::parse(response)) {
+                if (k >= single.size() || nlohmann::json::parse(single[k++]) != verdict) match = false;
+            }
+        }
+        if (k != single.size()) match = false;
+        if (!match) ++mismatches;
+        
+        const double rate = actions / sec;
+        std::cout << std::setw(10) << batch << std::setw(12) << batch_bodies.size()
+                  << std::setw(14) << std::setprecision(0) << rate
+                  << std::setw(10) << std::setprecision(2) << rate / single_rate
+                  << std::setw(8) << (match ? "yes" : "NO") << std::endl;
+    }
+    
+    // Журнал сырых действий: цена logRaw на пути аудита и групповая запись при разных fsync
+    std::cout << std::setw(10) << "fsync" << std::setw(14) << "logRaw/s" << std::setw(12) << "p50 ns"
+              << std::setw(12) << "p99 ns" << std::setw(10) << "commits" << std::setw(8) << "fsyncs"
+              << std::setw(10) << "written" << std::endl;
+    AuditVerdict verdict;
+    for (auto policy : {AggregatedLogger::Config::NONE, AggregatedLogger::Config::INTERVAL, AggregatedLogger::Config::COMMIT}) {
+        const std::string raw_dir = (dir / ("raw_" + std::string(AggregatedLogger::Config::toString(policy)))).string();
+        AggregatedLogger logger(raw_dir, (dir / "aggregated_bench").string(),
+                                (dir / ("history_" + std::string(AggregatedLogger::Config::toString(policy)))).string());
+        AggregatedLogger::Config log_config;
+        log_config.fsync = policy;
+        logger.setConfig(log_config);
+        
+        std::vector<double> latency_ns;
+        latency_ns.reserve(items.size());
+        auto t0 = std::chrono::steady_clock::now();
+        for (const auto& item : items) {
+            AgentAction action;
+            action.agent_id = item["agent_id"];
+            action.action = item["action"];
+            action.tool_name = item["tool_name"];
+            auto c0 = std::chrono::steady_clock::now();
+            logger.logRaw(action, verdict, 0.5f);
+            latency_ns.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - c0).count());
+        }
+        const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        logger.flush();
+        const RawLogStats stats = logger.getRawLogStats();
+        if (stats.written != static_cast<uint64_t>(actions)) ++mismatches;
+        
+        std::sort(latency_ns.begin(), latency_ns.end());
+        std::cout << std::setw(10) << AggregatedLogger::Config::toString(policy)
+                  << std::setw(14) << std::setprecision(0) << actions / sec
+                  << std::setw(12) << latency_ns[latency_ns.size() / 2]
+                  << std::setw(12) << latency_ns[latency_ns.size() * 99 / 100]
+                  << std::setw(10) << stats.commits << std::setw(8) << stats.fsyncs
+                  << std::setw(10) << stats.written << std::endl;
+    }
+    
+    // Колоночная история: примитивы аналитики на миллионе строк за 30 суток
+    {
+        constexpr size_t ROWS = 1000000;
+        constexpr int64_t HOUR_MS = 3600 * 1000;
+        AuditHistory history((dir / "history_scan").string());
+        const int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        const int64_t span_ms = 30 * 24 * HOUR_MS;
+        
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<AuditHistory::Record> records(4096);
+        for (size_t row = 0; row < ROWS; row += records.size()) {
+            for (size_t i = 0; i < records.size(); ++i) {
+                const size_t n = row + i;
+                records[i].timestamp_ms = now_ms - span_ms + static_cast<int64_t>(n) * span_ms / static_cast<int64_t>(ROWS);
+                records[i].agent_id = agents[n % 4];
+                records[i].action = "call_tool";
+                records[i].tool = tools[n % 6];
+                records[i].risk = static_cast<float>(n % 100) / 100.0f;
+                records[i].allowed = n % 7 != 0;
+            }
+            history.append(records);
+        }
+        const double append_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        
+        AuditHistory::Filter all;
+        AuditHistory::Filter day;
+        day.from_ms = now_ms - 24 * HOUR_MS;
+        auto timed = [](const auto& query) {
+            auto q0 = std::chrono::steady_clock::now();
+            query();
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - q0).count();
+        };
+        uint64_t checksum = 0;
+        std::cout << std::setw(14) << "history" << std::setw(12) << "all ms" << std::setw(12) << "24h ms" << std::endl;
+        std::cout << std::setw(14) << "append" << std::setw(12) << std::setprecision(2) << append_ms << std::setw(12) << "-" << std::endl;
+        for (const char* name : {"summarize", "countBy", "timeline", "riskHist"}) {
+            auto run = [&](const AuditHistory::Filter& filter) {
+                const std::string query = name;
+                if (query == "summarize") checksum += history.summarize(filter).rows;
+                else if (query == "countBy") checksum += history.countBy(AuditHistory::TOOL, filter)[0];
+                else if (query == "timeline") checksum += history.timeline(filter, now_ms - span_ms, HOUR_MS, 720)[0];
+                else checksum += history.riskHistogram(filter, {0.3f, 0.7f})[0];
+            };
+            std::cout << std::setw(14) << name
+                      << std::setw(12) << timed([&]() { run(all); })
+                      << std::setw(12) << timed([&]() { run(day); }) << std::endl;
+        }
+        // Строки дописываются блоками по records.size(): последний блок выходит за ROWS
+        const uint64_t appended = (ROWS + records.size() - 1) / records.size() * records.size();
+        if (history.size() != appended || checksum == 0) ++mismatches;
+    }
+    
+    registry.stop();
+    fs::current_path(cwd);
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Снимки памяти: --memory-bench [records]. Случайные пулы сохраняются и
+// читаются обратно; записи должны совпасть побитово, а испорченный байт —
+// отклоняться загрузкой.
+int runMemoryBenchmark(int records) {
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::temp_directory_path() / ("memory_bench_" + std::to_string(getpid()));
+    fs::create_directories(dir);
+    const std::string path = (dir / "ltm.bin").string();
+    
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    std::uniform_int_distribution<int> length(0, 64);
+    const char* tags[] = {"", "episodic", "tool:read_file", "tool:exec", "reward"};
+    std::deque<NeuroMemoryRecord> pool;
+    for (int i = 0; i < records; ++i) {
+        NeuroMemoryRecord r;
+        r.group_id = i % 16;
+        r.neuron_id = i;
+        r.signature.incoming.resize(length(rng));
+        r.signature.outgoing.resize(length(rng));
+        r.embedding.resize(i % 3 == 0 ? 0 : 32);
+        for (auto& x : r.signature.incoming) x = value(rng);
+        for (auto& x : r.signature.outgoing) x = value(rng);
+        for (auto& x : r.embedding) x = value(rng);
+        r.signature.firing_rate = value(rng);
+        r.signature.spike_timing_pattern = value(rng);
+        r.importance = value(rng);
+        r.decay_rate = value(rng);
+        r.age = i * 3;
+        r.last_accessed = i * 7;
+        r.trophic_history = value(rng);
+        r.tag = tags[i % 5];
+        r.avg_firing_rate = value(rng);
+        r.spike_variability = value(rng);
+        pool.push_back(std::move(r));
+    }
+    
+    auto same = [](const NeuroMemoryRecord& a, const NeuroMemoryRecord& b) {
+        return a.group_id == b.group_id && a.neuron_id == b.neuron_id &&
+               a.signature.incoming == b.signature.incoming && a.signature.outgoing == b.signature.outgoing &&
+               a.signature.firing_rate == b.signature.firing_rate &&
+               a.signature.spike_timing_pattern == b.signature.spike_timing_pattern &&
+               a.importance == b.importance && a.decay_rate == b.decay_rate && a.age == b.age &&
+               a.last_accessed == b.last_accessed && a.trophic_history == b.trophic_history &&
+               a.tag == b.tag && a.embedding == b.embedding && a.avg_firing_rate == b.avg_firing_rate &&
+               a.spike_variability == b.spike_variability;
+    };
+    
+    int mismatches = 0;
+    std::string error;
+    auto t0 = std::chrono::steady_clock::now();
+    if (!MemorySnapshot::save(path, pool, &error)) {
+        std::cerr << "[MemoryBench] save failed: " << error << std::endl;
+        ++mismatches;
+    }
+    const double save_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    
+    std::deque<NeuroMemoryRecord> loaded;
+    t0 = std::chrono::steady_clock::now();
+    if (!MemorySnapshot::load(path, loaded, &error)) {
+        std::cerr << "[MemoryBench] load failed: " << error << std::endl;
+        ++mismatches;
+    }
+    const double load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    
+    if (loaded.size() != pool.size()) {
+        ++mismatches;
+    } else {
+        for (size_t i = 0; i < pool.size(); ++i) {
+            if (!same(pool[i], loaded[i])) ++mismatches;
+        }
+    }
+    
+    std::error_code ec;
+    const auto bytes = fs::file_size(path, ec);
+    
+    // Порча одного байта в середине файла должна отклоняться, пул — оставаться прежним
+    if (bytes > 0) {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        char byte = 0;
+        file.seekg(static_cast<std::streamoff>(bytes / 2));
+        file.get(byte);
+        file.seekp(static_cast<std::streamoff>(bytes / 2));
+        file.put(static_cast<char>(byte ^ 0x01));
+    }
+    std::deque<NeuroMemoryRecord> rejected(1);
+    const bool corrupt_rejected = !MemorySnapshot::load(path, rejected, &error) && rejected.size() == 1;
+    if (!corrupt_rejected) ++mismatches;
+    
+    std::cout << "[MemoryBench] " << records << " records, " << bytes << " bytes" << std::endl;
+    std::cout << std::setw(14) << "save ms" << std::setw(14) << "load ms" << std::setw(14) << "mismatches"
+              << std::setw(14) << "corrupt" << std::endl;
+    std::cout << std::fixed << std::setprecision(2)
+              << std::setw(14) << save_ms << std::setw(14) << load_ms << std::setw(14) << mismatches
+              << std::setw(14) << (corrupt_rejected ? "rejected" : "ACCEPTED") << std::endl;
+    
+    fs::remove_all(dir, ec);
+    return mismatches == 0 ? 0 : 1;
+}
+
 int main(int argc, char* argv[]) {
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
@@ -56,21 +605,71 @@ int main(int argc, char* argv[]) {
     // Парсинг аргументов
     std::string workspace = "agent_workspace";
     int web_port = 8080;
+    int num_groups = 0;   // 0 — из конфига
+    int group_size = 0;
+    int threads = -1;     // -1 — из конфига
+    int bench_steps = 0;
+    int http_bench_requests = 0;
+    int audit_bench_actions = 0;
+    int memory_bench_records = 0;
+    bool has_seed = false;  // без --seed — случайный, печатается при старте
+    uint64_t seed = 0;
     
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
         if (arg == "--workspace" && i + 1 < argc) workspace = argv[++i];
         else if (arg == "--port" && i + 1 < argc) web_port = std::stoi(argv[++i]);
+        else if (arg == "--groups" && i + 1 < argc) num_groups = std::stoi(argv[++i]);
+        else if (arg == "--group-size" && i + 1 < argc) group_size = std::stoi(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) threads = std::stoi(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc) { seed = std::stoull(argv[++i]); has_seed = true; }
+        else if (arg == "--bench") {
+            int steps = (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+                      ? std::stoi(argv[++i]) : 500;
+            bench_steps = steps;
+        }
+        else if (arg == "--http-bench") {
+            http_bench_requests = (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+                                ? std::stoi(argv[++i]) : 20000;
+        }
+        else if (arg == "--audit-bench") {
+            audit_bench_actions = (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+                                ? std::stoi(argv[++i]) : 5000;
+        }
+        else if (arg == "--memory-bench") {
+            memory_bench_records = (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+                                 ? std::stoi(argv[++i]) : 20000;
+        }
         else if (arg == "--help") {
-            std::cout << "Usage: ./advanced_neural_system --workspace <path> --port <port>" << std::endl;
+            std::cout << "Usage: ./advanced_neural_system --workspace <path> --port <port>"
+                      << " [--groups N] [--group-size M] [--threads T] [--seed S] [--bench [steps]]"
+                      << " [--http-bench [requests]] [--audit-bench [actions]]"
+                      << " [--memory-bench [records]]" << std::endl;
             return 0;
         }
     }
+    if (bench_steps > 0) {
+        return runFieldBenchmark(bench_steps, threads);
+    }
+    if (http_bench_requests > 0) {
+        return runHttpBenchmark(http_bench_requests, web_port);
+    }
+    if (audit_bench_actions > 0) {
+        return runAuditBenchmark(audit_bench_actions);
+    }
+    if (memory_bench_records > 0) {
+        return runMemoryBenchmark(memory_bench_records);
+    }
     
     // Инициализация
     auto& config = AgentConfig::getInstance();
     config.setWorkingDirectory(workspace);
     config.loadFromFile();
+    if (threads >= 0) config.setWorkerThreads(threads);
+    if (num_groups > 0 || group_size > 0) {
+        config.setFieldTopology(num_groups > 0 ? num_groups : config.getNumGroups(),
+                                group_size > 0 ? group_size : config.getGroupSize());
+    }
     
     // Создаём директории
     std::filesystem::create_directories(workspace + "/logs/raw");
@@ -78,21 +677,58 @@ int main(int argc, char* argv[]) {
     std::filesystem::create_directories(workspace + "/memory");
     std::filesystem::create_directories("web");
     
-    // Инициализация AgentRegistry
+    // Инициализация AgentRegistry (agents.json пишет фоновый поток)
+    AgentRegistry::Config registry_config;
+    registry_config.write_behind = config.getRegistryWriteBehind();
+    registry_config.flush_interval_ms = config.getRegistryFlushIntervalMs();
+    registry_config.flush_threshold = static_cast<size_t>(std::max(1, config.getRegistryFlushThreshold()));
+    AgentRegistry::getInstance().setConfig(registry_config);
     AgentRegistryInitializer registryInit(workspace);
     
     // Инициализация нейросети
-    NeuralFieldSystem nfs(0.01);
+    try {
+        FieldTopology check(config.getNumGroups(), config.getGroupSize());
+    } catch (const std::exception& e) {
+        std::cerr << "[Main] Invalid field topology: " << e.what() << std::endl;
+        return 1;
+    }
+    NeuralFieldSystem nfs(0.01, config.getNumGroups(), config.getGroupSize());
     g_nfs = &nfs;
     
-    std::mt19937 rng(std::random_device{}());
-    nfs.initialize(rng);
+    if (!has_seed) {
+        std::random_device rd;
+        seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+    }
+    nfs.setStdpGating(StdpGating::fromString(config.getStdpGating()));
+    nfs.initialize(seed);
+    nfs.setWorkerThreads(config.getWorkerThreads());
+    nfs.setInterWeightStorage(InterWeightStorage::fromString(config.getInterWeightStorage()));
     nfs.setOperatingMode(OperatingMode::NORMAL);
+    std::cout << "[Main] SIMD kernels: LIF=" << SimdLevel::toString(LifKernel::best())
+              << ", STDP=" << SimdLevel::toString(StdpKernel::best())
+              << ", worker threads=" << nfs.getWorkerThreads()
+              << ", inter weights=" << InterWeightStorage::toString(nfs.getInterWeights().storage())
+              << (nfs.getInterWeights().isDense() ? " (dense)" : " (csr)")
+              << ", stdp gating=" << StdpGating::toString(nfs.getStdpGating()) << std::endl;
+    
+    // Поле двигает только его поток; HTTP-потоки шлют команды в очередь
+    SimulationLoop::Config sim_config;
+    sim_config.capacity = static_cast<size_t>(std::max(1, config.getSimulationQueueCapacity()));
+    sim_config.coalesce_threshold = static_cast<size_t>(std::max(1, config.getSimulationCoalesceThreshold()));
+    SimulationLoop simulation(nfs, sim_config);
+    simulation.start();
     
     // Инициализация аудитора
     AgentAuditBridge auditor(nfs);
     g_auditor = &auditor;
+    auditor.setSimulationLoop(&simulation);
     auditor.setWorkingDirectory(workspace);
+    AggregatedLogger::Config raw_log_config;
+    raw_log_config.fsync = AggregatedLogger::Config::fromString(config.getRawLogFsync());
+    raw_log_config.fsync_interval_ms = config.getRawLogFsyncIntervalMs();
+    raw_log_config.commit_interval_ms = config.getRawLogCommitIntervalMs();
+    raw_log_config.segment_bytes = static_cast<size_t>(std::max(1, config.getRawLogSegmentMb())) << 20;
+    auditor.getLogger().setConfig(raw_log_config);
     
     // Загрузка ограничений
     for (const auto& constraint : config.getConstraints()) {
@@ -103,7 +739,14 @@ int main(int argc, char* argv[]) {
     // Запуск HTTP сервера
     HttpServer server(web_port, workspace, &nfs, &auditor);
     g_server = &server;
+    server.setSimulationLoop(&simulation);
     server.setRunningFlag(&g_running);
+    HttpServer::Config http_config;
+    http_config.workers = config.getHttpWorkers();
+    http_config.max_connections = static_cast<size_t>(std::max(1, config.getHttpMaxConnections()));
+    http_config.idle_timeout_ms = config.getHttpIdleTimeoutMs();
+    http_config.max_body_bytes = config.getHttpMaxBodyBytes();
+    server.setConfig(http_config);
     
     if (!server.start()) {
         std::cerr << "[Main] Failed to start HTTP server" << std::endl;
@@ -148,7 +791,7 @@ int main(int argc, char* argv[]) {
         if (command == "quit" || command == "exit") {
             break;
         } else if (command == "status") {
-            auto& session = auditor.getCurrentSession();
+            auto session = auditor.getCurrentSession();
             std::cout << "Session: " << session.session_id << std::endl;
             std::cout << "Steps: " << session.total_steps << std::endl;
             std::cout << "Risk: " << auditor.getCurrentHallucinationRisk() << std::endl;
@@ -175,6 +818,12 @@ int main(int argc, char* argv[]) {
         g_server->stop();
     }
     
+    // Выполняем принятые команды поля и останавливаем его поток
+    simulation.stop();
+    
+    // Дописываем отложенные изменения реестра агентов
+    AgentRegistry::getInstance().stop();
+    
     // Завершаем сессию аудитора и сохраняем состояние
     if (g_auditor) {
         g_auditor->endSession();
@@ -0,0 +1,265 @@
+// server/AgentRegistry.cpp
+#include "AgentRegistry.hpp"
+#include "core/AtomicFile.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+namespace {
+    // Целый JSON-массив из файла; false — файла нет или он недописан/битый
+    bool readAgentsFile(const std::string& path, nlohmann::json& data) {
+        std::ifstream file(path);
+        if (!file.is_open()) return false;
+        try {
+            file >> data;
+        } catch (...) {
+            return false;
+        }
+        return data.is_array();
+    }
+}
+
+AgentRegistry::~AgentRegistry() {
+    stop();
+}
+
+bool AgentRegistry::registerAgent(const std::string& agent_id, const std::string& type, const std::string& endpoint) {
+    RegisteredAgent agent;
+    agent.agent_id = agent_id;
+    agent.type = type;
+    agent.endpoint = endpoint;
+    agent.registered_at = time(nullptr);
+    agent.last_heartbeat = time(nullptr);
+    agent.status = "active";
+    agent.total_actions = 0;
+    agent.avg_risk = 0.0f;
+
+    {
+        Shard& shard = shardFor(agent_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.agents[agent_id] = agent;
+    }
+    markChanged();
+
+    std::cout << "[Registry] Agent registered: " << agent_id << " (" << type << ")" << std::endl;
+    return true;
+}
+
+bool AgentRegistry::heartbeat(const std::string& agent_id) {
+    {
+        Shard& shard = shardFor(agent_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.agents.find(agent_id);
+        if (it == shard.agents.end()) return false;
+        it->second.last_heartbeat = time(nullptr);
+        it->second.status = "active";
+    }
+    markChanged();
+    return true;
+}
+
+void AgentRegistry::recordAction(const std::string& agent_id, float risk, bool allowed) {
+    {
+        Shard& shard = shardFor(agent_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.agents.find(agent_id);
+        if (it == shard.agents.end()) return;
+        applyAction(it->second, risk);
+    }
+    markChanged();
+}
+
+void AgentRegistry::recordActions(const std::vector<ActionRecord>& records) {
+    // Раскладываем по шардам, чтобы каждый блокировать один раз
+    std::array<std::vector<const ActionRecord*>, SHARDS> by_shard;
+    for (const auto& record : records) {
+        by_shard[std::hash<std::string>{}(record.agent_id) % SHARDS].push_back(&record);
+    }
+
+    uint64_t changed = 0;
+    for (size_t i = 0; i < SHARDS; ++i) {
+        if (by_shard[i].empty()) continue;
+        Shard& shard = shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const ActionRecord* record : by_shard[i]) {
+            auto it = shard.agents.find(record->agent_id);
+            if (it == shard.agents.end()) continue;
+            applyAction(it->second, record->risk);
+            ++changed;
+        }
+    }
+    if (changed > 0) markChanged(changed);
+}
+
+void AgentRegistry::applyAction(RegisteredAgent& agent, float risk) {
+    agent.total_actions++;
+    agent.avg_risk = (agent.avg_risk * (agent.total_actions - 1) + risk) / agent.total_actions;
+}
+
+nlohmann::json AgentRegistry::getAllAgents() const {
+    std::vector<RegisteredAgent> agents;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& [id, agent] : shard.agents) {
+            agents.push_back(agent);
+        }
+    }
+    std::sort(agents.begin(), agents.end(), [](const RegisteredAgent& a, const RegisteredAgent& b) {
+        return a.agent_id < b.agent_id;
+    });
+
+    nlohmann::json result = nlohmann::json::array();
+    for (const auto& agent : agents) {
+        result.push_back(agent.toJson());
+    }
+    return result;
+}
+
+void AgentRegistry::loadFromFile(const std::string& workspace) {
+    const std::string path = workspace + "/agents.json";
+    const std::string tmp_path = path + ".tmp";
+
+    // Целый tmp значит, что сбой был между fsync и rename: он новее agents.json
+    nlohmann::json data;
+    if (readAgentsFile(tmp_path, data)) {
+        std::rename(tmp_path.c_str(), path.c_str());
+        std::cout << "[Registry] Recovered agents from " << tmp_path << std::endl;
+    } else {
+        std::remove(tmp_path.c_str());
+        if (!readAgentsFile(path, data)) {
+            if (std::filesystem::exists(path)) {
+                const std::string corrupt_path = path + ".corrupt";
+                std::rename(path.c_str(), corrupt_path.c_str());
+                std::cerr << "[Registry] Unreadable " << path << " moved to " << corrupt_path << std::endl;
+            }
+            return;
+        }
+    }
+
+    for (const auto& item : data) {
+        try {
+            RegisteredAgent agent;
+            agent.agent_id = item.value("agent_id", "");
+            agent.type = item.value("type", "");
+            agent.endpoint = item.value("endpoint", "");
+            agent.registered_at = item.value("registered_at", 0L);
+            agent.last_heartbeat = item.value("last_heartbeat", 0L);
+            agent.status = item.value("status", "unknown");
+            agent.total_actions = item.value("total_actions", 0);
+            agent.avg_risk = item.value("avg_risk", 0.0f);
+
+            Shard& shard = shardFor(agent.agent_id);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.agents[agent.agent_id] = agent;
+        } catch (...) {}
+    }
+}
+
+void AgentRegistry::setConfig(const Config& config) {
+    {
+        std::lock_guard<std::mutex> lock(flusher_mutex_);
+        flush_interval_ms_ = std::max(1, config.flush_interval_ms);
+    }
+    flush_threshold_.store(std::max<size_t>(1, config.flush_threshold));
+    write_behind_.store(config.write_behind);
+    flusher_cv_.notify_one();
+}
+
+AgentRegistry::Config AgentRegistry::config() const {
+    Config config;
+    config.write_behind = write_behind_.load();
+    config.flush_threshold = flush_threshold_.load();
+    std::lock_guard<std::mutex> lock(flusher_mutex_);
+    config.flush_interval_ms = flush_interval_ms_;
+    return config;
+}
+
+void AgentRegistry::setWorkspace(const std::string& workspace) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    workspace_ = workspace;
+}
+
+void AgentRegistry::markChanged(uint64_t count) {
+    const uint64_t changes = changes_.fetch_add(count) + count;
+    if (!write_behind_.load(std::memory_order_relaxed)) {
+        flush();
+        return;
+    }
+    if (changes - flushed_changes_.load(std::memory_order_relaxed) >= flush_threshold_.load(std::memory_order_relaxed)) {
+        flusher_cv_.notify_one();
+    }
+}
+
+void AgentRegistry::start() {
+    std::lock_guard<std::mutex> lock(flusher_mutex_);
+    if (flusher_.joinable()) return;
+    flusher_stop_ = false;
+    flusher_ = std::thread([this]() { flusherLoop(); });
+}
+
+void AgentRegistry::stop() {
+    {
+        std::lock_guard<std::mutex> lock(flusher_mutex_);
+        if (!flusher_.joinable()) return;
+        flusher_stop_ = true;
+    }
+    flusher_cv_.notify_one();
+    flusher_.join();
+    flush();
+}
+
+void AgentRegistry::flusherLoop() {
+    std::unique_lock<std::mutex> lock(flusher_mutex_);
+    while (!flusher_stop_) {
+        flusher_cv_.wait_for(lock, std::chrono::milliseconds(flush_interval_ms_), [this]() {
+            return flusher_stop_ ||
+                   changes_.load() - flushed_changes_.load() >= flush_threshold_.load();
+        });
+        if (flusher_stop_) break;
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+bool AgentRegistry::flush() {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (workspace_.empty()) return true;
+
+    // Изменения после этой точки попадут в снимок или в следующую запись
+    const uint64_t target = changes_.load();
+    if (target == flushed_changes_.load()) return true;
+
+    auto t0 = std::chrono::steady_clock::now();
+    const std::string path = workspace_ + "/agents.json";
+    if (!AtomicFile::write(path, getAllAgents().dump(2))) {
+        flush_errors_++;
+        std::cerr << "[Registry] Failed to write " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    flushed_changes_.store(target);
+    flushes_++;
+    last_flush_us_ = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    return true;
+}
+
+AgentRegistryStats AgentRegistry::stats() const {
+    AgentRegistryStats s;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        s.agents += shard.agents.size();
+    }
+    s.changes = changes_.load();
+    s.pending = s.changes - flushed_changes_.load();
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    s.flushes = flushes_;
+    s.flush_errors = flush_errors_;
+    s.last_flush_us = last_flush_us_;
+    return s;
+}
@@ -2,11 +2,15 @@
 #pragma once
 
 #include <string>
-#include <map>
+#include <unordered_map>
+#include <vector>
+#include <array>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdint>
 #include <nlohmann/json.hpp>
-#include <fstream>
-#include <iostream>
 #include <ctime>
 
 struct RegisteredAgent {
@@ -33,112 +37,143 @@ struct RegisteredAgent {
     }
 };
 
+/**
+ * @struct AgentRegistryStats
+ * @brief Счётчики отложенной записи реестра
+ */
+struct AgentRegistryStats {
+    size_t agents = 0;
+    uint64_t changes = 0;           // изменений с запуска
+    uint64_t pending = 0;           // ещё не записано в agents.json
+    uint64_t flushes = 0;
+    uint64_t flush_errors = 0;
+    double last_flush_us = 0.0;
+    
+    nlohmann::json toJson() const {
+        nlohmann::json j;
+        j["agents"] = agents;
+        j["changes"] = changes;
+        j["pending"] = pending;
+        j["flushes"] = flushes;
+        j["flush_errors"] = flush_errors;
+        j["last_flush_us"] = last_flush_us;
+        return j;
+    }
+};
+
+// --------------------
+// Реестр агентов с отложенной записью
+// --------------------
+/**
+ * @class AgentRegistry
+ * @brief Агенты в памяти (шарды по agent_id); agents.json пишет фоновый поток
+ *
+ * Логика:
+ * - изменения идут в память под мьютексом своего шарда и только
+ *   увеличивают счётчик изменений — файл на пути аудита не пишется
+ * - поток записи сохраняет снимок реестра раз в flush_interval_ms или раньше,
+ *   если накопилось flush_threshold изменений; без изменений не пишет
+ * - запись: agents.json.tmp, fsync, rename — agents.json всегда целый
+ * - loadFromFile после сбоя: целый agents.json.tmp (сбой между fsync и rename)
+ *   новее agents.json и берётся он; недописанный tmp удаляется; нечитаемый
+ *   agents.json откладывается в agents.json.corrupt
+ * - write_behind = false — запись на каждое изменение (прежнее поведение)
+ */
 class AgentRegistry {
 public:
+    struct Config {
+        bool write_behind = true;
+        int flush_interval_ms = 1000;
+        size_t flush_threshold = 256;
+    };
+    
+    // Одно проверенное действие для пакетной записи
+    struct ActionRecord {
+        std::string agent_id;
+        float risk = 0.0f;
+        bool allowed = true;
+    };
+    
     static AgentRegistry& getInstance() {
         static AgentRegistry instance;
         return instance;
     }
     
-    bool registerAgent(const std::string& agent_id, const std::string& type, const std::string& endpoint) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        RegisteredAgent agent;
-        agent.agent_id = agent_id;
-        agent.type = type;
-        agent.endpoint = endpoint;
-        agent.registered_at = time(nullptr);
-        agent.last_heartbeat = time(nullptr);
-        agent.status = "active";
-        agent.total_actions = 0;
-        agent.avg_risk = 0.0f;
-        
-        agents_[agent_id] = agent;
-        saveToFile();
-        
-        std::cout << "[Registry] Agent registered: " << agent_id << " (" << type << ")" << std::endl;
-        return true;
-    }
+    AgentRegistry(const AgentRegistry&) = delete;
+    AgentRegistry& operator=(const AgentRegistry&) = delete;
     
-    bool heartbeat(const std::string& agent_id) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        auto it = agents_.find(agent_id);
-        if (it != agents_.end()) {
-            it->second.last_heartbeat = time(nullptr);
-            it->second.status = "active";
-            saveToFile();
-            return true;
-        }
-        return false;
-    }
+    bool registerAgent(const std::string& agent_id, const std::string& type, const std::string& endpoint);
+    bool heartbeat(const std::string& agent_id);
+    void recordAction(const std::string& agent_id, float risk, bool allowed);
+    // Пакет действий: каждый шард блокируется один раз
+    void recordActions(const std::vector<ActionRecord>& records);
     
-    void recordAction(const std::string& agent_id, float risk, bool allowed) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        auto it = agents_.find(agent_id);
-        if (it != agents_.end()) {
-            it->second.total_actions++;
-            it->second.avg_risk = (it->second.avg_risk * (it->second.total_actions - 1) + risk) 
-                                  / it->second.total_actions;
-            saveToFile();
-        }
-    }
+    // Все агенты по возрастанию agent_id
+    nlohmann::json getAllAgents() const;
+    void loadFromFile(const std::string& workspace);
     
-    nlohmann::json getAllAgents() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        nlohmann::json result = nlohmann::json::array();
-        for (const auto& [id, agent] : agents_) {
-            result.push_back(agent.toJson());
-        }
-        return result;
-    }
+    // Можно менять на ходу; действует со следующего изменения
+    void setConfig(const Config& config);
+    Config config() const;
     
-    void loadFromFile(const std::string& workspace) {
-        std::string filepath = workspace + "/agents.json";
-        std::ifstream file(filepath);
-        if (file.is_open()) {
-            try {
-                nlohmann::json data;
-                file >> data;
-                for (const auto& item : data) {
-                    RegisteredAgent agent;
-                    agent.agent_id = item.value("agent_id", "");
-                    agent.type = item.value("type", "");
-                    agent.endpoint = item.value("endpoint", "");
-                    agent.registered_at = item.value("registered_at", 0L);
-                    agent.last_heartbeat = item.value("last_heartbeat", 0L);
-                    agent.status = item.value("status", "unknown");
-                    agent.total_actions = item.value("total_actions", 0);
-                    agent.avg_risk = item.value("avg_risk", 0.0f);
-                    agents_[agent.agent_id] = agent;
-                }
-            } catch(...) {}
-        }
-    }
+    // Поток записи; stop() записывает оставшиеся изменения
+    void start();
+    void stop();
+    // Записать изменения сейчас; false — ошибка записи
+    bool flush();
+    
+    AgentRegistryStats stats() const;
     
 private:
-    // ТОЛЬКО ОДИН КОНСТРУКТОР - удалите лишний
-    AgentRegistry() : workspace_("") {}
-    
-    void saveToFile() {
-        std::string filepath = workspace_ + "/agents.json";
-        std::ofstream file(filepath);
-        if (file.is_open()) {
-            file << getAllAgents().dump(2);
-        }
+    static constexpr size_t SHARDS = 16;
+    
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, RegisteredAgent> agents;
+    };
+    
+    AgentRegistry() = default;
+    ~AgentRegistry();
+    
+    Shard& shardFor(const std::string& agent_id) {
+        return shards_[std::hash<std::string>{}(agent_id) % SHARDS];
     }
+    // Вызывается под мьютексом шарда
+    static void applyAction(RegisteredAgent& agent, float risk);
+    // После изменения (мьютекс шарда уже отпущен)
+    void markChanged(uint64_t count = 1);
+    void setWorkspace(const std::string& workspace);
+    void flusherLoop();
+    
+    std::array<Shard, SHARDS> shards_;
+    
+    std::atomic<uint64_t> changes_{0};
+    std::atomic<uint64_t> flushed_changes_{0};
+    std::atomic<bool> write_behind_{true};
+    std::atomic<size_t> flush_threshold_{256};
     
-    mutable std::mutex mutex_;
-    std::map<std::string, RegisteredAgent> agents_;
+    // Запись файла: один писатель
+    mutable std::mutex write_mutex_;
     std::string workspace_;
+    uint64_t flushes_ = 0;
+    uint64_t flush_errors_ = 0;
+    double last_flush_us_ = 0.0;
     
-    friend class AgentRegistryInitializer;
+    // Поток записи
+    mutable std::mutex flusher_mutex_;
+    std::condition_variable flusher_cv_;
+    std::thread flusher_;
+    bool flusher_stop_ = false;
+    int flush_interval_ms_ = 1000;
+    
+    friend struct AgentRegistryInitializer;
 };
 
 struct AgentRegistryInitializer {
     AgentRegistryInitializer(const std::string& workspace) {
-        AgentRegistry::getInstance().workspace_ = workspace;
-        AgentRegistry::getInstance().loadFromFile(workspace);
+        auto& registry = AgentRegistry::getInstance();
+        registry.setWorkspace(workspace);
+        registry.loadFromFile(workspace);
+        registry.start();
     }
-};
\ No newline at end of file
+};
@@ -2,17 +2,38 @@
 #include "ApiHandlers.hpp"
 #include "core/NeuralFieldSystem.hpp"
 #include "core/AgentAuditBridge.hpp"
+#include "core/SimulationLoop.hpp"
 #include "server/AgentRegistry.hpp"
+#include <algorithm>
 #include <chrono>
+#include <ctime>
 #include <cstdlib>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <unistd.h>
 
+namespace {
+    const char* const FIELD_QUEUE_FULL = R"({"status":"error","reason":"Field queue full, change not applied"})";
+}
+
 ApiHandlers::ApiHandlers(NeuralFieldSystem* nfs, AgentAuditBridge* auditor, const std::string& workspace)
     : nfs_(nfs), auditor_(auditor), workspace_(workspace) {}
 
+bool ApiHandlers::modifyField(std::function<void(NeuralFieldSystem&)> fn) {
+    if (sim_ && sim_->submit(FieldCommand::run(fn), std::chrono::milliseconds(1000)) == SimulationLoop::ACCEPTED) {
+        return true;
+    }
+    if (sim_ && sim_->isRunning()) {
+        std::cerr << "[API] Field queue full, change not applied" << std::endl;
+        return false;
+    }
+    // Без потока поля — под тем же замком, что и обратная связь аудитора
+    if (auditor_) return auditor_->runOnField(std::move(fn));
+    fn(*nfs_);
+    return true;
+}
+
 std::string ApiHandlers::handleStatus() {
     std::string status_file = workspace_ + "/agent_status.json";
     std::ifstream file(status_file);
@@ -26,23 +47,25 @@ std::string ApiHandlers::handleStatus() {
         return R"({"status":"waiting","risk":0,"entropy":0.5,"quality":0.5,"surprise":0})";
     }
     
-    auto& session = auditor_->getCurrentSession();
+    // Сессия последнего активного агента — из опубликованного снимка
+    auto status = auditor_->getStatusSnapshot();
     nlohmann::json j;
     j["status"] = "active";
-    j["session_id"] = session.session_id;
-    j["total_steps"] = session.total_steps;
-    j["accumulated_risk"] = session.accumulated_risk;
-    j["avg_entropy"] = session.average_entropy;
-    j["risk"] = auditor_->getCurrentHallucinationRisk();
-    j["entropy"] = auditor_->getCurrentEntropy();
+    j["agent_id"] = status->agent_id;
+    j["session_id"] = status->session_id;
+    j["total_steps"] = status->total_steps;
+    j["accumulated_risk"] = status->accumulated_risk;
+    j["avg_entropy"] = status->average_entropy;
+    j["risk"] = status->risk;
+    j["entropy"] = status->entropy;
     j["quality"] = 0.7 - j["risk"].get<float>();
     j["surprise"] = j["risk"].get<float>() * 0.8;
     j["stm_size"] = 0;
     j["ltm_size"] = 0;
     j["ltm_avg_importance"] = 0.8;
     j["is_dangerous_mode"] = j["risk"].get<float>() > 0.7;
-    j["successful_actions"] = session.successful_actions;
-    j["blocked_actions"] = session.blocked_actions;
+    j["successful_actions"] = status->successful_actions;
+    j["blocked_actions"] = status->blocked_actions;
     return j.dump();
 }
 
@@ -59,15 +82,16 @@ std::string ApiHandlers::handleAuditorStatus() {
     if (!nfs_) {
         return "{}";
     }
+    // Только опубликованный снимок — шаг поля не блокируется
     nlohmann::json j;
-    auto& auditor = nfs_->getLagrangianAuditor();
-    auto& config = auditor.getConfig();
-    j["enabled"] = nfs_->isEnergyAuditEnabled();
-    j["energy"] = auditor.getReferenceEnergy();
-    j["energy_error"] = auditor.getEnergyError();
-    j["energy_error_ema"] = auditor.getEnergyError();
-    j["violations"] = auditor.getConservationViolations();
-    j["reference_energy"] = auditor.getReferenceEnergy();
+    auto snap = nfs_->getPublishedSnapshot();
+    const auto& config = snap->audit_config;
+    j["enabled"] = snap->audit_enabled;
+    j["energy"] = snap->energy;
+    j["energy_error"] = snap->energy_error;
+    j["energy_error_ema"] = snap->energy_error;
+    j["violations"] = snap->violations;
+    j["reference_energy"] = snap->energy;
     j["threshold_energy"] = config.energy_conservation_threshold;
     j["threshold_momentum"] = config.momentum_conservation_threshold;
     j["threshold_action"] = config.action_threshold;
@@ -77,21 +101,69 @@ std::string ApiHandlers::handleAuditorStatus() {
 }
 
 std::string ApiHandlers::handleAnalytics() {
+    std::vector<AgentSession> sessions;
+    if (auditor_) sessions = auditor_->getSessions();
+    int total_steps = 0;
+    for (const auto& session : sessions) total_steps += session.total_steps;
+    
     nlohmann::json j;
     j["active_orchestrations"] = 1;
-    j["total_agents"] = 1;
-    j["active_agents"] = auditor_ ? 1 : 0;
-    j["total_actions"] = auditor_ ? auditor_->getCurrentSession().total_steps : 0;
-    j["success_rate"] = 0.8;
-    j["low_risk_count"] = 5;
-    j["medium_risk_count"] = 3;
-    j["high_risk_count"] = 1;
-    j["timeline"] = {{"labels", {"00", "01", "02", "03", "04", "05", "06", "07", "08", "09", "10", "11", "12", "13", "14", "15", "16", "17", "18", "19", "20", "21", "22", "23"}}, 
-                      {"values", {2,1,0,0,0,0,1,3,5,8,12,15,18,22,25,28,30,35,38,42,45,48,50,45}}};
+    j["total_agents"] = sessions.size();
+    j["active_agents"] = sessions.size();
+    j["total_actions"] = total_steps;
+    j["success_rate"] = 0.0;
+    j["low_risk_count"] = 0;
+    j["medium_risk_count"] = 0;
+    j["high_risk_count"] = 0;
+    j["timeline"] = {{"labels", nlohmann::json::array()}, {"values", nlohmann::json::array()}};
     j["tools_usage"] = nlohmann::json::array();
-    j["tools_usage"].push_back({{"name", "run_sql"}, {"count", 45}});
-    j["tools_usage"].push_back({{"name", "calculate"}, {"count", 23}});
-    j["tools_usage"].push_back({{"name", "respond"}, {"count", 67}});
+    
+    // Последние 24 часа из колоночной истории: по часам, по инструментам, по риску
+    if (auditor_ && auditor_->getLogger().getHistory().isOpen()) {
+        const AuditHistory& history = auditor_->getLogger().getHistory();
+        const auto t0 = std::chrono::steady_clock::now();
+        constexpr int64_t HOUR_MS = 3600 * 1000;
+        const int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        AuditHistory::Filter day;
+        day.from_ms = (now_ms / HOUR_MS - 23) * HOUR_MS;
+        
+        const auto summary = history.summarize(day);
+        j["total_actions"] = summary.rows;
+        j["total_actions_all_time"] = history.size();
+        j["success_rate"] = summary.rows > 0 ? static_cast<double>(summary.allowed) / summary.rows : 0.0;
+        
+        const auto risk = history.riskHistogram(day, {0.3f, 0.7f});
+        j["low_risk_count"] = risk[0];
+        j["medium_risk_count"] = risk[1];
+        j["high_risk_count"] = risk[2];
+        
+        const auto hourly = history.timeline(day, day.from_ms, HOUR_MS, 24);
+        for (size_t i = 0; i < hourly.size(); ++i) {
+            std::time_t hour = static_cast<std::time_t>((day.from_ms + static_cast<int64_t>(i) * HOUR_MS) / 1000);
+            char label[8];
+            std::strftime(label, sizeof(label), "%H", std::localtime(&hour));
+            j["timeline"]["labels"].push_back(label);
+            j["timeline"]["values"].push_back(hourly[i]);
+        }
+        
+        const auto by_tool = history.countBy(AuditHistory::TOOL, day);
+        std::vector<std::pair<uint64_t, uint32_t>> tools;
+        for (uint32_t id = 0; id < by_tool.size(); ++id) {
+            if (by_tool[id] > 0) tools.push_back({by_tool[id], id});
+        }
+        std::sort(tools.begin(), tools.end(), std::greater<>());
+        for (const auto& [count, id] : tools) {
+            const std::string name = history.name(AuditHistory::TOOL, id);
+            if (name.empty()) continue;
+            j["tools_usage"].push_back({{"name", name}, {"count", count}});
+            if (j["tools_usage"].size() >= 10) break;
+        }
+        
+        j["history"] = {{"rows", history.size()},
+                        {"scanned", summary.scanned},
+                        {"query_us", std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count()}};
+    }
     j["orchestrations"] = nlohmann::json::array();
     j["agents"] = nlohmann::json::array();
     
@@ -99,21 +171,26 @@ std::string ApiHandlers::handleAnalytics() {
         nlohmann::json orch;
         orch["id"] = "main_orch";
         orch["type"] = "demo";
-        orch["agents"] = 1;
+        orch["agents"] = sessions.size();
         orch["status"] = "active";
         orch["avg_risk"] = auditor_->getCurrentHallucinationRisk();
-        orch["actions"] = auditor_->getCurrentSession().total_steps;
+        orch["actions"] = total_steps;
         j["orchestrations"].push_back(orch);
         
-        nlohmann::json agent;
-        agent["id"] = auditor_->getCurrentSession().session_id;
-        agent["type"] = "llm";
-        agent["orchestration"] = "main_orch";
-        agent["status"] = "active";
-        agent["risk"] = auditor_->getCurrentHallucinationRisk();
-        agent["entropy"] = auditor_->getCurrentEntropy();
-        agent["last_active"] = std::to_string(time(nullptr));
-        j["agents"].push_back(agent);
+        const float entropy = auditor_->getCurrentEntropy();
+        for (const auto& session : sessions) {
+            nlohmann::json agent;
+            agent["id"] = session.agent_name.empty() ? session.session_id : session.agent_name;
+            agent["session_id"] = session.session_id;
+            agent["type"] = "llm";
+            agent["orchestration"] = "main_orch";
+            agent["status"] = "active";
+            agent["actions"] = session.total_steps;
+            agent["risk"] = session.total_steps > 0 ? session.accumulated_risk / session.total_steps : 0.0f;
+            agent["entropy"] = entropy;
+            agent["last_active"] = std::to_string(time(nullptr));
+            j["agents"].push_back(agent);
+        }
     }
     return j.dump();
 }
@@ -168,35 +245,98 @@ std::string ApiHandlers::handleHeartbeat(const nlohmann::json& body) {
     return R"({"status":"ok"})";
 }
 
+namespace {
+    // agent_id из тела POST; тело может быть пустым (null)
+    std::string agentIdOf(const nlohmann::json& body) {
+        return body.is_object() ? body.value("agent_id", "") : std::string();
+    }
+
+    // Поля действия — общие для /api/audit/action и /api/audit/actions
+    AgentAction actionFromJson(const nlohmann::json& item, const std::string& agent_id, const std::string& action_id) {
+        AgentAction audit_action;
+        audit_action.agent_id = agent_id;
+        audit_action.action = item.value("action", "");
+        audit_action.tool_name = item.value("tool_name", "");
+        audit_action.thought = item.value("thought", "");
+        audit_action.step_number = item.value("step", 0);
+        audit_action.action_id = action_id;
+        return audit_action;
+    }
+
+    nlohmann::json verdictToJson(const AuditVerdict& verdict) {
+        nlohmann::json result;
+        result["allowed"] = verdict.allowed;
+        result["risk"] = verdict.hallucination_risk;
+        result["reason"] = verdict.reason;
+        result["suggested_action"] = verdict.suggested_action;
+        return result;
+    }
+}
+
 std::string ApiHandlers::handleAuditAction(const nlohmann::json& body) {
     if (!auditor_ || !nfs_) {
         return R"({"allowed":true,"risk":0,"reason":"Auditor not available"})";
     }
     
     std::string agent_id = body.value("agent_id", "");
-    std::string action = body.value("action", "");
-    std::string tool_name = body.value("tool_name", "");
-    std::string thought = body.value("thought", "");
-    float confidence = body.value("confidence", 0.5f);
-    int step = body.value("step", 0);
-    
-    AgentAction audit_action;
-    audit_action.action = action;
-    audit_action.tool_name = tool_name;
-    audit_action.thought = thought;
-    audit_action.step_number = step;
-    audit_action.action_id = "api_" + std::to_string(time(nullptr));
+    AgentAction audit_action = actionFromJson(body, agent_id, "api_" + std::to_string(time(nullptr)));
     
     AuditVerdict verdict = auditor_->auditAction(audit_action);
     
     AgentRegistry::getInstance().recordAction(agent_id, verdict.hallucination_risk, verdict.allowed);
     
-    nlohmann::json result;
-    result["allowed"] = verdict.allowed;
-    result["risk"] = verdict.hallucination_risk;
-    result["reason"] = verdict.reason;
-    result["suggested_action"] = verdict.suggested_action;
+    return verdictToJson(verdict).dump();
+}
+
+std::string ApiHandlers::handleAuditActions(const nlohmann::json& body) {
+    // Массив действий или {"agent_id": общий, "actions": [...]}
+    const nlohmann::json* items = &body;
+    std::string default_agent;
+    if (body.is_object()) {
+        default_agent = body.value("agent_id", "");
+        auto it = body.find("actions");
+        if (it == body.end()) {
+            return R"({"error":"actions array required"})";
+        }
+        items = &*it;
+    }
+    if (!items->is_array()) {
+        return R"({"error":"actions array required"})";
+    }
+    for (const auto& item : *items) {
+        if (!item.is_object()) {
+            return R"({"error":"each action must be an object"})";
+        }
+    }
+    
+    nlohmann::json result = nlohmann::json::array();
+    if (!auditor_ || !nfs_) {
+        for (size_t i = 0; i < items->size(); ++i) {
+            result.push_back({{"allowed", true}, {"risk", 0}, {"reason", "Auditor not available"}});
+        }
+        return result.dump();
+    }
+    
+    const std::string id_prefix = "api_" + std::to_string(time(nullptr)) + "_";
+    std::vector<AgentAction> actions;
+    actions.reserve(items->size());
+    for (size_t i = 0; i < items->size(); ++i) {
+        const auto& item = (*items)[i];
+        actions.push_back(actionFromJson(item, item.value("agent_id", default_agent), id_prefix + std::to_string(i)));
+    }
     
+    std::vector<AuditVerdict> verdicts = auditor_->auditActions(actions);
+    
+    std::vector<AgentRegistry::ActionRecord> records;
+    records.reserve(verdicts.size());
+    for (size_t i = 0; i < verdicts.size(); ++i) {
+        records.push_back({actions[i].agent_id, verdicts[i].hallucination_risk, verdicts[i].allowed});
+    }
+    AgentRegistry::getInstance().recordActions(records);
+    
+    for (const auto& verdict : verdicts) {
+        result.push_back(verdictToJson(verdict));
+    }
     return result.dump();
 }
 
@@ -225,6 +365,7 @@ std::string ApiHandlers::handleSessionStart(const nlohmann::json& body) {
     
     std::string session_id = body.value("session_id", "");
     std::string agent_name = body.value("agent_name", "");
+    std::string agent_id = body.value("agent_id", "");  // "" — сессия по умолчанию
     
     if (session_id.empty()) {
         session_id = "session_" + std::to_string(time(nullptr));
@@ -233,18 +374,18 @@ std::string ApiHandlers::handleSessionStart(const nlohmann::json& body) {
         agent_name = "unknown";
     }
     
-    auditor_->startSession(session_id, agent_name);
+    auditor_->startSession(session_id, agent_name, agent_id);
     std::cout << "[API] Session started: " << session_id << std::endl;
     
     return R"({"status":"ok"})";
 }
 
-std::string ApiHandlers::handleSessionEnd() {
+std::string ApiHandlers::handleSessionEnd(const nlohmann::json& body) {
     if (!auditor_) {
         return R"({"status":"error","reason":"Auditor not available"})";
     }
     
-    auditor_->endSession();
+    auditor_->endSession(agentIdOf(body));
     std::cout << "[API] Session ended" << std::endl;
     
     return R"({"status":"ok"})";
@@ -255,18 +396,20 @@ std::string ApiHandlers::handleSaveState() {
         return R"({"status":"error","reason":"Auditor not available"})";
     }
     
-    auditor_->saveMemoryState();
+    if (!auditor_->saveMemoryState()) {
+        return R"({"status":"error","reason":"Memory state not saved"})";
+    }
     std::cout << "[API] State saved" << std::endl;
     
     return R"({"status":"ok"})";
 }
 
-std::string ApiHandlers::handleResetRisk() {
+std::string ApiHandlers::handleResetRisk(const nlohmann::json& body) {
     if (!auditor_) {
         return R"({"status":"error","reason":"Auditor not available"})";
     }
     
-    auditor_->resetRiskAccumulator();
+    auditor_->resetRiskAccumulator(agentIdOf(body));
     std::cout << "[API] Risk reset" << std::endl;
     
     return R"({"status":"ok"})";
@@ -278,7 +421,13 @@ std::string ApiHandlers::handleAuditorToggle(const nlohmann::json& body) {
     }
     
     bool enabled = body.value("enabled", true);
-    nfs_->setEnergyAuditEnabled(enabled);
+    const bool applied = modifyField([enabled](NeuralFieldSystem& nfs) {
+        nfs.setEnergyAuditEnabled(enabled);
+        nfs.publishSnapshot();
+    });
+    if (!applied) {
+        return FIELD_QUEUE_FULL;
+    }
     std::cout << "[API] Energy audit " << (enabled ? "enabled" : "disabled") << std::endl;
     
     return R"({"status":"ok"})";
@@ -289,7 +438,13 @@ std::string ApiHandlers::handleAuditorReset() {
         return R"({"status":"error","reason":"NFS not available"})";
     }
     
-    nfs_->getLagrangianAuditorNonConst().reset();
+    const bool applied = modifyField([](NeuralFieldSystem& nfs) {
+        nfs.getLagrangianAuditorNonConst().reset();
+        nfs.publishSnapshot();
+    });
+    if (!applied) {
+        return FIELD_QUEUE_FULL;
+    }
     std::cout << "[API] Auditor reset" << std::endl;
     
     return R"({"status":"ok"})";
@@ -300,12 +455,19 @@ std::string ApiHandlers::handleAuditorConfigSave(const nlohmann::json& body) {
         return R"({"status":"error","reason":"NFS not available"})";
     }
     
-    auto& config = nfs_->getLagrangianAuditorNonConst().getConfigNonConst();
-    config.energy_conservation_threshold = body.value("energy_threshold", 0.05);
-    config.momentum_conservation_threshold = body.value("momentum_threshold", 0.10);
-    config.action_threshold = body.value("action_threshold", 0.15);
-    config.auto_correct = body.value("auto_correct", true);
-    config.correction_strength = body.value("correction_strength", 0.1);
+    LagrangianAuditorConfig update = nfs_->getPublishedSnapshot()->audit_config;
+    update.energy_conservation_threshold = body.value("energy_threshold", 0.05);
+    update.momentum_conservation_threshold = body.value("momentum_threshold", 0.10);
+    update.action_threshold = body.value("action_threshold", 0.15);
+    update.auto_correct = body.value("auto_correct", true);
+    update.correction_strength = body.value("correction_strength", 0.1);
+    const bool applied = modifyField([update](NeuralFieldSystem& nfs) {
+        nfs.getLagrangianAuditorNonConst().setConfig(update);
+        nfs.publishSnapshot();
+    });
+    if (!applied) {
+        return FIELD_QUEUE_FULL;
+    }
     
     std::cout << "[API] Auditor config saved" << std::endl;
     
@@ -358,6 +520,10 @@ std::string ApiHandlers::handleStats(const std::string& period) {
     if (!auditor_) {
         return "{}";
     }
+    std::chrono::seconds window;
+    if (!AuditRollups::parsePeriod(period, window)) {
+        return R"({"error":"unknown period, expected 5h/12h/24h/week/month/year or <N>m/h/d/w"})";
+    }
     auto stats = auditor_->getLogger().getStatsForPeriod(period);
     nlohmann::json j = stats.toJson();
     return j.dump();
@@ -367,11 +533,14 @@ std::string ApiHandlers::handleMetrics() {
     if (!nfs_) {
         return "{}";
     }
-    auto snap = nfs_->getSystemSnapshot();
-    auto j = snap.toJson();
+    auto j = nfs_->getPublishedSnapshot()->toJson();
+    if (sim_) {
+        j["simulation"] = sim_->stats().toJson();
+    }
     if (auditor_) {
-        j["constraints"] = auditor_->getConstraintsStatus();
-        auto last = auditor_->getLastActionInfo();
+        auto status = auditor_->getStatusSnapshot();
+        j["constraints"] = status->constraints;
+        const auto& last = status->last_action;
         j["last_action"] = {
             {"action", last.action},
             {"risk", last.risk},
@@ -381,20 +550,45 @@ std::string ApiHandlers::handleMetrics() {
     return j.dump();
 }
 
+std::string ApiHandlers::handleSimulation() {
+    if (!sim_) {
+        return R"({"running":false})";
+    }
+    nlohmann::json j = sim_->stats().toJson();
+    j["running"] = sim_->isRunning();
+    j["coalesce_threshold"] = sim_->config().coalesce_threshold;
+    if (auditor_) j["dropped_feedback"] = auditor_->getDroppedFeedback();
+    return j.dump();
+}
+
+std::string ApiHandlers::handleRawLog() {
+    if (!auditor_) {
+        return "{}";
+    }
+    const auto& logger = auditor_->getLogger();
+    nlohmann::json j = logger.getRawLogStats().toJson();
+    const auto config = logger.getConfig();
+    j["fsync"] = AggregatedLogger::Config::toString(config.fsync);
+    j["commit_interval_ms"] = config.commit_interval_ms;
+    j["segment_bytes"] = config.segment_bytes;
+    return j.dump();
+}
+
 nlohmann::json ApiHandlers::getEventData() {
     nlohmann::json event;
     
+    // Читаются только опубликованные снимки: SSE-поток не ждёт ни мост, ни шаг поля
     if (auditor_) {
-        auto& session = auditor_->getCurrentSession();
+        auto status = auditor_->getStatusSnapshot();
         event["type"] = "status";
-        event["total_steps"] = session.total_steps;
-        event["risk"] = auditor_->getCurrentHallucinationRisk();
-        event["entropy"] = auditor_->getCurrentEntropy();
-        event["successful_actions"] = session.successful_actions;
-        event["blocked_actions"] = session.blocked_actions;
-        event["accumulated_risk"] = session.accumulated_risk;
+        event["total_steps"] = status->total_steps;
+        event["risk"] = status->risk;
+        event["entropy"] = status->entropy;
+        event["successful_actions"] = status->successful_actions;
+        event["blocked_actions"] = status->blocked_actions;
+        event["accumulated_risk"] = status->accumulated_risk;
         
-        auto last = auditor_->getLastActionInfo();
+        const auto& last = status->last_action;
         event["last_action"] = {
             {"action", last.action},
             {"risk", last.risk},
@@ -403,17 +597,16 @@ nlohmann::json ApiHandlers::getEventData() {
     }
     
     if (nfs_) {
-        event["energy_error"] = nfs_->getLagrangianAuditor().getEnergyError();
-        event["violations"] = nfs_->getLagrangianAuditor().getConservationViolations();
-        event["audit_enabled"] = nfs_->isEnergyAuditEnabled();
-        event["energy"] = nfs_->getLagrangianAuditor().getReferenceEnergy();
-        
-        auto snap = nfs_->getSystemSnapshot();
-        event["entropy"] = snap.entropy;
-        event["quality"] = snap.quality;
-        event["temperature"] = snap.temperature;
-        event["stm_size"] = snap.stm_size;
-        event["ltm_size"] = snap.ltm_size;
+        auto snap = nfs_->getPublishedSnapshot();
+        event["energy_error"] = snap->energy_error;
+        event["violations"] = snap->violations;
+        event["audit_enabled"] = snap->audit_enabled;
+        event["energy"] = snap->energy;
+        event["entropy"] = snap->entropy;
+        event["quality"] = snap->quality;
+        event["temperature"] = snap->temperature;
+        event["stm_size"] = snap->stm_size;
+        event["ltm_size"] = snap->ltm_size;
     }
     
     return event;
@@ -2,15 +2,20 @@
 #pragma once
 
 #include <string>
+#include <functional>
 #include <nlohmann/json.hpp>
 
 class NeuralFieldSystem;
 class AgentAuditBridge;
+class SimulationLoop;
 
 class ApiHandlers {
 public:
     ApiHandlers(NeuralFieldSystem* nfs, AgentAuditBridge* auditor, const std::string& workspace);
     
+    // Поток-владелец поля: изменения поля идут командами, метрики очереди — в /api/simulation
+    void setSimulationLoop(SimulationLoop* loop) { sim_ = loop; }
+    
     // GET handlers
     std::string handleStatus();
     std::string handleConstraints();
@@ -21,16 +26,20 @@ public:
     std::string handleLastAction();
     std::string handleStats(const std::string& period);
     std::string handleMetrics();
+    std::string handleSimulation();
+    std::string handleRawLog();
     
     // POST handlers
     std::string handleRegisterAgent(const nlohmann::json& body);
     std::string handleHeartbeat(const nlohmann::json& body);
     std::string handleAuditAction(const nlohmann::json& body);
+    // Пакет действий: массив вердиктов в порядке запроса
+    std::string handleAuditActions(const nlohmann::json& body);
     std::string handleConstraintToggle(const nlohmann::json& body);
     std::string handleSessionStart(const nlohmann::json& body);
-    std::string handleSessionEnd();
+    std::string handleSessionEnd(const nlohmann::json& body);
     std::string handleSaveState();
-    std::string handleResetRisk();
+    std::string handleResetRisk(const nlohmann::json& body);
     std::string handleAuditorToggle(const nlohmann::json& body);
     std::string handleAuditorReset();
     std::string handleAuditorConfigSave(const nlohmann::json& body);
@@ -45,4 +54,8 @@ private:
     NeuralFieldSystem* nfs_;
     AgentAuditBridge* auditor_;
     std::string workspace_;
+    SimulationLoop* sim_ = nullptr;
+    
+    // Изменение поля: командой в поток поля, если он есть, иначе сразу
+    bool modifyField(std::function<void(NeuralFieldSystem&)> fn);
 };
\ No newline at end of file
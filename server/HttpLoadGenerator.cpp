@@ -0,0 +1,148 @@
+// server/HttpLoadGenerator.cpp
+#include "HttpLoadGenerator.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+namespace {
+    int connectTo(const std::string& host, int port) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            close(fd);
+            return -1;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        return fd;
+    }
+
+    bool sendAll(int fd, const std::string& data) {
+        size_t pos = 0;
+        while (pos < data.size()) {
+            ssize_t w = send(fd, data.data() + pos, data.size() - pos, MSG_NOSIGNAL);
+            if (w <= 0) return false;
+            pos += static_cast<size_t>(w);
+        }
+        return true;
+    }
+
+    // Один ответ из начала buffer (дочитывает из сокета); false — ошибка или обрыв.
+    // eof — сервер закрыл соединение после ответа
+    bool readResponse(int fd, std::string& buffer, bool& eof) {
+        char chunk[16384];
+        size_t header_end;
+        while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t r = recv(fd, chunk, sizeof(chunk), 0);
+            if (r <= 0) return false;
+            buffer.append(chunk, static_cast<size_t>(r));
+        }
+        if (buffer.compare(0, 12, "HTTP/1.1 200") != 0 && buffer.compare(0, 12, "HTTP/1.0 200") != 0) {
+            return false;
+        }
+
+        std::string head = buffer.substr(0, header_end);
+        std::transform(head.begin(), head.end(), head.begin(), [](unsigned char c) { return std::tolower(c); });
+        size_t cl = head.find("\r\ncontent-length:");
+        if (cl == std::string::npos) {
+            // Без длины — ответ до закрытия соединения
+            for (;;) {
+                ssize_t r = recv(fd, chunk, sizeof(chunk), 0);
+                if (r < 0) return false;
+                if (r == 0) break;
+            }
+            buffer.clear();
+            eof = true;
+            return true;
+        }
+
+        const size_t total = header_end + 4 + std::strtoull(head.c_str() + cl + 17, nullptr, 10);
+        while (buffer.size() < total) {
+            ssize_t r = recv(fd, chunk, sizeof(chunk), 0);
+            if (r <= 0) return false;
+            buffer.append(chunk, static_cast<size_t>(r));
+        }
+        buffer.erase(0, total);
+        return true;
+    }
+}
+
+HttpLoadResult runHttpLoad(const std::string& host, int port, const HttpLoadOptions& options) {
+    using clock = std::chrono::steady_clock;
+    const int connections = std::max(1, options.connections);
+    const int per_connection = std::max(1, options.requests / connections);
+    const int depth = options.mode == HttpLoadOptions::PIPELINE ? std::max(1, options.pipeline_depth) : 1;
+
+    const std::string request = "GET " + options.path + " HTTP/1.1\r\nHost: " + host +
+        (options.mode == HttpLoadOptions::CLOSE ? "\r\nConnection: close" : "") + "\r\n\r\n";
+    std::string batch;
+    for (int i = 0; i < depth; ++i) batch += request;
+
+    std::atomic<uint64_t> ok{0}, errors{0};
+    std::vector<std::vector<double>> latencies(connections);
+    std::vector<std::thread> clients;
+
+    auto t0 = clock::now();
+    for (int c = 0; c < connections; ++c) {
+        clients.emplace_back([&, c]() {
+            auto& lat = latencies[c];
+            lat.reserve(per_connection / depth + 1);
+            std::string buffer;
+            int fd = -1;
+            for (int done = 0; done < per_connection; done += depth) {
+                if (fd < 0) {
+                    fd = connectTo(host, port);
+                    buffer.clear();
+                    if (fd < 0) {
+                        errors += depth;
+                        continue;
+                    }
+                }
+                auto start = clock::now();
+                bool good = sendAll(fd, depth > 1 ? batch : request);
+                int received = 0;
+                bool eof = false;
+                while (good && !eof && received < depth && readResponse(fd, buffer, eof)) ++received;
+                lat.push_back(std::chrono::duration<double, std::micro>(clock::now() - start).count());
+                ok += received;
+                errors += depth - received;
+
+                if (eof || received < depth || options.mode == HttpLoadOptions::CLOSE) {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+            if (fd >= 0) close(fd);
+        });
+    }
+    for (auto& t : clients) t.join();
+    auto t1 = clock::now();
+
+    std::vector<double> all;
+    for (auto& lat : latencies) all.insert(all.end(), lat.begin(), lat.end());
+    std::sort(all.begin(), all.end());
+
+    HttpLoadResult result;
+    result.ok = ok.load();
+    result.errors = errors.load();
+    result.seconds = std::chrono::duration<double>(t1 - t0).count();
+    result.requests_per_sec = result.seconds > 0 ? result.ok / result.seconds : 0.0;
+    if (!all.empty()) {
+        result.p50_us = all[all.size() / 2];
+        result.p99_us = all[std::min(all.size() - 1, all.size() * 99 / 100)];
+    }
+    return result;
+}
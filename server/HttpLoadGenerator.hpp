@@ -0,0 +1,44 @@
+// server/HttpLoadGenerator.hpp
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+/**
+ * @struct HttpLoadOptions
+ * @brief Параметры локальной нагрузки на HTTP-сервер (--http-bench)
+ */
+struct HttpLoadOptions {
+    enum Mode {
+        CLOSE,       // новое соединение на каждый запрос (Connection: close)
+        KEEP_ALIVE,  // запросы по очереди в постоянных соединениях
+        PIPELINE     // пачка из pipeline_depth запросов, затем все ответы
+    };
+
+    Mode mode = KEEP_ALIVE;
+    int connections = 16;
+    int requests = 10000;        // всего по всем соединениям
+    int pipeline_depth = 8;
+    std::string path = "/api/metrics";
+
+    static const char* toString(Mode m) {
+        switch (m) {
+            case CLOSE:      return "close";
+            case KEEP_ALIVE: return "keep-alive";
+            case PIPELINE:   return "pipeline";
+            default:         return "unknown";
+        }
+    }
+};
+
+struct HttpLoadResult {
+    uint64_t ok = 0;
+    uint64_t errors = 0;
+    double seconds = 0.0;
+    double requests_per_sec = 0.0;
+    double p50_us = 0.0;         // задержка ответа (для PIPELINE — пачки)
+    double p99_us = 0.0;
+};
+
+// Блокирующие клиенты, по потоку на соединение; ответ — по Content-Length или до EOF
+HttpLoadResult runHttpLoad(const std::string& host, int port, const HttpLoadOptions& options);
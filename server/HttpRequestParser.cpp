@@ -0,0 +1,456 @@
+// server/HttpRequestParser.cpp
+#include "HttpRequestParser.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+    constexpr size_t MAX_CHUNK_LINE = 1024;
+    constexpr size_t COMPACT_THRESHOLD = 64 * 1024;
+
+    char lower(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    bool iequals(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (lower(a[i]) != lower(b[i])) return false;
+        }
+        return true;
+    }
+
+    std::string_view trim(std::string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+        return s;
+    }
+
+    // tchar из RFC 7230
+    bool isToken(std::string_view s) {
+        if (s.empty()) return false;
+        for (char c : s) {
+            if (std::isalnum(static_cast<unsigned char>(c))) continue;
+            if (c == '\0' || !std::strchr("!#$%&'*+-.^_`|~", c)) return false;
+        }
+        return true;
+    }
+
+    // Есть ли token в списке через запятую ("keep-alive, Upgrade")
+    bool hasToken(std::string_view list, std::string_view token) {
+        while (!list.empty()) {
+            size_t comma = list.find(',');
+            if (iequals(trim(list.substr(0, comma)), token)) return true;
+            if (comma == std::string_view::npos) break;
+            list.remove_prefix(comma + 1);
+        }
+        return false;
+    }
+
+    // Только цифры основания base, без знака и пробелов; false при переполнении
+    bool parseSize(std::string_view s, int base, size_t& out) {
+        if (s.empty() || s.size() > 16) return false;
+        size_t value = 0;
+        for (char c : s) {
+            int digit;
+            if (c >= '0' && c <= '9') digit = c - '0';
+            else if (base == 16 && lower(c) >= 'a' && lower(c) <= 'f') digit = lower(c) - 'a' + 10;
+            else return false;
+            if (value > (SIZE_MAX - digit) / base) return false;
+            value = value * base + digit;
+        }
+        out = value;
+        return true;
+    }
+}
+
+std::string_view HttpRequest::header(std::string_view name) const {
+    for (const auto& h : headers_) {
+        if (iequals(view(h.name), name)) return view(h.value);
+    }
+    return {};
+}
+
+bool HttpRequest::hasHeader(std::string_view name) const {
+    for (const auto& h : headers_) {
+        if (iequals(view(h.name), name)) return true;
+    }
+    return false;
+}
+
+void HttpRequestParser::feed(const char* data, size_t size) {
+    buffer_.append(data, size);
+}
+
+bool HttpRequestParser::takeContinue() {
+    bool pending = continue_pending_;
+    continue_pending_ = false;
+    return pending;
+}
+
+HttpRequestParser::Result HttpRequestParser::fail(const char* status) {
+    state_ = FAILED;
+    error_status_ = status;
+    continue_pending_ = false;
+    return ERROR;
+}
+
+void HttpRequestParser::compact() {
+    if (pos_ == buffer_.size()) {
+        buffer_.clear();
+        pos_ = scanned_ = 0;
+        return;
+    }
+    // Сдвиг только когда разобранная часть заметна, иначе сдвигали бы на каждом next()
+    if (pos_ >= COMPACT_THRESHOLD && pos_ * 2 >= buffer_.size()) {
+        buffer_.erase(0, pos_);
+        scanned_ -= std::min(scanned_, pos_);
+        pos_ = 0;
+    }
+}
+
+HttpRequestParser::Result HttpRequestParser::next(HttpRequest& request) {
+    for (;;) {
+        std::string_view data(buffer_);
+        data.remove_prefix(pos_);
+
+        switch (state_) {
+            case FAILED:
+                return ERROR;
+
+            case HEAD: {
+                // Пустые строки перед запросом допускаются (RFC 7230, 3.5)
+                while (data.size() >= 2 && data[0] == '\r' && data[1] == '\n') {
+                    pos_ += 2;
+                    data.remove_prefix(2);
+                }
+                const size_t from = scanned_ > pos_ + 3 ? scanned_ - pos_ - 3 : 0;
+                const size_t end = data.find("\r\n\r\n", from);
+                if (end == std::string_view::npos) {
+                    scanned_ = buffer_.size();
+                    if (data.size() > limits_.max_header_bytes) {
+                        return fail("431 Request Header Fields Too Large");
+                    }
+                    compact();
+                    return NEED_MORE;
+                }
+                if (end + 4 > limits_.max_header_bytes) {
+                    return fail("431 Request Header Fields Too Large");
+                }
+                if (parseHead(data.substr(0, end + 2)) == ERROR) return ERROR;
+                pos_ += end + 4;
+                scanned_ = pos_;
+                // Тело уже пришло вместе с заголовками — "100 Continue" не нужен
+                if (buffered() > 0) continue_pending_ = false;
+                break;
+            }
+
+            case BODY: {
+                if (data.size() < content_length_) {
+                    compact();
+                    return NEED_MORE;
+                }
+                current_.body_.assign(data.data(), content_length_);
+                pos_ += content_length_;
+                request = std::move(current_);
+                current_ = HttpRequest();
+                state_ = HEAD;
+                scanned_ = pos_;
+                compact();
+                return REQUEST_READY;
+            }
+
+            case CHUNK_SIZE: {
+                const size_t eol = data.find("\r\n");
+                if (eol == std::string_view::npos) {
+                    if (data.size() > MAX_CHUNK_LINE) return fail("400 Bad Request");
+                    compact();
+                    return NEED_MORE;
+                }
+                // Расширения чанка (";name=value") пропускаются
+                std::string_view line = trim(data.substr(0, std::min(eol, data.find(';'))));
+                size_t size = 0;
+                if (!parseSize(line, 16, size)) return fail("400 Bad Request");
+                pos_ += eol + 2;
+                if (size > limits_.max_body_bytes - current_.body_.size()) {
+                    return fail("413 Payload Too Large");
+                }
+                if (size == 0) {
+                    trailer_bytes_ = 0;
+                    state_ = TRAILERS;
+                } else {
+                    chunk_remaining_ = size;
+                    state_ = CHUNK_DATA;
+                }
+                break;
+            }
+
+            case CHUNK_DATA: {
+                if (chunk_remaining_ > 0) {
+                    const size_t take = std::min(chunk_remaining_, data.size());
+                    current_.body_.append(data.data(), take);
+                    pos_ += take;
+                    chunk_remaining_ -= take;
+                    if (chunk_remaining_ > 0) {
+                        compact();
+                        return NEED_MORE;
+                    }
+                    data.remove_prefix(take);
+                }
+                if (data.size() < 2) {
+                    compact();
+                    return NEED_MORE;
+                }
+                if (data[0] != '\r' || data[1] != '\n') return fail("400 Bad Request");
+                pos_ += 2;
+                state_ = CHUNK_SIZE;
+                break;
+            }
+
+            case TRAILERS: {
+                const size_t eol = data.find("\r\n");
+                if (eol == std::string_view::npos) {
+                    if (trailer_bytes_ + data.size() > limits_.max_header_bytes) {
+                        return fail("431 Request Header Fields Too Large");
+                    }
+                    compact();
+                    return NEED_MORE;
+                }
+                pos_ += eol + 2;
+                trailer_bytes_ += eol + 2;
+                if (trailer_bytes_ > limits_.max_header_bytes) {
+                    return fail("431 Request Header Fields Too Large");
+                }
+                if (eol == 0) {
+                    request = std::move(current_);
+                    current_ = HttpRequest();
+                    state_ = HEAD;
+                    scanned_ = pos_;
+                    compact();
+                    return REQUEST_READY;
+                }
+                break;  // строка трейлера не используется
+            }
+        }
+    }
+}
+
+HttpRequestParser::Result HttpRequestParser::parseHead(std::string_view head) {
+    current_ = HttpRequest();
+    current_.head_.assign(head.data(), head.size());
+    const std::string_view h(current_.head_);
+    auto span = [&h](std::string_view part) {
+        return HttpRequest::Span{static_cast<uint32_t>(part.data() - h.data()),
+                                 static_cast<uint32_t>(part.size())};
+    };
+
+    // Стартовая строка: METHOD SP target SP HTTP/x.y
+    size_t eol = h.find("\r\n");
+    const std::string_view line = h.substr(0, eol);
+    const size_t sp1 = line.find(' ');
+    const size_t sp2 = sp1 == std::string_view::npos ? sp1 : line.find(' ', sp1 + 1);
+    if (sp2 == std::string_view::npos) return fail("400 Bad Request");
+    const std::string_view method = line.substr(0, sp1);
+    const std::string_view target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    const std::string_view version = line.substr(sp2 + 1);
+    if (!isToken(method) || target.empty()) return fail("400 Bad Request");
+    if (version != "HTTP/1.1" && version != "HTTP/1.0") {
+        return fail(version.substr(0, 5) == "HTTP/" ? "505 HTTP Version Not Supported" : "400 Bad Request");
+    }
+    current_.method_ = span(method);
+    current_.path_ = span(target);
+    current_.version_ = span(version);
+
+    // Заголовки; перенос строки внутри значения (obs-fold) не принимается
+    size_t pos = eol + 2;
+    while (pos < h.size()) {
+        eol = h.find("\r\n", pos);
+        const std::string_view field = h.substr(pos, eol - pos);
+        const size_t colon = field.find(':');
+        if (colon == std::string_view::npos || !isToken(field.substr(0, colon))) {
+            return fail("400 Bad Request");
+        }
+        current_.headers_.push_back({span(field.substr(0, colon)), span(trim(field.substr(colon + 1)))});
+        pos = eol + 2;
+    }
+
+    // Длина тела: chunked или Content-Length, но не оба сразу
+    content_length_ = 0;
+    const bool has_te = current_.hasHeader("transfer-encoding");
+    const bool has_cl = current_.hasHeader("content-length");
+    if (has_te) {
+        if (has_cl) return fail("400 Bad Request");
+        if (!iequals(trim(current_.header("transfer-encoding")), "chunked")) {
+            return fail("501 Not Implemented");
+        }
+        current_.chunked_ = true;
+        state_ = CHUNK_SIZE;
+    } else {
+        bool seen = false;
+        for (const auto& hdr : current_.headers_) {
+            if (!iequals(current_.view(hdr.name), "content-length")) continue;
+            size_t length = 0;
+            if (!parseSize(current_.view(hdr.value), 10, length)) return fail("400 Bad Request");
+            if (seen && length != content_length_) return fail("400 Bad Request");
+            content_length_ = length;
+            seen = true;
+        }
+        if (content_length_ > limits_.max_body_bytes) return fail("413 Payload Too Large");
+        state_ = BODY;
+    }
+
+    const std::string_view connection = current_.header("connection");
+    current_.keep_alive_ = (version == "HTTP/1.1") ? !hasToken(connection, "close")
+                                                   : hasToken(connection, "keep-alive");
+
+    continue_pending_ = version == "HTTP/1.1" && (current_.chunked_ || content_length_ > 0) &&
+                        iequals(trim(current_.header("expect")), "100-continue");
+    return NEED_MORE;
+}
+
+// ============================================================================
+// САМОПРОВЕРКА
+// ============================================================================
+
+namespace {
+    // Разбор потока кусками по границам cuts: описание каждого запроса и итог
+    // ("ERROR <статус>" или "NEED_MORE <непрочитано>")
+    std::vector<std::string> parseFeed(std::string_view wire, const std::vector<size_t>& cuts,
+                                       HttpRequestParser::Limits limits) {
+        HttpRequestParser parser(limits);
+        std::vector<std::string> out;
+        bool failed = false;
+        auto drain = [&]() {
+            HttpRequest req;
+            HttpRequestParser::Result r;
+            while ((r = parser.next(req)) == HttpRequestParser::REQUEST_READY) {
+                std::string d(req.method());
+                d += ' ';
+                d += req.path();
+                d += ' ';
+                d += req.version();
+                d += req.keepAlive() ? " keep-alive" : " close";
+                d += req.chunked() ? " chunked" : "";
+                d += " x=";
+                d += req.header("x-check");
+                d += " body=";
+                d += req.body();
+                out.push_back(std::move(d));
+            }
+            if (r == HttpRequestParser::ERROR && !failed) {
+                out.push_back(std::string("ERROR ") + parser.errorStatus());
+                failed = true;
+            }
+        };
+        size_t from = 0;
+        for (size_t cut : cuts) {
+            parser.feed(wire.data() + from, cut - from);
+            drain();
+            from = cut;
+        }
+        parser.feed(wire.data() + from, wire.size() - from);
+        drain();
+        if (!failed) out.push_back("NEED_MORE " + std::to_string(parser.buffered()));
+        return out;
+    }
+}
+
+bool HttpRequestParser::selfCheck(std::vector<std::string>* failures) {
+    struct Case {
+        const char* name;
+        std::string wire;
+        std::vector<std::string> expected;
+        Limits limits;
+    };
+    Limits small;
+    small.max_header_bytes = 256;
+    small.max_body_bytes = 16;
+
+    const std::vector<Case> cases = {
+        {"pipeline",
+         "\r\nGET /api/metrics HTTP/1.1\r\nHost: a\r\nX-Check: one\r\n\r\n"
+         "POST /api/audit/action HTTP/1.1\r\nContent-Length: 11\r\ncontent-length: 11\r\n\r\nhello world"
+         "POST /api/audit/actions HTTP/1.1\r\nTransfer-Encoding: chunked\r\nX-Check:  two \r\n\r\n"
+         "5;ext=1\r\nhello\r\n6 ; name=\"v\"\r\n world\r\n0\r\nX-Trailer: t\r\nX-Other: u\r\n\r\n"
+         "GET /status HTTP/1.0\r\nConnection: keep-alive\r\n\r\n"
+         "GET /bye HTTP/1.1\r\nConnection: keep-alive, close\r\n\r\n"
+         "GET /partial HTTP/1.1\r\nHo",
+         {"GET /api/metrics HTTP/1.1 keep-alive x=one body=",
+          "POST /api/audit/action HTTP/1.1 keep-alive x= body=hello world",
+          "POST /api/audit/actions HTTP/1.1 keep-alive chunked x=two body=hello world",
+          "GET /status HTTP/1.0 keep-alive x= body=",
+          "GET /bye HTTP/1.1 close x= body=",
+          "NEED_MORE 25"},
+         Limits{}},
+        {"chunked at body limit",
+         "POST /c HTTP/1.1\r\nTransfer-Encoding: Chunked\r\n\r\n8\r\n01234567\r\n8\r\n89abcdef\r\n0\r\n\r\n",
+         {"POST /c HTTP/1.1 keep-alive chunked x= body=0123456789abcdef", "NEED_MORE 0"}, small},
+        {"content-length with transfer-encoding",
+         "POST /x HTTP/1.1\r\nContent-Length: 3\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n0\r\n\r\n",
+         {"ERROR 400 Bad Request"}, Limits{}},
+        {"conflicting content-length",
+         "POST /x HTTP/1.1\r\nContent-Length: 3\r\nContent-Length: 4\r\n\r\nabcd",
+         {"ERROR 400 Bad Request"}, Limits{}},
+        {"signed content-length",
+         "POST /x HTTP/1.1\r\nContent-Length: +3\r\n\r\nabc",
+         {"ERROR 400 Bad Request"}, Limits{}},
+        {"header without colon",
+         "GET /x HTTP/1.1\r\nHost a\r\n\r\n",
+         {"ERROR 400 Bad Request"}, Limits{}},
+        {"bad request line",
+         "GET/x HTTP/1.1\r\n\r\n",
+         {"ERROR 400 Bad Request"}, Limits{}},
+        {"bad chunk size",
+         "POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n",
+         {"ERROR 400 Bad Request"}, Limits{}},
+        {"chunk without crlf",
+         "POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabcX\r\n",
+         {"ERROR 400 Bad Request"}, Limits{}},
+        {"unsupported transfer-encoding",
+         "POST /x HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n",
+         {"ERROR 501 Not Implemented"}, Limits{}},
+        {"unsupported version",
+         "GET /x HTTP/2.0\r\n\r\n",
+         {"ERROR 505 HTTP Version Not Supported"}, Limits{}},
+        {"content-length over limit",
+         "POST /x HTTP/1.1\r\nContent-Length: 17\r\n\r\n",
+         {"ERROR 413 Payload Too Large"}, small},
+        {"chunked body over limit",
+         "POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n8\r\n01234567\r\n9\r\n",
+         {"ERROR 413 Payload Too Large"}, small},
+        {"header over limit",
+         "GET /x HTTP/1.1\r\nX-Long: " + std::string(300, 'a') + "\r\n\r\n",
+         {"ERROR 431 Request Header Fields Too Large"}, small},
+        {"unterminated header over limit",
+         "GET /x HTTP/1.1\r\nX-Long: " + std::string(300, 'a'),
+         {"ERROR 431 Request Header Fields Too Large"}, small},
+        {"trailers over limit",
+         "POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n0\r\nX-T: " + std::string(300, 'b') + "\r\n\r\n",
+         {"ERROR 431 Request Header Fields Too Large"}, small},
+    };
+
+    bool ok = true;
+    auto mismatch = [&](const Case& c, const std::string& how) {
+        ok = false;
+        if (failures) failures->push_back(std::string(c.name) + " (" + how + ")");
+    };
+    for (const Case& c : cases) {
+        if (parseFeed(c.wire, {}, c.limits) != c.expected) {
+            mismatch(c, "whole");
+            continue;
+        }
+        // Один разрез в каждой позиции
+        for (size_t cut = 1; cut < c.wire.size(); ++cut) {
+            if (parseFeed(c.wire, {cut}, c.limits) != c.expected) {
+                mismatch(c, "split at " + std::to_string(cut));
+                break;
+            }
+        }
+        // По одному байту
+        std::vector<size_t> bytes;
+        for (size_t cut = 1; cut < c.wire.size(); ++cut) bytes.push_back(cut);
+        if (parseFeed(c.wire, bytes, c.limits) != c.expected) mismatch(c, "byte by byte");
+    }
+    return ok;
+}
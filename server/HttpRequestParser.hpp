@@ -0,0 +1,137 @@
+// server/HttpRequestParser.hpp
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @class HttpRequest
+ * @brief Разобранный запрос: стартовая строка, заголовки и тело
+ *
+ * Стартовая строка и заголовки хранятся одним блоком, как пришли;
+ * поля и заголовки — смещения в нём, отдаются как string_view.
+ */
+class HttpRequest {
+public:
+    std::string_view method() const { return view(method_); }
+    std::string_view path() const { return view(path_); }
+    std::string_view version() const { return view(version_); }
+    std::string_view body() const { return body_; }
+
+    // Значение заголовка без учёта регистра имени; "" — заголовка нет
+    std::string_view header(std::string_view name) const;
+    bool hasHeader(std::string_view name) const;
+    size_t headerCount() const { return headers_.size(); }
+    std::string_view headerName(size_t i) const { return view(headers_[i].name); }
+    std::string_view headerValue(size_t i) const { return view(headers_[i].value); }
+
+    bool keepAlive() const { return keep_alive_; }
+    bool chunked() const { return chunked_; }
+
+private:
+    friend class HttpRequestParser;
+
+    struct Span {
+        uint32_t pos = 0;
+        uint32_t len = 0;
+    };
+    struct Header {
+        Span name;
+        Span value;
+    };
+
+    std::string_view view(Span s) const { return std::string_view(head_).substr(s.pos, s.len); }
+
+    std::string head_;
+    std::string body_;
+    Span method_, path_, version_;
+    std::vector<Header> headers_;
+    bool keep_alive_ = true;
+    bool chunked_ = false;
+};
+
+// --------------------
+// Потоковый разбор HTTP/1.1 запросов
+// --------------------
+/**
+ * @class HttpRequestParser
+ * @brief Разбирает запросы по мере прихода байт из буфера одного соединения
+ *
+ * Логика:
+ * - feed() дописывает принятые байты; next() отдаёт следующий полный запрос
+ *   или NEED_MORE; конвейерные запросы остаются в буфере до следующего next()
+ * - буфер просматривается через string_view; конец заголовков ищется только
+ *   в новых байтах, поэтому медленный клиент не даёт квадратичного пересканирования
+ * - тело — по Content-Length или Transfer-Encoding: chunked (расширения чанков
+ *   и трейлеры пропускаются); одновременно оба заголовка — ошибка
+ * - лимиты заголовков и тела проверяются до чтения тела: Content-Length сверх
+ *   max_body_bytes отклоняется сразу (413)
+ * - после ошибки разбор соединения не продолжается
+ */
+class HttpRequestParser {
+public:
+    struct Limits {
+        size_t max_header_bytes = 64 * 1024;
+        size_t max_body_bytes = 1 << 20;
+    };
+
+    enum Result {
+        NEED_MORE,
+        REQUEST_READY,
+        ERROR
+    };
+
+    HttpRequestParser() = default;
+    explicit HttpRequestParser(Limits limits) : limits_(limits) {}
+
+    void setLimits(Limits limits) { limits_ = limits; }
+    const Limits& limits() const { return limits_; }
+
+    void feed(const char* data, size_t size);
+    Result next(HttpRequest& request);
+
+    // Непрочитанные байты (следующие запросы конвейера)
+    size_t buffered() const { return buffer_.size() - pos_; }
+    bool midRequest() const { return state_ != HEAD || buffered() > 0; }
+
+    // Клиент ждёт "100 Continue" перед телом; флаг сбрасывается при чтении
+    bool takeContinue();
+
+    // Статус ответа на ошибку разбора ("400 Bad Request" и т.п.)
+    const char* errorStatus() const { return error_status_; }
+
+    // Эталонные потоки (конвейер, chunked с расширениями и трейлерами, каждая
+    // ошибка) целиком, с разрезом в каждой позиции и по байту: true, если разбор
+    // везде совпадает с ожидаемым. failures — имена несовпавших случаев
+    static bool selfCheck(std::vector<std::string>* failures = nullptr);
+
+private:
+    enum State {
+        HEAD,
+        BODY,
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        TRAILERS,
+        FAILED
+    };
+
+    Result fail(const char* status);
+    Result parseHead(std::string_view head);
+    void compact();
+
+    Limits limits_;
+    std::string buffer_;
+    size_t pos_ = 0;              // начало неразобранных байт
+    size_t scanned_ = 0;          // до сюда конец заголовков уже искали
+    State state_ = HEAD;
+
+    HttpRequest current_;
+    size_t content_length_ = 0;
+    size_t chunk_remaining_ = 0;
+    size_t trailer_bytes_ = 0;
+    bool continue_pending_ = false;
+    const char* error_status_ = "400 Bad Request";
+};
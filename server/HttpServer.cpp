@@ -5,9 +5,31 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
 #include <cstring>
+#include <cstdlib>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/tcp.h>
+
+namespace {
+    constexpr int EVENT_INTERVAL_MS = 500;          // период SSE
+    constexpr int IDLE_SWEEP_MS = 1000;
+    constexpr size_t READ_CHUNK = 16384;
+    constexpr size_t SSE_MAX_BACKLOG = 1 << 20;     // медленный подписчик отключается
+
+    const char* const SSE_HEADER = "HTTP/1.1 200 OK\r\n"
+                                   "Content-Type: text/event-stream\r\n"
+                                   "Cache-Control: no-cache\r\n"
+                                   "Connection: keep-alive\r\n"
+                                   "Access-Control-Allow-Origin: *\r\n\r\n";
+
+}
 
 HttpServer::HttpServer(int port, const std::string& workspace, NeuralFieldSystem* nfs, AgentAuditBridge* auditor)
     : port_(port), workspace_(workspace), server_fd_(-1), running_(false), nfs_(nfs), auditor_(auditor), running_flag_(nullptr) {
@@ -19,7 +41,7 @@ HttpServer::~HttpServer() {
 }
 
 bool HttpServer::start() {
-    server_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    server_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (server_fd_ < 0) {
         std::cerr << "[HTTP] Failed to create socket" << std::endl;
         return false;
@@ -35,51 +57,421 @@ bool HttpServer::start() {
     
     if (bind(server_fd_, (struct sockaddr*)&address, sizeof(address)) < 0) {
         std::cerr << "[HTTP] Bind failed on port " << port_ << std::endl;
+        close(server_fd_);
+        server_fd_ = -1;
         return false;
     }
     
-    if (listen(server_fd_, 10) < 0) {
+    if (listen(server_fd_, SOMAXCONN) < 0) {
         std::cerr << "[HTTP] Listen failed" << std::endl;
+        close(server_fd_);
+        server_fd_ = -1;
+        return false;
+    }
+    
+    socklen_t len = sizeof(address);
+    if (getsockname(server_fd_, (struct sockaddr*)&address, &len) == 0) {
+        port_ = ntohs(address.sin_port);
+    }
+    
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        std::cerr << "[HTTP] epoll/eventfd failed: " << std::strerror(errno) << std::endl;
+        if (epoll_fd_ >= 0) close(epoll_fd_);
+        if (wake_fd_ >= 0) close(wake_fd_);
+        close(server_fd_);
+        epoll_fd_ = wake_fd_ = server_fd_ = -1;
         return false;
     }
     
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = server_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, server_fd_, &ev);
+    ev.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+    
+    workers_stop_ = false;
+    const int workers = std::max(1, config_.workers);
+    for (int i = 0; i < workers; ++i) {
+        workers_.emplace_back(&HttpServer::workerLoop, this);
+    }
+    
     running_ = true;
     server_thread_ = std::thread(&HttpServer::run, this);
-    std::cout << "[HTTP] Server started on port " << port_ << std::endl;
+    std::cout << "[HTTP] Server started on port " << port_ << " (epoll, "
+              << workers << " workers, max " << config_.max_connections << " connections)" << std::endl;
     return true;
 }
 
 void HttpServer::stop() {
-    if (!running_.load()) return;  // Уже остановлен
-    
-    running_ = false;
+    if (!running_.exchange(false)) return;  // Уже остановлен
     
-    // Принудительно закрываем серверный сокет, чтобы разблокировать accept()
-    if (server_fd_ >= 0) {
-        shutdown(server_fd_, SHUT_RDWR);
-        close(server_fd_);
-        server_fd_ = -1;
+    // Будим поток событий; он закрывает соединения и слушающий сокет
+    if (wake_fd_ >= 0) {
+        uint64_t one = 1;
+        (void)!write(wake_fd_, &one, sizeof(one));
     }
-    
     if (server_thread_.joinable()) {
         server_thread_.join();
     }
+    
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        workers_stop_ = true;
+        jobs_.clear();
+    }
+    jobs_cv_.notify_all();
+    for (auto& w : workers_) {
+        if (w.joinable()) w.join();
+    }
+    workers_.clear();
+    
+    {
+        std::lock_guard<std::mutex> lock(done_mutex_);
+        done_.clear();
+    }
+    if (epoll_fd_ >= 0) close(epoll_fd_);
+    if (wake_fd_ >= 0) close(wake_fd_);
+    epoll_fd_ = wake_fd_ = -1;
+}
+
+HttpServerStats HttpServer::stats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
 }
 
 void HttpServer::run() {
+    using clock = std::chrono::steady_clock;
+    std::vector<epoll_event> events(256);
+    auto next_event = clock::now() + std::chrono::milliseconds(EVENT_INTERVAL_MS);
+    auto next_sweep = clock::now() + std::chrono::milliseconds(IDLE_SWEEP_MS);
+    
     while (running_.load()) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        int client_fd = accept(server_fd_, (struct sockaddr*)&client_addr, &client_len);
-        if (client_fd < 0) {
-            if (running_.load()) {
-                std::cerr << "[HTTP] Accept failed" << std::endl;
+        auto now = clock::now();
+        auto wake_at = std::min(next_event, next_sweep);
+        int timeout = static_cast<int>(std::max<int64_t>(0,
+            std::chrono::duration_cast<std::chrono::milliseconds>(wake_at - now).count()));
+        
+        int n = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[HTTP] epoll_wait failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        
+        for (int i = 0; i < n; ++i) {
+            const int fd = events[i].data.fd;
+            const uint32_t ev = events[i].events;
+            if (fd == server_fd_) {
+                acceptConnections();
+                continue;
+            }
+            if (fd == wake_fd_) {
+                uint64_t value;
+                while (read(wake_fd_, &value, sizeof(value)) > 0) {}
+                continue;
+            }
+            
+            auto it = connections_.find(fd);
+            if (it == connections_.end() || it->second.closed) continue;
+            Connection& conn = it->second;
+            if (ev & EPOLLERR) {
+                markClosed(conn);
+                continue;
+            }
+            if (ev & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) onReadable(conn);
+            if ((ev & EPOLLOUT) && !conn.closed) onWritable(conn);
+        }
+        
+        drainCompletions();
+        
+        now = clock::now();
+        if (now >= next_event) {
+            broadcastEvents();
+            next_event = now + std::chrono::milliseconds(EVENT_INTERVAL_MS);
+        }
+        if (now >= next_sweep) {
+            closeIdle();
+            next_sweep = now + std::chrono::milliseconds(IDLE_SWEEP_MS);
+        }
+        reapClosed();
+        
+        loop_stats_.connections = connections_.size();
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_ = loop_stats_;
+    }
+    
+    for (auto& [fd, conn] : connections_) markClosed(conn);
+    reapClosed();
+    if (server_fd_ >= 0) {
+        close(server_fd_);
+        server_fd_ = -1;
+    }
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    loop_stats_.connections = 0;
+    loop_stats_.sse_clients = 0;
+    stats_ = loop_stats_;
+}
+
+void HttpServer::acceptConnections() {
+    static const std::string unavailable = "HTTP/1.1 503 Service Unavailable\r\n"
+                                           "Content-Length: 0\r\nConnection: close\r\n\r\n";
+    for (;;) {
+        int fd = accept4(server_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK && running_.load()) {
+                std::cerr << "[HTTP] Accept failed: " << std::strerror(errno) << std::endl;
             }
+            return;
+        }
+        
+        if (connections_.size() >= config_.max_connections) {
+            (void)!send(fd, unavailable.data(), unavailable.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+            close(fd);
+            loop_stats_.rejected++;
+            continue;
+        }
+        
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);
+            continue;
+        }
+        
+        Connection& conn = connections_[fd];
+        conn = Connection{};
+        conn.fd = fd;
+        conn.id = ++next_connection_id_;
+        conn.parser.setLimits({config_.max_header_bytes, config_.max_body_bytes});
+        conn.last_active = std::chrono::steady_clock::now();
+        loop_stats_.accepted++;
+    }
+}
+
+void HttpServer::onReadable(Connection& conn) {
+    char buffer[READ_CHUNK];
+    for (;;) {
+        // Пока запрос у обработчиков, копим не больше одного запроса впрок;
+        // остальное дочитаем после ответа (drainCompletions)
+        if (conn.busy && conn.parser.buffered() >= config_.max_header_bytes + config_.max_body_bytes) break;
+        
+        ssize_t r = recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (r > 0) {
+            if (!conn.close_after_write) conn.parser.feed(buffer, static_cast<size_t>(r));
+            continue;
+        }
+        if (r == 0) {
+            conn.peer_closed = true;
+            break;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        markClosed(conn);
+        return;
+    }
+    conn.last_active = std::chrono::steady_clock::now();
+    processInput(conn);
+}
+
+void HttpServer::onWritable(Connection& conn) {
+    while (conn.out_pos < conn.out.size()) {
+        ssize_t w = send(conn.fd, conn.out.data() + conn.out_pos, conn.out.size() - conn.out_pos, MSG_NOSIGNAL);
+        if (w > 0) {
+            conn.out_pos += static_cast<size_t>(w);
+            continue;
+        }
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;  // дождёмся EPOLLOUT
+        markClosed(conn);
+        return;
+    }
+    conn.out.clear();
+    conn.out_pos = 0;
+    if (conn.close_after_write) markClosed(conn);
+}
+
+void HttpServer::processInput(Connection& conn) {
+    if (conn.closed || conn.busy || conn.close_after_write || conn.sse) return;
+    
+    HttpRequest req;
+    const HttpRequestParser::Result result = conn.parser.next(req);
+    if (conn.parser.takeContinue()) {
+        conn.out += "HTTP/1.1 100 Continue\r\n\r\n";
+        onWritable(conn);
+        if (conn.closed) return;
+    }
+    if (result == HttpRequestParser::ERROR) {
+        loop_stats_.bad_requests++;
+        sendError(conn, conn.parser.errorStatus());
+        return;
+    }
+    if (result == HttpRequestParser::NEED_MORE) {
+        // Клиент закрыл запись, полного запроса уже не будет
+        if (conn.peer_closed) {
+            conn.close_after_write = true;
+            onWritable(conn);
+        }
+        return;
+    }
+    
+    loop_stats_.requests++;
+    if (conn.served > 0) loop_stats_.keepalive_reused++;
+    if (conn.parser.buffered() > 0) loop_stats_.pipelined++;
+    conn.served++;
+    
+    // SSE остаётся в потоке событий: соединение становится подписчиком
+    if (req.method() == "GET" && req.path() == "/api/events") {
+        conn.sse = true;
+        conn.out += SSE_HEADER;
+        loop_stats_.sse_clients++;
+        onWritable(conn);
+        return;
+    }
+    
+    conn.busy = true;
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        jobs_.push_back(Job{conn.fd, conn.id, std::move(req)});
+    }
+    jobs_cv_.notify_one();
+}
+
+void HttpServer::drainCompletions() {
+    std::vector<Completion> done;
+    {
+        std::lock_guard<std::mutex> lock(done_mutex_);
+        done.swap(done_);
+    }
+    for (auto& c : done) {
+        auto it = connections_.find(c.fd);
+        if (it == connections_.end() || it->second.id != c.id || it->second.closed) continue;
+        Connection& conn = it->second;
+        conn.busy = false;
+        conn.out += c.response;
+        if (!c.keep_alive) conn.close_after_write = true;
+        conn.last_active = std::chrono::steady_clock::now();
+        onWritable(conn);
+        // Следующий конвейерный запрос и байты, не прочитанные, пока ждали ответ
+        if (!conn.closed) onReadable(conn);
+    }
+}
+
+void HttpServer::broadcastEvents() {
+    if (loop_stats_.sse_clients == 0) return;
+    
+    const bool shutting_down = running_flag_ && !running_flag_->load();
+    std::string data;
+    if (!shutting_down) {
+        // Данные — из опубликованных снимков, мьютекс не нужен
+        data = "data: " + apiHandlers_->getEventData().dump() + "\n\n";
+    }
+    for (auto& [fd, conn] : connections_) {
+        if (!conn.sse || conn.closed) continue;
+        if (shutting_down || conn.out.size() - conn.out_pos > SSE_MAX_BACKLOG) {
+            markClosed(conn);
             continue;
         }
+        conn.out += data;
+        onWritable(conn);
+    }
+}
+
+void HttpServer::closeIdle() {
+    const auto now = std::chrono::steady_clock::now();
+    const auto limit = std::chrono::milliseconds(config_.idle_timeout_ms);
+    for (auto& [fd, conn] : connections_) {
+        if (conn.closed || conn.busy || conn.sse) continue;
+        if (now - conn.last_active > limit) {
+            loop_stats_.idle_closed++;
+            markClosed(conn);
+        }
+    }
+}
+
+void HttpServer::markClosed(Connection& conn) {
+    if (conn.closed) return;
+    conn.closed = true;
+    closed_.push_back(conn.fd);
+}
+
+void HttpServer::reapClosed() {
+    for (int fd : closed_) {
+        auto it = connections_.find(fd);
+        if (it == connections_.end()) continue;
+        if (it->second.sse && loop_stats_.sse_clients > 0) loop_stats_.sse_clients--;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections_.erase(it);
+    }
+    closed_.clear();
+}
+
+void HttpServer::sendError(Connection& conn, const std::string& status) {
+    std::string response = "HTTP/1.1 " + status + "\r\n\r\n";
+    finalizeResponse(response, false);
+    conn.out += response;
+    conn.close_after_write = true;
+    onWritable(conn);
+}
+
+void HttpServer::workerLoop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobs_mutex_);
+            jobs_cv_.wait(lock, [this]() { return workers_stop_ || !jobs_.empty(); });
+            if (workers_stop_) return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
         
-        std::thread(&HttpServer::handleClient, this, client_fd).detach();
+        Completion done{job.fd, job.id, std::string(), job.request.keepAlive()};
+        try {
+            done.response = handleRequest(job.request);
+        } catch (const std::exception& e) {
+            std::cerr << "[HTTP] Handler error on " << job.request.path() << ": " << e.what() << std::endl;
+            done.response = "HTTP/1.1 500 Internal Server Error\r\n\r\n";
+        }
+        finalizeResponse(done.response, done.keep_alive);
+        
+        {
+            std::lock_guard<std::mutex> lock(done_mutex_);
+            done_.push_back(std::move(done));
+        }
+        uint64_t one = 1;
+        (void)!write(wake_fd_, &one, sizeof(one));
+    }
+}
+
+void HttpServer::finalizeResponse(std::string& response, bool keep_alive) {
+    size_t head_end = response.find("\r\n\r\n");
+    if (head_end == std::string::npos) {
+        head_end = response.size();
+        response += "\r\n\r\n";
+    }
+    const size_t body_len = response.size() - head_end - 4;
+    response.insert(head_end, "\r\nContent-Length: " + std::to_string(body_len) +
+                              "\r\nConnection: " + (keep_alive ? "keep-alive" : "close"));
+}
+
+std::string HttpServer::handleRequest(const HttpRequest& req) {
+    std::string response;
+    if (req.method() == "GET") {
+        handleGetRequest(req, response);
+    } else if (req.method() == "POST") {
+        handlePostRequest(req, response);
+    } else {
+        response = "HTTP/1.1 405 Method Not Allowed\r\n\r\n";
     }
+    return response;
 }
 
 std::string HttpServer::loadHtmlFile(const std::string& path) {
@@ -99,7 +491,12 @@ std::string HttpServer::loadHtmlFile(const std::string& path) {
     return "<html><body><h1>Error</h1><p>Page not found: " + path + "</p></body></html>";
 }
 
-void HttpServer::handleGetRequest(const std::string& path, std::string& response) {
+void HttpServer::setSimulationLoop(SimulationLoop* loop) {
+    apiHandlers_->setSimulationLoop(loop);
+}
+
+void HttpServer::handleGetRequest(const HttpRequest& req, std::string& response) {
+    const std::string path(req.path());
     // HTML страницы
     if (path == "/" || path == "/index.html") {
         response = "HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\n\r\n" + loadHtmlFile("index.html");
@@ -133,7 +530,7 @@ void HttpServer::handleGetRequest(const std::string& path, std::string& response
         response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + apiHandlers_->handleConstraints();
     }
     else if (path == "/api/auditor/status") {
-        std::lock_guard<std::mutex> lock(data_mutex_);
+        // Опубликованный снимок — без data_mutex_, шаг поля не ждём
         response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + apiHandlers_->handleAuditorStatus();
     }
     else if (path == "/api/analytics") {
@@ -151,20 +548,24 @@ void HttpServer::handleGetRequest(const std::string& path, std::string& response
         std::lock_guard<std::mutex> lock(data_mutex_);
         response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + apiHandlers_->handleLastAction();
     }
+    else if (path == "/api/simulation") {
+        // Счётчики очереди поля — свой мьютекс очереди, data_mutex_ не нужен
+        response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + apiHandlers_->handleSimulation();
+    }
+    else if (path == "/api/audit/log") {
+        // Счётчики журнала сырых действий
+        response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + apiHandlers_->handleRawLog();
+    }
+    else if (path == "/api/http") {
+        // Счётчики соединений сервера
+        response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + stats().toJson().dump();
+    }
     else if (path == "/api/metrics") {
-        std::lock_guard<std::mutex> lock(data_mutex_);
+        // Опубликованные снимки поля и моста — без data_mutex_
         response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + apiHandlers_->handleMetrics();
     }
-    else if (path == "/api/events") {
-        response = "HTTP/1.1 200 OK\r\n"
-                   "Content-Type: text/event-stream\r\n"
-                   "Cache-Control: no-cache\r\n"
-                   "Connection: keep-alive\r\n"
-                   "Access-Control-Allow-Origin: *\r\n\r\n";
-        // SSE connection handled separately in handleClient
-    }
     else if (path.find("/api/stats/") == 0) {
-        std::lock_guard<std::mutex> lock(data_mutex_);
+        // Свёртки логгера под его собственным мьютексом
         std::string period = path.substr(11);
         response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + apiHandlers_->handleStats(period);
     }
@@ -173,11 +574,12 @@ void HttpServer::handleGetRequest(const std::string& path, std::string& response
     }
 }
 
-void HttpServer::handlePostRequest(const std::string& path, const std::string& body, std::string& response) {
+void HttpServer::handlePostRequest(const HttpRequest& req, std::string& response) {
+    const std::string path(req.path());
     nlohmann::json json_body;
     try {
-        if (!body.empty()) {
-            json_body = nlohmann::json::parse(body);
+        if (!req.body().empty()) {
+            json_body = nlohmann::json::parse(req.body());
         }
     } catch (...) {
         response = "HTTP/1.1 400 Bad Request\r\n\r\n";
@@ -194,7 +596,7 @@ void HttpServer::handlePostRequest(const std::string& path, const std::string& b
     }
     else if (path == "/api/session/end") {
         std::lock_guard<std::mutex> lock(data_mutex_);
-        response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + apiHandlers_->handleSessionEnd();
+        response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + apiHandlers_->handleSessionEnd(json_body);
     }
     else if (path == "/api/save") {
         std::lock_guard<std::mutex> lock(data_mutex_);
@@ -202,7 +604,7 @@ void HttpServer::handlePostRequest(const std::string& path, const std::string& b
     }
     else if (path == "/api/reset_risk") {
         std::lock_guard<std::mutex> lock(data_mutex_);
-        response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + apiHandlers_->handleResetRisk();
+        response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + apiHandlers_->handleResetRisk(json_body);
     }
     else if (path == "/api/auditor/toggle") {
         std::lock_guard<std::mutex> lock(data_mutex_);
@@ -233,87 +635,14 @@ void HttpServer::handlePostRequest(const std::string& path, const std::string& b
         std::lock_guard<std::mutex> lock(data_mutex_);
         response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + apiHandlers_->handleHeartbeat(json_body);
     }
+    // Аудит без data_mutex_: мост потокобезопасен, агенты проверяются параллельно
     else if (path == "/api/audit/action") {
-        std::lock_guard<std::mutex> lock(data_mutex_);
         response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + apiHandlers_->handleAuditAction(json_body);
     }
+    else if (path == "/api/audit/actions") {
+        response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + apiHandlers_->handleAuditActions(json_body);
+    }
     else {
         response = "HTTP/1.1 404 Not Found\r\n\r\n";
     }
 }
-
-void HttpServer::handleClient(int client_fd) {
-    char buffer[8192] = {0};
-    int bytes_read = read(client_fd, buffer, sizeof(buffer) - 1);
-    
-    if (bytes_read <= 0) {
-        close(client_fd);
-        return;
-    }
-    
-    std::string request(buffer);
-    std::string method, path, version;
-    std::istringstream iss(request);
-    iss >> method >> path >> version;
-    
-    // Извлекаем тело запроса для POST
-    std::string body;
-    size_t body_pos = request.find("\r\n\r\n");
-    if (body_pos != std::string::npos) {
-        body = request.substr(body_pos + 4);
-    }
-    
-    std::string response;
-    
-    // Обработка SSE (Server-Sent Events) - ИСПРАВЛЕНО!
-    if (path == "/api/events") {
-        std::string sse_header = "HTTP/1.1 200 OK\r\n"
-                                 "Content-Type: text/event-stream\r\n"
-                                 "Cache-Control: no-cache\r\n"
-                                 "Connection: keep-alive\r\n"
-                                 "Access-Control-Allow-Origin: *\r\n\r\n";
-        
-        if (send(client_fd, sse_header.c_str(), sse_header.length(), 0) < 0) {
-            close(client_fd);
-            return;
-        }
-        
-        // Отправляем события - используем атомарные проверки
-        int event_counter = 0;
-        while (running_.load()) {
-            // Проверяем внешний флаг атомарно
-            if (running_flag_ && !running_flag_->load()) {
-                break;
-            }
-            
-            // Блокируем мьютекс перед получением данных
-            nlohmann::json event;
-            {
-                std::lock_guard<std::mutex> lock(data_mutex_);
-                event = apiHandlers_->getEventData();
-            }
-            
-            std::string data = "data: " + event.dump() + "\n\n";
-            if (send(client_fd, data.c_str(), data.length(), 0) < 0) {
-                // Клиент отключился
-                break;
-            }
-            
-            event_counter++;
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        }
-        close(client_fd);
-        return;
-    }
-    
-    if (method == "GET") {
-        handleGetRequest(path, response);
-    } else if (method == "POST") {
-        handlePostRequest(path, body, response);
-    } else {
-        response = "HTTP/1.1 405 Method Not Allowed\r\n\r\n";
-    }
-    
-    send(client_fd, response.c_str(), response.length(), 0);
-    close(client_fd);
-}
\ No newline at end of file
@@ -5,50 +5,193 @@
 #include <atomic>
 #include <functional>
 #include <map>
+#include <unordered_map>
+#include <deque>
+#include <vector>
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
 #include <memory>
+#include <cstdint>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <nlohmann/json.hpp>
+#include "HttpRequestParser.hpp"
 
 // Forward declarations
 class NeuralFieldSystem;
 class AgentAuditBridge;
 class ApiHandlers;
+class SimulationLoop;
 
+/**
+ * @struct HttpServerStats
+ * @brief Счётчики соединений и запросов (GET /api/http)
+ */
+struct HttpServerStats {
+    size_t connections = 0;         // открыто сейчас
+    size_t sse_clients = 0;
+    uint64_t accepted = 0;
+    uint64_t rejected = 0;          // отказ по лимиту соединений (503)
+    uint64_t requests = 0;
+    uint64_t keepalive_reused = 0;  // запросы не первые в своём соединении
+    uint64_t pipelined = 0;         // запрос уже лежал в буфере, пока шёл предыдущий
+    uint64_t bad_requests = 0;
+    uint64_t idle_closed = 0;
+
+    nlohmann::json toJson() const {
+        nlohmann::json j;
+        j["connections"] = connections;
+        j["sse_clients"] = sse_clients;
+        j["accepted"] = accepted;
+        j["rejected"] = rejected;
+        j["requests"] = requests;
+        j["keepalive_reused"] = keepalive_reused;
+        j["pipelined"] = pipelined;
+        j["bad_requests"] = bad_requests;
+        j["idle_closed"] = idle_closed;
+        return j;
+    }
+};
+
+// --------------------
+// HTTP/1.1 сервер на epoll
+// --------------------
+/**
+ * @class HttpServer
+ * @brief Один поток событий (epoll, edge-triggered) и постоянный пул обработчиков
+ *
+ * Логика:
+ * - поток событий принимает соединения, читает и пишет неблокирующие сокеты
+ *   и разбирает запросы по мере прихода байт (HttpRequestParser); сокеты
+ *   трогает только он
+ * - разобранный запрос уходит в пул обработчиков; ответ возвращается через
+ *   очередь готовых ответов и eventfd
+ * - keep-alive по умолчанию для HTTP/1.1; конвейерные запросы одного соединения
+ *   обрабатываются строго по очереди, поэтому ответы идут в порядке запросов
+ * - сверх max_connections соединение получает 503 и закрывается;
+ *   простаивающие дольше idle_timeout_ms закрываются
+ * - SSE (/api/events) ведёт поток событий: раз в 500 мс одно событие
+ *   рассылается всем подписчикам
+ */
 class HttpServer {
 public:
+    struct Config {
+        int workers = 4;
+        size_t max_connections = 1024;
+        int idle_timeout_ms = 30000;
+        size_t max_header_bytes = 64 * 1024;  // стартовая строка и заголовки
+        size_t max_body_bytes = 1 << 20;      // тело после снятия chunked
+    };
+
     HttpServer(int port, const std::string& workspace, NeuralFieldSystem* nfs, AgentAuditBridge* auditor);
     ~HttpServer();
-    
+
     bool start();
     void stop();
     bool isRunning() const { return running_.load(); }
-    
+    // Фактический порт (при port == 0 его выбирает система)
+    int port() const { return port_; }
+
     // Установка указателя на глобальный флаг (теперь atomic)
     void setRunningFlag(std::atomic<bool>* flag) { running_flag_ = flag; }
-    
+
+    // Поток-владелец поля (команды изменения поля и метрики очереди)
+    void setSimulationLoop(SimulationLoop* loop);
+
+    // Вызывать до start()
+    void setConfig(const Config& config) { config_ = config; }
+    const Config& config() const { return config_; }
+
+    HttpServerStats stats() const;
+
 private:
+    struct Connection {
+        int fd = -1;
+        uint64_t id = 0;
+        HttpRequestParser parser;       // принятые, ещё не разобранные байты
+        std::string out;                // ответ к отправке
+        size_t out_pos = 0;
+        bool busy = false;              // запрос у обработчиков
+        bool close_after_write = false;
+        bool peer_closed = false;
+        bool sse = false;
+        bool closed = false;            // закрыть в конце итерации цикла
+        uint64_t served = 0;
+        std::chrono::steady_clock::time_point last_active;
+    };
+
+    struct Job {
+        int fd;
+        uint64_t id;
+        HttpRequest request;
+    };
+
+    struct Completion {
+        int fd;
+        uint64_t id;
+        std::string response;
+        bool keep_alive;
+    };
+
     void run();
-    void handleClient(int client_fd);
+    void workerLoop();
+
+    // Поток событий
+    void acceptConnections();
+    void onReadable(Connection& conn);
+    void onWritable(Connection& conn);
+    void processInput(Connection& conn);
+    void drainCompletions();
+    void broadcastEvents();
+    void closeIdle();
+    void markClosed(Connection& conn);
+    void reapClosed();
+    void sendError(Connection& conn, const std::string& status);
+
+    static void finalizeResponse(std::string& response, bool keep_alive);
+
+    std::string handleRequest(const HttpRequest& req);
     std::string loadHtmlFile(const std::string& path);
-    
+
     // Обработчики запросов
-    void handleGetRequest(const std::string& path, std::string& response);
-    void handlePostRequest(const std::string& path, const std::string& body, std::string& response);
-    
+    void handleGetRequest(const HttpRequest& req, std::string& response);
+    void handlePostRequest(const HttpRequest& req, std::string& response);
+
     int port_;
     std::string workspace_;
     int server_fd_;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;                  // eventfd: готовые ответы и остановка
     std::atomic<bool> running_;
     std::thread server_thread_;
-    
+    Config config_;
+
     NeuralFieldSystem* nfs_;
     AgentAuditBridge* auditor_;
     std::unique_ptr<ApiHandlers> apiHandlers_;
-    
+
     std::atomic<bool>* running_flag_ = nullptr;  // Теперь atomic!
     std::mutex data_mutex_;  // Мьютекс для защиты доступа к nfs_ и auditor_
-};
\ No newline at end of file
+
+    // Только поток событий
+    std::unordered_map<int, Connection> connections_;
+    std::vector<int> closed_;
+    uint64_t next_connection_id_ = 0;
+    HttpServerStats loop_stats_;        // публикуется в stats_ раз за итерацию
+
+    // Пул обработчиков
+    std::vector<std::thread> workers_;
+    std::mutex jobs_mutex_;
+    std::condition_variable jobs_cv_;
+    std::deque<Job> jobs_;
+    bool workers_stop_ = false;
+
+    std::mutex done_mutex_;
+    std::vector<Completion> done_;
+
+    mutable std::mutex stats_mutex_;
+    HttpServerStats stats_;
+};